@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <cmath>
+#include "FlatSkeleton.h"
+
+// The kernels below take plain restrict pointers as arguments (GCC ignores 
+// restrict on local variables), such that the compiler knows the arrays do not 
+// overlap and can vectorize the loops.
+
+static void
+midpoints(
+		size_t n,
+		const float* __restrict__ ex, const float* __restrict__ ey, const float* __restrict__ ez,
+		const float* __restrict__ dx, const float* __restrict__ dy, const float* __restrict__ dz,
+		float* __restrict__ mx, float* __restrict__ my, float* __restrict__ mz) {
+
+	for (size_t e = 0; e < n; e++) {
+
+		mx[e] = ex[e] + 0.5f*dx[e];
+		my[e] = ey[e] + 0.5f*dy[e];
+		mz[e] = ez[e] + 0.5f*dz[e];
+	}
+}
+
+static void
+squaredLengths(
+		size_t n,
+		const float* __restrict__ dx, const float* __restrict__ dy, const float* __restrict__ dz,
+		float* __restrict__ l) {
+
+	for (size_t e = 0; e < n; e++)
+		l[e] = dx[e]*dx[e] + dy[e]*dy[e] + dz[e]*dz[e];
+}
+
+static void
+squaredRayDistances(
+		size_t n,
+		float ox, float oy, float oz,
+		float rx, float ry, float rz,
+		const float* __restrict__ ex, const float* __restrict__ ey, const float* __restrict__ ez,
+		const float* __restrict__ dx, const float* __restrict__ dy, const float* __restrict__ dz,
+		float* __restrict__ dist, float* __restrict__ ts) {
+
+	const float a = rx*rx + ry*ry + rz*rz;
+
+	// closest points of two lines, without branches in the loop
+	for (size_t e = 0; e < n; e++) {
+
+		float wx = ox - ex[e];
+		float wy = oy - ey[e];
+		float wz = oz - ez[e];
+
+		float b = rx*dx[e] + ry*dy[e] + rz*dz[e];
+		float c = dx[e]*dx[e] + dy[e]*dy[e] + dz[e]*dz[e];
+		float d = rx*wx + ry*wy + rz*wz;
+		float f = dx[e]*wx + dy[e]*wy + dz[e]*wz;
+
+		// the denominator vanishes for parallel lines, in which case any 
+		// point is closest and the numerators vanish as well -- clamping it 
+		// (instead of branching) keeps the loop vectorizable
+		float denom = std::max(a*c - b*b, 1e-6f*a*c + 1e-30f);
+		float s     = (b*f - c*d)/denom;
+		float t     = (a*f - b*d)/denom;
+
+		float px = wx + s*rx - t*dx[e];
+		float py = wy + s*ry - t*dy[e];
+		float pz = wz + s*rz - t*dz[e];
+
+		dist[e] = px*px + py*py + pz*pz;
+		ts[e]   = t;
+	}
+}
+
+// separate from the kernels above, std::sqrt might set errno and prevents 
+// vectorization (of this loop as well, avoid it where the squared values do)
+static void
+squareRoots(size_t n, float* l) {
+
+	for (size_t i = 0; i < n; i++)
+		l[i] = std::sqrt(l[i]);
+}
+
+
+FlatSkeleton::FlatSkeleton(const Skeleton& skeleton) {
+
+	const Skeleton::Graph& graph = skeleton.graph();
+
+	// the index of each node in the arrays
+	Skeleton::Graph::NodeMap<unsigned int> indices(graph);
+
+	for (Skeleton::Graph::NodeIt n(graph); n != lemon::INVALID; ++n) {
+
+		util::point<float,3> p;
+		skeleton.getRealLocation(skeleton.positions()[n], p);
+
+		indices[n] = _x.size();
+
+		_x.push_back(p.x());
+		_y.push_back(p.y());
+		_z.push_back(p.z());
+		_diameters.push_back(skeleton.diameters()[n]);
+	}
+
+	for (Skeleton::Graph::EdgeIt e(graph); e != lemon::INVALID; ++e) {
+
+		_u.push_back(indices[graph.u(e)]);
+		_v.push_back(indices[graph.v(e)]);
+		_edgeIds.push_back(graph.id(e));
+	}
+
+	size_t numEdges = _u.size();
+
+	_ex.resize(numEdges); _ey.resize(numEdges); _ez.resize(numEdges);
+	_dx.resize(numEdges); _dy.resize(numEdges); _dz.resize(numEdges);
+
+	for (size_t e = 0; e < numEdges; e++) {
+
+		_ex[e] = _x[_u[e]];
+		_ey[e] = _y[_u[e]];
+		_ez[e] = _z[_u[e]];
+		_dx[e] = _x[_v[e]] - _ex[e];
+		_dy[e] = _y[_v[e]] - _ey[e];
+		_dz[e] = _z[_v[e]] - _ez[e];
+	}
+
+	// count the neighbors of each node, then fill the rows
+	_offsets.assign(numNodes() + 1, 0);
+	for (size_t e = 0; e < numEdges; e++) {
+
+		_offsets[_u[e] + 1]++;
+		_offsets[_v[e] + 1]++;
+	}
+
+	for (size_t i = 0; i < numNodes(); i++)
+		_offsets[i + 1] += _offsets[i];
+
+	_neighbors.resize(2*numEdges);
+	_incidentEdges.resize(2*numEdges);
+
+	std::vector<size_t> next(_offsets.begin(), _offsets.end() - 1);
+
+	for (size_t e = 0; e < numEdges; e++) {
+
+		_neighbors[next[_u[e]]]       = _v[e];
+		_incidentEdges[next[_u[e]]++] = e;
+		_neighbors[next[_v[e]]]       = _u[e];
+		_incidentEdges[next[_v[e]]++] = e;
+	}
+}
+
+void
+FlatSkeleton::getMidpoints(std::vector<float>& x, std::vector<float>& y, std::vector<float>& z) const {
+
+	size_t n = numEdges();
+
+	x.resize(n);
+	y.resize(n);
+	z.resize(n);
+
+	midpoints(
+			n,
+			_ex.data(), _ey.data(), _ez.data(),
+			_dx.data(), _dy.data(), _dz.data(),
+			x.data(), y.data(), z.data());
+}
+
+void
+FlatSkeleton::getLengths(std::vector<float>& lengths) const {
+
+	size_t n = numEdges();
+
+	lengths.resize(n);
+
+	squaredLengths(n, _dx.data(), _dy.data(), _dz.data(), lengths.data());
+	squareRoots(n, lengths.data());
+}
+
+void
+FlatSkeleton::getSquaredRayDistances(const util::ray<float,3>& ray, std::vector<float>& distances, std::vector<float>& t) const {
+
+	size_t n = numEdges();
+
+	distances.resize(n);
+	t.resize(n);
+
+	squaredRayDistances(
+			n,
+			ray.position().x(), ray.position().y(), ray.position().z(),
+			ray.direction().x(), ray.direction().y(), ray.direction().z(),
+			_ex.data(), _ey.data(), _ez.data(),
+			_dx.data(), _dy.data(), _dz.data(),
+			distances.data(), t.data());
+}
@@ -0,0 +1,113 @@
+#ifndef TOOLS_ANALYSIS_FLAT_SKELETON_H__
+#define TOOLS_ANALYSIS_FLAT_SKELETON_H__
+
+#include <vector>
+#include <imageprocessing/Skeleton.h>
+#include <util/point.hpp>
+#include <util/ray.hpp>
+
+/**
+ * An immutable copy of a skeleton with node coordinates in world units, kept 
+ * in contiguous arrays. Created once from a Skeleton, such that loops over 
+ * all nodes or edges do not have to walk the graph and convert positions.
+ *
+ * Besides the nodes and the edges as index pairs, every edge is stored as 
+ * start point and direction, and the neighbors of the nodes are stored in 
+ * compressed rows. The functions computing values for all edges at once work 
+ * on these arrays only, such that the compiler can vectorize them.
+ */
+class FlatSkeleton {
+
+public:
+
+	FlatSkeleton(const Skeleton& skeleton);
+
+	size_t numNodes() const { return _x.size(); }
+
+	size_t numEdges() const { return _u.size(); }
+
+	/**
+	 * The coordinates of the nodes in world units.
+	 */
+	const std::vector<float>& x() const { return _x; }
+	const std::vector<float>& y() const { return _y; }
+	const std::vector<float>& z() const { return _z; }
+
+	const std::vector<float>& diameters() const { return _diameters; }
+
+	/**
+	 * The nodes of the edges, as indices into the node arrays.
+	 */
+	const std::vector<unsigned int>& u() const { return _u; }
+	const std::vector<unsigned int>& v() const { return _v; }
+
+	/**
+	 * The ids of the edges in the graph of the skeleton.
+	 */
+	const std::vector<int>& edgeIds() const { return _edgeIds; }
+
+	/**
+	 * The number of neighbors of a node.
+	 */
+	unsigned int degree(size_t node) const { return _offsets[node + 1] - _offsets[node]; }
+
+	/**
+	 * The neighbors of a node are neighbors()[i] for i in [beginNeighbors(), 
+	 * endNeighbors()), connected by the edges incidentEdges()[i].
+	 */
+	size_t beginNeighbors(size_t node) const { return _offsets[node]; }
+	size_t endNeighbors(size_t node) const { return _offsets[node + 1]; }
+	const std::vector<unsigned int>& neighbors() const { return _neighbors; }
+	const std::vector<unsigned int>& incidentEdges() const { return _incidentEdges; }
+
+	util::point<float,3> getNode(size_t i) const { return util::point<float,3>(_x[i], _y[i], _z[i]); }
+
+	util::point<float,3> getMidpoint(size_t edge) const {
+
+		return util::point<float,3>(
+				_ex[edge] + 0.5f*_dx[edge],
+				_ey[edge] + 0.5f*_dy[edge],
+				_ez[edge] + 0.5f*_dz[edge]);
+	}
+
+	/**
+	 * The midpoints of all edges.
+	 */
+	void getMidpoints(std::vector<float>& x, std::vector<float>& y, std::vector<float>& z) const;
+
+	/**
+	 * The lengths of all edges.
+	 */
+	void getLengths(std::vector<float>& lengths) const;
+
+	/**
+	 * The squared distances of the line through each edge to the line of a 
+	 * ray, and the location of the closest point on each edge, such that it 
+	 * lies on the edge for t in [0,1]. Squared, such that finding the closest 
+	 * edge does not need a square root per edge.
+	 */
+	void getSquaredRayDistances(const util::ray<float,3>& ray, std::vector<float>& distances, std::vector<float>& t) const;
+
+private:
+
+	std::vector<float> _x;
+	std::vector<float> _y;
+	std::vector<float> _z;
+	std::vector<float> _diameters;
+
+	std::vector<unsigned int> _u;
+	std::vector<unsigned int> _v;
+	std::vector<int>          _edgeIds;
+
+	// start and direction of the edges
+	std::vector<float> _ex, _ey, _ez;
+	std::vector<float> _dx, _dy, _dz;
+
+	// the adjacency in compressed rows
+	std::vector<size_t>       _offsets;
+	std::vector<unsigned int> _neighbors;
+	std::vector<unsigned int> _incidentEdges;
+};
+
+#endif // TOOLS_ANALYSIS_FLAT_SKELETON_H__
+
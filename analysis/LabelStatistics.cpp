@@ -0,0 +1,234 @@
+#include <algorithm>
+#include <functional>
+#include <util/Logger.h>
+#include <io/ThreadPool.h>
+#include "LabelStatistics.h"
+
+logger::LogChannel labelstatisticslog("labelstatisticslog", "[LabelStatistics] ");
+
+LabelStatistics::LabelStatistics(const ExplicitVolume<uint64_t>& labels, unsigned int numThreads) :
+	_resolution(labels.getResolution()),
+	_offset(labels.getOffset()) {
+
+	unsigned int depth = labels.getDiscreteBoundingBox().depth();
+
+	if (depth == 0)
+		return;
+
+	ThreadPool pool(numThreads);
+
+	// one slab of sections and one hash table per thread, merged at the end
+	unsigned int numSlabs  = std::min(depth, pool.size());
+	unsigned int slabDepth = (depth + numSlabs - 1)/numSlabs;
+
+	std::vector<Labels> partial(numSlabs);
+
+	for (unsigned int i = 0; i < numSlabs; i++)
+		pool.schedule([this, &labels, &partial, i, slabDepth, depth]() {
+
+			accumulate(
+					labels,
+					i*slabDepth,
+					std::min(depth, (i + 1)*slabDepth),
+					partial[i]);
+		});
+
+	pool.wait();
+
+	_labels.swap(partial[0]);
+	for (unsigned int i = 1; i < numSlabs; i++)
+		merge(partial[i], _labels);
+
+	LOG_DEBUG(labelstatisticslog) << "found " << _labels.size() << " labels" << std::endl;
+}
+
+std::vector<uint64_t>
+LabelStatistics::getIds() const {
+
+	std::vector<uint64_t> ids;
+	ids.reserve(_labels.size());
+
+	for (const auto& p : _labels)
+		ids.push_back(p.first);
+
+	std::sort(ids.begin(), ids.end());
+
+	return ids;
+}
+
+std::vector<uint64_t>
+LabelStatistics::getLargest(size_t k) const {
+
+	std::vector<std::pair<size_t, uint64_t>> sizes;
+	sizes.reserve(_labels.size());
+
+	for (const auto& p : _labels)
+		sizes.push_back(std::make_pair(p.second.size, p.first));
+
+	k = std::min(k, sizes.size());
+
+	std::partial_sort(
+			sizes.begin(),
+			sizes.begin() + k,
+			sizes.end(),
+			std::greater<std::pair<size_t, uint64_t>>());
+
+	std::vector<uint64_t> ids;
+	for (size_t i = 0; i < k; i++)
+		ids.push_back(sizes[i].second);
+
+	return ids;
+}
+
+std::vector<uint64_t>
+LabelStatistics::getIntersecting(const util::box<float,3>& region) const {
+
+	std::vector<uint64_t> ids;
+
+	for (const auto& p : _labels) {
+
+		util::box<float,3> b = getBoundingBox(p.first);
+
+		if (b.max().x() > region.min().x() && b.min().x() < region.max().x() &&
+		    b.max().y() > region.min().y() && b.min().y() < region.max().y() &&
+		    b.max().z() > region.min().z() && b.min().z() < region.max().z())
+			ids.push_back(p.first);
+	}
+
+	std::sort(ids.begin(), ids.end());
+
+	return ids;
+}
+
+util::box<float,3>
+LabelStatistics::getBoundingBox(uint64_t id) const {
+
+	const Label& label = _labels.at(id);
+
+	return util::box<float,3>(
+			util::point<float,3>(
+					_offset.x() + label.begin[0]*_resolution.x(),
+					_offset.y() + label.begin[1]*_resolution.y(),
+					_offset.z() + label.begin[2]*_resolution.z()),
+			util::point<float,3>(
+					_offset.x() + label.end[0]*_resolution.x(),
+					_offset.y() + label.end[1]*_resolution.y(),
+					_offset.z() + label.end[2]*_resolution.z()));
+}
+
+util::point<float,3>
+LabelStatistics::getCentroid(uint64_t id) const {
+
+	const Label& label = _labels.at(id);
+
+	// centers of voxels are at half the resolution
+	return util::point<float,3>(
+			_offset.x() + (label.sum[0]/label.size + 0.5)*_resolution.x(),
+			_offset.y() + (label.sum[1]/label.size + 0.5)*_resolution.y(),
+			_offset.z() + (label.sum[2]/label.size + 0.5)*_resolution.z());
+}
+
+void
+LabelStatistics::accumulate(
+		const ExplicitVolume<uint64_t>& labels,
+		unsigned int beginZ,
+		unsigned int endZ,
+		Labels& statistics) {
+
+	unsigned int width  = labels.getDiscreteBoundingBox().width();
+	unsigned int height = labels.getDiscreteBoundingBox().height();
+
+	const uint64_t* data = labels.data().data();
+
+	// the label of the previous run, to avoid hash lookups for the same label
+	uint64_t previous = 0;
+	Label*   label    = 0;
+
+	for (unsigned int z = beginZ; z < endZ; z++)
+		for (unsigned int y = 0; y < height; y++) {
+
+			const uint64_t* row = data + ((size_t)z*height + y)*width;
+
+			// process the row in runs of equal labels, such that the inner
+			// loop is a tight comparison scan and the statistics are updated
+			// once per run
+			unsigned int x = 0;
+			while (x < width) {
+
+				uint64_t id = row[x];
+
+				unsigned int end = x + 1;
+				while (end < width && row[end] == id)
+					end++;
+
+				if (id != 0) {
+
+					if (id != previous) {
+
+						auto i = statistics.find(id);
+
+						if (i == statistics.end()) {
+
+							Label& l = statistics[id];
+							l.size = 0;
+							l.begin[0] = x; l.begin[1] = y; l.begin[2] = z;
+							l.end[0] = end; l.end[1] = y + 1; l.end[2] = z + 1;
+							l.sum[0] = l.sum[1] = l.sum[2] = 0;
+
+							label = &l;
+
+						} else {
+
+							label = &i->second;
+						}
+
+						previous = id;
+					}
+
+					size_t length = end - x;
+
+					label->size += length;
+					label->begin[0] = std::min(label->begin[0], x);
+					label->begin[1] = std::min(label->begin[1], y);
+					label->begin[2] = std::min(label->begin[2], z);
+					label->end[0]   = std::max(label->end[0], end);
+					label->end[1]   = std::max(label->end[1], y + 1);
+					label->end[2]   = std::max(label->end[2], z + 1);
+
+					// sum of x, ..., end - 1
+					label->sum[0] += 0.5*length*(x + end - 1);
+					label->sum[1] += (double)length*y;
+					label->sum[2] += (double)length*z;
+				}
+
+				x = end;
+			}
+		}
+}
+
+void
+LabelStatistics::merge(const Labels& from, Labels& to) {
+
+	for (const auto& p : from) {
+
+		auto i = to.find(p.first);
+
+		if (i == to.end()) {
+
+			to.insert(p);
+			continue;
+		}
+
+		Label&       a = i->second;
+		const Label& b = p.second;
+
+		a.size += b.size;
+
+		for (int d = 0; d < 3; d++) {
+
+			a.begin[d] = std::min(a.begin[d], b.begin[d]);
+			a.end[d]   = std::max(a.end[d], b.end[d]);
+			a.sum[d]  += b.sum[d];
+		}
+	}
+}
@@ -0,0 +1,97 @@
+#ifndef TOOLS_ANALYSIS_LABEL_STATISTICS_H__
+#define TOOLS_ANALYSIS_LABEL_STATISTICS_H__
+
+#include <unordered_map>
+#include <vector>
+#include <imageprocessing/ExplicitVolume.h>
+#include <util/box.hpp>
+#include <util/point.hpp>
+
+/**
+ * Size, bounding box, and centroid of every label in a label volume, computed
+ * in a single parallel pass. The background label 0 is not considered.
+ */
+class LabelStatistics {
+
+public:
+
+	/**
+	 * Statistics of a single label, in voxels.
+	 */
+	struct Label {
+
+		// number of voxels
+		size_t size;
+
+		// bounding box, begin inclusive, end exclusive
+		unsigned int begin[3];
+		unsigned int end[3];
+
+		// sum of the voxel coordinates, divide by size for the centroid
+		double sum[3];
+	};
+
+	/**
+	 * Compute the statistics of the given label volume.
+	 *
+	 * @param numThreads
+	 *              The number of threads to use, 0 for one per core.
+	 */
+	LabelStatistics(const ExplicitVolume<uint64_t>& labels, unsigned int numThreads = 0);
+
+	/**
+	 * The number of labels, excluding the background.
+	 */
+	size_t size() const { return _labels.size(); }
+
+	bool contains(uint64_t id) const { return _labels.count(id); }
+
+	const Label& operator[](uint64_t id) const { return _labels.at(id); }
+
+	/**
+	 * All label ids, in increasing order.
+	 */
+	std::vector<uint64_t> getIds() const;
+
+	/**
+	 * The ids of the k largest labels, largest first.
+	 */
+	std::vector<uint64_t> getLargest(size_t k) const;
+
+	/**
+	 * The ids of all labels whose bounding box intersects the given region in
+	 * world units.
+	 */
+	std::vector<uint64_t> getIntersecting(const util::box<float,3>& region) const;
+
+	/**
+	 * The bounding box of a label in world units.
+	 */
+	util::box<float,3> getBoundingBox(uint64_t id) const;
+
+	/**
+	 * The centroid of a label in world units.
+	 */
+	util::point<float,3> getCentroid(uint64_t id) const;
+
+private:
+
+	typedef std::unordered_map<uint64_t, Label> Labels;
+
+	// accumulate the statistics of the sections [beginZ, endZ)
+	void accumulate(
+			const ExplicitVolume<uint64_t>& labels,
+			unsigned int beginZ,
+			unsigned int endZ,
+			Labels& statistics);
+
+	static void merge(const Labels& from, Labels& to);
+
+	Labels _labels;
+
+	util::point<float,3> _resolution;
+	util::point<float,3> _offset;
+};
+
+#endif // TOOLS_ANALYSIS_LABEL_STATISTICS_H__
+
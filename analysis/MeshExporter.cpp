@@ -0,0 +1,69 @@
+#include <atomic>
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+#include <util/Logger.h>
+#include <io/ThreadPool.h>
+#include "MeshExporter.h"
+#include "SurfaceNets.h"
+
+logger::LogChannel meshexporterlog("meshexporterlog", "[MeshExporter] ");
+
+MeshExporter::MeshExporter(
+		std::shared_ptr<ExplicitVolume<uint64_t>> labels,
+		std::shared_ptr<LabelStatistics> statistics,
+		const std::string& directory,
+		MeshFormat format,
+		unsigned int numThreads) :
+	_labels(labels),
+	_statistics(statistics),
+	_directory(directory),
+	_format(format),
+	_numThreads(numThreads) {}
+
+size_t
+MeshExporter::exportMeshes(const std::vector<uint64_t>& ids) {
+
+	boost::filesystem::create_directories(_directory);
+
+	SurfaceNets surfaceNets(*_labels, *_statistics);
+
+	std::atomic<size_t> numWritten(0);
+
+	{
+		ThreadPool pool(_numThreads);
+
+		for (uint64_t id : ids) {
+
+			if (!_statistics->contains(id)) {
+
+				LOG_USER(meshexporterlog) << "label " << id << " does not exist, skipping it" << std::endl;
+				continue;
+			}
+
+			pool.schedule([this, id, &surfaceNets, &numWritten]() {
+
+				TriangleMesh mesh;
+				surfaceNets.extract(id, mesh);
+
+				std::string filename =
+						(boost::filesystem::path(_directory) /
+						(boost::lexical_cast<std::string>(id) + getMeshExtension(_format))).native();
+
+				if (_format == MeshGlb)
+					writeGlb(mesh, filename, boost::lexical_cast<std::string>(id));
+				else
+					writeMesh(mesh, filename, _format);
+
+				numWritten++;
+
+				LOG_DEBUG(meshexporterlog) << "wrote " << filename << std::endl;
+			});
+		}
+
+		pool.wait();
+	}
+
+	LOG_USER(meshexporterlog) << "wrote " << numWritten << " meshes to " << _directory << std::endl;
+
+	return numWritten;
+}
@@ -0,0 +1,49 @@
+#ifndef TOOLS_ANALYSIS_MESH_EXPORTER_H__
+#define TOOLS_ANALYSIS_MESH_EXPORTER_H__
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <imageprocessing/ExplicitVolume.h>
+#include <io/meshes.h>
+#include "LabelStatistics.h"
+
+/**
+ * Extracts the meshes of labels in parallel and writes each of them to
+ * <directory>/<id>.<format> as soon as it is done.
+ */
+class MeshExporter {
+
+public:
+
+	/**
+	 * @param numThreads
+	 *              The number of threads to use, 0 for one per core.
+	 */
+	MeshExporter(
+			std::shared_ptr<ExplicitVolume<uint64_t>> labels,
+			std::shared_ptr<LabelStatistics> statistics,
+			const std::string& directory,
+			MeshFormat format,
+			unsigned int numThreads = 0);
+
+	/**
+	 * Export the meshes of the given labels. Returns the number of meshes
+	 * written, labels that do not exist are skipped.
+	 */
+	size_t exportMeshes(const std::vector<uint64_t>& ids);
+
+	const std::string& getDirectory() const { return _directory; }
+
+private:
+
+	std::shared_ptr<ExplicitVolume<uint64_t>> _labels;
+	std::shared_ptr<LabelStatistics>          _statistics;
+
+	std::string  _directory;
+	MeshFormat   _format;
+	unsigned int _numThreads;
+};
+
+#endif // TOOLS_ANALYSIS_MESH_EXPORTER_H__
+
@@ -0,0 +1,246 @@
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <boost/filesystem.hpp>
+#include <util/Logger.h>
+#include <io/ThreadPool.h>
+#include "RegionAdjacencyGraph.h"
+
+logger::LogChannel regionadjacencygraphlog("regionadjacencygraphlog", "[RegionAdjacencyGraph] ");
+
+namespace {
+
+struct EdgeHash {
+
+	size_t operator()(const std::pair<uint64_t, uint64_t>& e) const {
+
+		return std::hash<uint64_t>()(e.first*0x9e3779b97f4a7c15ull ^ e.second);
+	}
+};
+
+typedef std::unordered_map<std::pair<uint64_t, uint64_t>, size_t, EdgeHash> ContactAreas;
+
+inline void addContact(uint64_t a, uint64_t b, ContactAreas& areas) {
+
+	if (a == b || a == 0 || b == 0)
+		return;
+
+	if (a > b)
+		std::swap(a, b);
+
+	areas[std::make_pair(a, b)]++;
+}
+
+} // namespace
+
+void
+RegionAdjacencyGraph::extract(const ExplicitVolume<uint64_t>& labels, unsigned int numThreads) {
+
+	_edges.clear();
+	_neighbors.clear();
+
+	unsigned int width  = labels.getDiscreteBoundingBox().width();
+	unsigned int height = labels.getDiscreteBoundingBox().height();
+	unsigned int depth  = labels.getDiscreteBoundingBox().depth();
+
+	if (depth == 0)
+		return;
+
+	const uint64_t* data = labels.data().data();
+
+	ThreadPool pool(numThreads);
+
+	// one slab of sections and one hash table per thread, merged at the end
+	unsigned int numSlabs  = std::min(depth, pool.size());
+	unsigned int slabDepth = (depth + numSlabs - 1)/numSlabs;
+
+	std::vector<ContactAreas> partial(numSlabs);
+
+	for (unsigned int i = 0; i < numSlabs; i++)
+		pool.schedule([&partial, data, width, height, depth, slabDepth, i]() {
+
+			ContactAreas& areas = partial[i];
+
+			unsigned int beginZ = i*slabDepth;
+			unsigned int endZ   = std::min(depth, (i + 1)*slabDepth);
+
+			size_t sectionSize = (size_t)width*height;
+
+			for (unsigned int z = beginZ; z < endZ; z++)
+				for (unsigned int y = 0; y < height; y++) {
+
+					const uint64_t* row = data + z*sectionSize + (size_t)y*width;
+
+					for (unsigned int x = 0; x < width; x++) {
+
+						uint64_t label = row[x];
+
+						// every face is counted once, by the voxel before it;
+						// faces between slabs belong to the slab of the lower
+						// section
+						if (x + 1 < width)
+							addContact(label, row[x + 1], areas);
+						if (y + 1 < height)
+							addContact(label, row[x + width], areas);
+						if (z + 1 < depth)
+							addContact(label, row[x + sectionSize], areas);
+					}
+				}
+		});
+
+	pool.wait();
+
+	for (unsigned int i = 1; i < numSlabs; i++)
+		for (const auto& p : partial[i])
+			partial[0][p.first] += p.second;
+
+	_edges.reserve(partial[0].size());
+	for (const auto& p : partial[0]) {
+
+		Edge edge;
+		edge.u           = p.first.first;
+		edge.v           = p.first.second;
+		edge.contactArea = p.second;
+
+		_edges.push_back(edge);
+	}
+
+	index();
+
+	LOG_DEBUG(regionadjacencygraphlog) << "found " << _edges.size() << " edges" << std::endl;
+}
+
+bool
+RegionAdjacencyGraph::read(const std::string& filename, const std::string& key) {
+
+	std::ifstream in(filename.c_str());
+
+	if (!in.good())
+		return false;
+
+	std::string header;
+	std::getline(in, header);
+
+	if (header != key) {
+
+		LOG_DEBUG(regionadjacencygraphlog) << filename << " is outdated" << std::endl;
+		return false;
+	}
+
+	std::vector<Edge> edges;
+	std::string       line;
+
+	while (std::getline(in, line)) {
+
+		// every line ends with a newline, the last one was cut off
+		if (in.eof()) {
+
+			LOG_ERROR(regionadjacencygraphlog) << filename << " is truncated" << std::endl;
+			return false;
+		}
+
+		std::istringstream values(line);
+
+		Edge edge;
+		if (!(values >> edge.u >> edge.v >> edge.contactArea) || !(values >> std::ws).eof()) {
+
+			LOG_ERROR(regionadjacencygraphlog) << filename << " contains an invalid edge '" << line << "'" << std::endl;
+			return false;
+		}
+
+		edges.push_back(edge);
+	}
+
+	if (!in.eof()) {
+
+		LOG_ERROR(regionadjacencygraphlog) << "can not read " << filename << std::endl;
+		return false;
+	}
+
+	_edges.swap(edges);
+	_neighbors.clear();
+
+	index();
+
+	LOG_DEBUG(regionadjacencygraphlog) << "read " << _edges.size() << " edges from " << filename << std::endl;
+
+	return true;
+}
+
+void
+RegionAdjacencyGraph::write(const std::string& filename, const std::string& key) const {
+
+	// write to a temporary file first, such that an interrupted or failed
+	// write does not leave a truncated graph behind
+	boost::filesystem::path temporary =
+			boost::filesystem::path(filename).parent_path()/
+			boost::filesystem::unique_path("%%%%-%%%%-%%%%-%%%%.tmp.rag");
+
+	{
+		std::ofstream out(temporary.native().c_str());
+
+		out << key << std::endl;
+
+		for (const Edge& edge : _edges)
+			out << edge.u << " " << edge.v << " " << edge.contactArea << "\n";
+
+		out.close();
+
+		if (!out.good()) {
+
+			LOG_ERROR(regionadjacencygraphlog) << "can not write " << temporary.native() << std::endl;
+
+			boost::system::error_code error;
+			boost::filesystem::remove(temporary, error);
+			return;
+		}
+	}
+
+	boost::system::error_code error;
+	boost::filesystem::rename(temporary, filename, error);
+
+	if (error) {
+
+		LOG_ERROR(regionadjacencygraphlog) << "can not write " << filename << ": " << error.message() << std::endl;
+		boost::filesystem::remove(temporary, error);
+	}
+}
+
+const std::vector<RegionAdjacencyGraph::Neighbor>&
+RegionAdjacencyGraph::getNeighbors(uint64_t id) const {
+
+	static const std::vector<Neighbor> none;
+
+	auto i = _neighbors.find(id);
+	if (i == _neighbors.end())
+		return none;
+
+	return i->second;
+}
+
+void
+RegionAdjacencyGraph::index() {
+
+	std::sort(_edges.begin(), _edges.end(), [](const Edge& a, const Edge& b) {
+
+		return a.u < b.u || (a.u == b.u && a.v < b.v);
+	});
+
+	for (const Edge& edge : _edges) {
+
+		Neighbor n;
+		n.contactArea = edge.contactArea;
+
+		n.id = edge.v;
+		_neighbors[edge.u].push_back(n);
+
+		n.id = edge.u;
+		_neighbors[edge.v].push_back(n);
+	}
+
+	for (auto& p : _neighbors)
+		std::sort(p.second.begin(), p.second.end(), [](const Neighbor& a, const Neighbor& b) {
+
+			return a.contactArea > b.contactArea;
+		});
+}
@@ -0,0 +1,74 @@
+#ifndef TOOLS_ANALYSIS_REGION_ADJACENCY_GRAPH_H__
+#define TOOLS_ANALYSIS_REGION_ADJACENCY_GRAPH_H__
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <imageprocessing/ExplicitVolume.h>
+
+/**
+ * The adjacency of the labels of a label volume. Two labels are adjacent, if
+ * they have voxels sharing a face. Every edge stores the number of those
+ * faces as contact area. The background label 0 is not considered.
+ */
+class RegionAdjacencyGraph {
+
+public:
+
+	struct Edge {
+
+		uint64_t u;
+		uint64_t v;
+		size_t   contactArea;
+	};
+
+	struct Neighbor {
+
+		uint64_t id;
+		size_t   contactArea;
+	};
+
+	/**
+	 * Extract the graph from a label volume in a parallel pass over slabs of
+	 * sections.
+	 *
+	 * @param numThreads
+	 *              The number of threads to use, 0 for one per core.
+	 */
+	void extract(const ExplicitVolume<uint64_t>& labels, unsigned int numThreads = 0);
+
+	/**
+	 * Read the graph from a file written by write(). Returns false, if the
+	 * file does not exist, was written with a different key, or is truncated
+	 * or otherwise invalid.
+	 */
+	bool read(const std::string& filename, const std::string& key);
+
+	/**
+	 * Write the graph to a file. The key identifies the label volume the
+	 * graph was extracted from, such that outdated files can be detected.
+	 * The file is replaced only once it was written completely.
+	 */
+	void write(const std::string& filename, const std::string& key) const;
+
+	size_t numEdges() const { return _edges.size(); }
+
+	const std::vector<Edge>& getEdges() const { return _edges; }
+
+	/**
+	 * The neighbors of a label, largest contact area first.
+	 */
+	const std::vector<Neighbor>& getNeighbors(uint64_t id) const;
+
+private:
+
+	// sort edges and create the neighbor lists
+	void index();
+
+	std::vector<Edge> _edges;
+
+	std::unordered_map<uint64_t, std::vector<Neighbor>> _neighbors;
+};
+
+#endif // TOOLS_ANALYSIS_REGION_ADJACENCY_GRAPH_H__
+
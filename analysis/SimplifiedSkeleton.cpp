@@ -0,0 +1,215 @@
+#include <cmath>
+#include <util/Logger.h>
+#include "SimplifiedSkeleton.h"
+
+logger::LogChannel simplifiedskeletonlog("simplifiedskeletonlog", "[SimplifiedSkeleton] ");
+
+namespace {
+
+// squared distance of p to the segment from a to b
+float
+segmentDistance2(
+		const util::point<float,3>& p,
+		const util::point<float,3>& a,
+		const util::point<float,3>& b) {
+
+	util::point<float,3> ab = b - a;
+	util::point<float,3> ap = p - a;
+
+	float length2 = ab.x()*ab.x() + ab.y()*ab.y() + ab.z()*ab.z();
+	float t = 0;
+	if (length2 > 0)
+		t = std::max(0.0f, std::min(1.0f, (ap.x()*ab.x() + ap.y()*ab.y() + ap.z()*ab.z())/length2));
+
+	float dx = ap.x() - t*ab.x();
+	float dy = ap.y() - t*ab.y();
+	float dz = ap.z() - t*ab.z();
+
+	return dx*dx + dy*dy + dz*dz;
+}
+
+} // namespace
+
+SimplifiedSkeleton::SimplifiedSkeleton(const FlatSkeleton& skeleton, unsigned int maxLevels) {
+
+	extractChains(skeleton);
+
+	// level 0 are all edges
+	_levels.resize(1);
+	_tolerances.push_back(0);
+
+	double totalLength = 0;
+	size_t numEdges    = 0;
+
+	util::point<float,3> min(0, 0, 0);
+	util::point<float,3> max(0, 0, 0);
+
+	if (!_chains.empty())
+		min = max = _chains[0][0];
+
+	for (const Chain& chain : _chains)
+		for (const util::point<float,3>& p : chain) {
+
+			min = util::point<float,3>(
+					std::min(min.x(), p.x()),
+					std::min(min.y(), p.y()),
+					std::min(min.z(), p.z()));
+			max = util::point<float,3>(
+					std::max(max.x(), p.x()),
+					std::max(max.y(), p.y()),
+					std::max(max.z(), p.z()));
+		}
+
+	_boundingBox = util::box<float,3>(min, max);
+
+	for (const Chain& chain : _chains)
+		for (size_t i = 0; i + 1 < chain.size(); i++) {
+
+			_levels[0].push_back(chain[i]);
+			_levels[0].push_back(chain[i + 1]);
+
+			util::point<float,3> d = chain[i + 1] - chain[i];
+			totalLength += std::sqrt(d.x()*d.x() + d.y()*d.y() + d.z()*d.z());
+			numEdges++;
+		}
+
+	if (numEdges == 0)
+		return;
+
+	// start with half the mean edge length and double the tolerance for every
+	// level, until the tolerance exceeds the length of the skeleton
+	float tolerance = 0.5*totalLength/numEdges;
+
+	while (_levels.size() < maxLevels && tolerance < totalLength) {
+
+		std::vector<util::point<float,3>> segments;
+		for (const Chain& chain : _chains)
+			simplify(chain, tolerance, segments);
+
+		if (segments.size() < _levels.back().size()) {
+
+			_levels.push_back(std::move(segments));
+			_tolerances.push_back(tolerance);
+		}
+
+		tolerance *= 2;
+	}
+
+	LOG_DEBUG(simplifiedskeletonlog)
+			<< "created " << _levels.size() << " levels, from "
+			<< _levels.front().size()/2 << " to " << _levels.back().size()/2
+			<< " segments" << std::endl;
+}
+
+unsigned int
+SimplifiedSkeleton::getLevel(float tolerance) const {
+
+	unsigned int level = 0;
+	while (level + 1 < _levels.size() && _tolerances[level + 1] <= tolerance)
+		level++;
+
+	return level;
+}
+
+void
+SimplifiedSkeleton::extractChains(const FlatSkeleton& skeleton) {
+
+	std::vector<bool> visited(skeleton.numEdges(), false);
+
+	// follow the chain starting with edge e at node start, until a node with
+	// degree other than 2 or a visited edge is reached
+	auto followChain = [&](unsigned int start, unsigned int e) {
+
+		Chain chain;
+		chain.push_back(skeleton.getNode(start));
+
+		unsigned int n = start;
+
+		while (true) {
+
+			visited[e] = true;
+			n = (skeleton.u()[e] == n ? skeleton.v()[e] : skeleton.u()[e]);
+			chain.push_back(skeleton.getNode(n));
+
+			if (skeleton.degree(n) != 2)
+				break;
+
+			bool found = false;
+			for (size_t i = skeleton.beginNeighbors(n); i < skeleton.endNeighbors(n); i++)
+				if (!visited[skeleton.incidentEdges()[i]]) {
+
+					e     = skeleton.incidentEdges()[i];
+					found = true;
+				}
+
+			// closed a cycle
+			if (!found)
+				break;
+		}
+
+		_chains.push_back(std::move(chain));
+	};
+
+	for (size_t n = 0; n < skeleton.numNodes(); n++)
+		if (skeleton.degree(n) != 2)
+			for (size_t i = skeleton.beginNeighbors(n); i < skeleton.endNeighbors(n); i++)
+				if (!visited[skeleton.incidentEdges()[i]])
+					followChain(n, skeleton.incidentEdges()[i]);
+
+	// the remaining edges form cycles of degree-2 nodes
+	for (size_t e = 0; e < skeleton.numEdges(); e++)
+		if (!visited[e])
+			followChain(skeleton.u()[e], e);
+}
+
+void
+SimplifiedSkeleton::simplify(const Chain& chain, float tolerance, std::vector<util::point<float,3>>& segments) {
+
+	float tolerance2 = tolerance*tolerance;
+
+	// Douglas-Peucker without recursion, the stack contains ranges of the
+	// chain to simplify, the first one on top
+	std::vector<std::pair<size_t, size_t>> ranges;
+	ranges.push_back(std::make_pair(0, chain.size() - 1));
+
+	while (!ranges.empty()) {
+
+		size_t begin = ranges.back().first;
+		size_t end   = ranges.back().second;
+		ranges.pop_back();
+
+		float  maxDistance2 = 0;
+		size_t farthest     = begin;
+
+		for (size_t i = begin + 1; i < end; i++) {
+
+			float d = segmentDistance2(chain[i], chain[begin], chain[end]);
+			if (d > maxDistance2) {
+
+				maxDistance2 = d;
+				farthest     = i;
+			}
+		}
+
+		// cycles start and end at the same point, always split them
+		bool closed =
+				begin == 0 && end == chain.size() - 1 && end > 1 &&
+				chain[begin].x() == chain[end].x() &&
+				chain[begin].y() == chain[end].y() &&
+				chain[begin].z() == chain[end].z();
+
+		if (closed && farthest == begin)
+			farthest = end/2;
+
+		if (maxDistance2 > tolerance2 || closed) {
+
+			ranges.push_back(std::make_pair(farthest, end));
+			ranges.push_back(std::make_pair(begin, farthest));
+
+		} else {
+
+			segments.push_back(chain[begin]);
+			segments.push_back(chain[end]);
+		}
+	}
+}
@@ -0,0 +1,69 @@
+#ifndef TOOLS_ANALYSIS_SIMPLIFIED_SKELETON_H__
+#define TOOLS_ANALYSIS_SIMPLIFIED_SKELETON_H__
+
+#include <vector>
+#include <util/box.hpp>
+#include <util/point.hpp>
+#include "FlatSkeleton.h"
+
+/**
+ * Levels of detail of a skeleton as line segments in world units. Chains of
+ * degree-2 nodes are simplified with increasing tolerance, keeping branch
+ * points and endpoints. Level 0 contains all edges of the skeleton, level i >
+ * 0 deviates at most getTolerance(i) from it.
+ */
+class SimplifiedSkeleton {
+
+public:
+
+	/**
+	 * Create the levels of detail of a skeleton.
+	 *
+	 * @param maxLevels
+	 *              The maximal number of levels. Fewer levels are created, if
+	 *              a coarser tolerance does not remove any more segments.
+	 */
+	SimplifiedSkeleton(const FlatSkeleton& skeleton, unsigned int maxLevels = 12);
+
+	unsigned int numLevels() const { return _levels.size(); }
+
+	/**
+	 * The maximal distance of the segments of a level to the skeleton.
+	 */
+	float getTolerance(unsigned int level) const { return _tolerances[level]; }
+
+	/**
+	 * The coarsest level with a tolerance not larger than the given one.
+	 */
+	unsigned int getLevel(float tolerance) const;
+
+	/**
+	 * The bounding box of all nodes in world units.
+	 */
+	const util::box<float,3>& getBoundingBox() const { return _boundingBox; }
+
+	/**
+	 * The segments of a level, as consecutive pairs of points.
+	 */
+	const std::vector<util::point<float,3>>& getSegments(unsigned int level) const { return _levels[level]; }
+
+private:
+
+	typedef std::vector<util::point<float,3>> Chain;
+
+	// split the skeleton into chains between nodes with degree other than 2
+	void extractChains(const FlatSkeleton& skeleton);
+
+	// add the segments of the Douglas-Peucker simplification of a chain
+	void simplify(const Chain& chain, float tolerance, std::vector<util::point<float,3>>& segments);
+
+	std::vector<Chain> _chains;
+
+	std::vector<std::vector<util::point<float,3>>> _levels;
+	std::vector<float>                             _tolerances;
+
+	util::box<float,3> _boundingBox;
+};
+
+#endif // TOOLS_ANALYSIS_SIMPLIFIED_SKELETON_H__
+
@@ -0,0 +1,289 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <unordered_map>
+#include <util/Logger.h>
+#include <util/exceptions.h>
+#include <io/ThreadPool.h>
+#include "SkeletonComparison.h"
+
+logger::LogChannel skeletoncomparisonlog("skeletoncomparisonlog", "[SkeletonComparison] ");
+
+namespace {
+
+inline float
+dot(const util::point<float,3>& a, const util::point<float,3>& b) {
+
+	return a.x()*b.x() + a.y()*b.y() + a.z()*b.z();
+}
+
+// the distance between the segments p1q1 and p2q2
+float
+segmentDistance(
+		const util::point<float,3>& p1,
+		const util::point<float,3>& q1,
+		const util::point<float,3>& p2,
+		const util::point<float,3>& q2) {
+
+	util::point<float,3> d1 = q1 - p1;
+	util::point<float,3> d2 = q2 - p2;
+	util::point<float,3> r  = p1 - p2;
+
+	float a = dot(d1, d1);
+	float e = dot(d2, d2);
+	float f = dot(d2, r);
+
+	float s = 0;
+	float t = 0;
+
+	if (a <= 1e-12 && e <= 1e-12) {
+
+		// both segments are points
+
+	} else if (a <= 1e-12) {
+
+		t = std::max(0.0f, std::min(1.0f, f/e));
+
+	} else {
+
+		float c = dot(d1, r);
+
+		if (e <= 1e-12) {
+
+			s = std::max(0.0f, std::min(1.0f, -c/a));
+
+		} else {
+
+			// closest points of the lines, clamped to the segments
+			float b     = dot(d1, d2);
+			float denom = a*e - b*b;
+
+			if (denom > 1e-12)
+				s = std::max(0.0f, std::min(1.0f, (b*f - c*e)/denom));
+
+			t = (b*s + f)/e;
+
+			if (t < 0) {
+
+				t = 0;
+				s = std::max(0.0f, std::min(1.0f, -c/a));
+
+			} else if (t > 1) {
+
+				t = 1;
+				s = std::max(0.0f, std::min(1.0f, (b - c)/a));
+			}
+		}
+	}
+
+	util::point<float,3> c1(p1.x() + s*d1.x(), p1.y() + s*d1.y(), p1.z() + s*d1.z());
+	util::point<float,3> c2(p2.x() + t*d2.x(), p2.y() + t*d2.y(), p2.z() + t*d2.z());
+	util::point<float,3> d = c1 - c2;
+
+	return std::sqrt(dot(d, d));
+}
+
+// a uniform grid of segment indices
+class Grid {
+
+public:
+
+	Grid(float cellSize) : _cellSize(cellSize) {}
+
+	// add a segment to all cells its bounding box, grown by the given margin, 
+	// intersects
+	void add(size_t index, const util::point<float,3>& p, const util::point<float,3>& q, float margin) {
+
+		int begin[3], end[3];
+		getCells(p, q, margin, begin, end);
+
+		for (int z = begin[2]; z <= end[2]; z++)
+			for (int y = begin[1]; y <= end[1]; y++)
+				for (int x = begin[0]; x <= end[0]; x++)
+					_cells[key(x, y, z)].push_back(index);
+	}
+
+	// get all segments in the cells the bounding box of the given segment 
+	// intersects, each once
+	void find(const util::point<float,3>& p, const util::point<float,3>& q, std::vector<size_t>& indices) const {
+
+		indices.clear();
+
+		int begin[3], end[3];
+		getCells(p, q, 0, begin, end);
+
+		for (int z = begin[2]; z <= end[2]; z++)
+			for (int y = begin[1]; y <= end[1]; y++)
+				for (int x = begin[0]; x <= end[0]; x++) {
+
+					auto i = _cells.find(key(x, y, z));
+					if (i != _cells.end())
+						indices.insert(indices.end(), i->second.begin(), i->second.end());
+				}
+
+		std::sort(indices.begin(), indices.end());
+		indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+	}
+
+private:
+
+	void getCells(const util::point<float,3>& p, const util::point<float,3>& q, float margin, int* begin, int* end) const {
+
+		begin[0] = std::floor((std::min(p.x(), q.x()) - margin)/_cellSize);
+		begin[1] = std::floor((std::min(p.y(), q.y()) - margin)/_cellSize);
+		begin[2] = std::floor((std::min(p.z(), q.z()) - margin)/_cellSize);
+		end[0]   = std::floor((std::max(p.x(), q.x()) + margin)/_cellSize);
+		end[1]   = std::floor((std::max(p.y(), q.y()) + margin)/_cellSize);
+		end[2]   = std::floor((std::max(p.z(), q.z()) + margin)/_cellSize);
+	}
+
+	static uint64_t key(int x, int y, int z) {
+
+		// 21 bits per coordinate
+		const uint64_t mask = (1 << 21) - 1;
+		return ((uint64_t)x & mask) | (((uint64_t)y & mask) << 21) | (((uint64_t)z & mask) << 42);
+	}
+
+	float _cellSize;
+
+	std::unordered_map<uint64_t, std::vector<size_t>> _cells;
+};
+
+} // namespace
+
+SkeletonComparison::SkeletonComparison(float maxDistance, unsigned int numThreads) :
+	_maxDistance(maxDistance),
+	_numThreads(numThreads) {
+
+	if (maxDistance <= 0)
+		UTIL_THROW_EXCEPTION(
+				UsageError,
+				"the maximal distance to compare skeletons has to be positive, got " << maxDistance);
+}
+
+std::vector<SkeletonComparison::Match>
+SkeletonComparison::match(const Skeleton& source, const Skeleton& target) {
+
+	return match(FlatSkeleton(source), FlatSkeleton(target));
+}
+
+std::vector<SkeletonComparison::Match>
+SkeletonComparison::match(const FlatSkeleton& source, const FlatSkeleton& target) {
+
+	std::vector<Segment> a = getSegments(source);
+	std::vector<Segment> b = getSegments(target);
+
+	std::vector<Match> matches;
+
+	if (a.empty() || b.empty())
+		return matches;
+
+	// cells should neither be much smaller than the edges nor than the 
+	// maximal distance, to keep the number of cells per edge small
+	std::vector<float> lengths;
+	target.getLengths(lengths);
+
+	double totalLength = 0;
+	for (float length : lengths)
+		totalLength += length;
+
+	float cellSize = std::max((double)_maxDistance, totalLength/b.size());
+
+	Grid grid(cellSize);
+	for (size_t i = 0; i < b.size(); i++)
+		grid.add(i, b[i].p, b[i].q, _maxDistance);
+
+	ThreadPool pool(_numThreads);
+
+	// one chunk of source edges per task, the results are concatenated in 
+	// order
+	size_t numChunks = std::min(a.size(), (size_t)pool.size()*4);
+	size_t chunkSize = (a.size() + numChunks - 1)/numChunks;
+
+	std::vector<std::vector<Match>> partial(numChunks);
+
+	for (size_t c = 0; c < numChunks; c++)
+		pool.schedule([this, &a, &b, &grid, &partial, c, chunkSize]() {
+
+			std::vector<size_t> candidates;
+
+			size_t begin = c*chunkSize;
+			size_t end   = std::min(a.size(), (c + 1)*chunkSize);
+
+			for (size_t i = begin; i < end; i++) {
+
+				grid.find(a[i].p, a[i].q, candidates);
+
+				for (size_t j : candidates) {
+
+					float distance = segmentDistance(a[i].p, a[i].q, b[j].p, b[j].q);
+
+					if (distance >= _maxDistance)
+						continue;
+
+					Match m;
+					m.e     = a[i].id;
+					m.f     = b[j].id;
+					m.score = 1.0 - distance/_maxDistance;
+
+					partial[c].push_back(m);
+				}
+			}
+		});
+
+	pool.wait();
+
+	for (auto& p : partial)
+		matches.insert(matches.end(), p.begin(), p.end());
+
+	LOG_DEBUG(skeletoncomparisonlog)
+			<< "found " << matches.size() << " matches between "
+			<< a.size() << " and " << b.size() << " edges" << std::endl;
+
+	return matches;
+}
+
+std::shared_ptr<SkeletonEdgeMatchScores>
+SkeletonComparison::compare(
+		std::shared_ptr<Skeleton> source,
+		std::shared_ptr<Skeleton> target,
+		const std::string& name) {
+
+	auto scores = std::make_shared<SkeletonEdgeMatchScores>(name);
+	scores->setSource(source);
+	scores->setTarget(target);
+
+	for (const Match& m : match(*source, *target))
+		scores->setScore(m.e, m.f, m.score);
+
+	return scores;
+}
+
+void
+SkeletonComparison::write(const std::vector<Match>& matches, const std::string& filename) {
+
+	std::ofstream out(filename.c_str());
+
+	if (!out.good())
+		UTIL_THROW_EXCEPTION(
+				IOError,
+				"can not write " << filename);
+
+	for (const Match& m : matches)
+		out << m.e << " " << m.f << " " << m.score << "\n";
+}
+
+std::vector<SkeletonComparison::Segment>
+SkeletonComparison::getSegments(const FlatSkeleton& skeleton) {
+
+	std::vector<Segment> segments(skeleton.numEdges());
+
+	for (size_t e = 0; e < skeleton.numEdges(); e++) {
+
+		segments[e].id = skeleton.edgeIds()[e];
+		segments[e].p  = skeleton.getNode(skeleton.u()[e]);
+		segments[e].q  = skeleton.getNode(skeleton.v()[e]);
+	}
+
+	return segments;
+}
@@ -0,0 +1,84 @@
+#ifndef TOOLS_ANALYSIS_SKELETON_COMPARISON_H__
+#define TOOLS_ANALYSIS_SKELETON_COMPARISON_H__
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <imageprocessing/Skeleton.h>
+#include <imageprocessing/SkeletonEdgeMatchScores.h>
+#include <util/point.hpp>
+#include "FlatSkeleton.h"
+
+/**
+ * Computes match scores between the edges of two skeletons. Two edges match 
+ * if their distance is smaller than a maximal distance, with a score falling 
+ * linearly from 1 for touching edges to 0 at the maximal distance. Only pairs 
+ * of edges in nearby cells of a uniform grid are considered, such that the 
+ * effort is about linear in the number of edges.
+ */
+class SkeletonComparison {
+
+public:
+
+	struct Match {
+
+		// the graph ids of the edges in the source and target skeleton
+		int e;
+		int f;
+
+		double score;
+	};
+
+	/**
+	 * @param maxDistance
+	 *              The distance in world units from which on edges do not 
+	 *              match anymore.
+	 * @param numThreads
+	 *              The number of threads to use, 0 for one per core.
+	 */
+	SkeletonComparison(float maxDistance, unsigned int numThreads = 0);
+
+	/**
+	 * Find all pairs of matching edges between a source and a target 
+	 * skeleton, ordered by source and target edge.
+	 */
+	std::vector<Match> match(const Skeleton& source, const Skeleton& target);
+
+	/**
+	 * Same as match(), for skeletons already in flat form.
+	 */
+	std::vector<Match> match(const FlatSkeleton& source, const FlatSkeleton& target);
+
+	/**
+	 * Compare two skeletons and return the match scores, to be shown by 
+	 * SkeletonView.
+	 */
+	std::shared_ptr<SkeletonEdgeMatchScores> compare(
+			std::shared_ptr<Skeleton> source,
+			std::shared_ptr<Skeleton> target,
+			const std::string& name = "distance");
+
+	/**
+	 * Write matches as lines of "<e> <f> <score>", as read by 
+	 * readEdgeMatchScores().
+	 */
+	static void write(const std::vector<Match>& matches, const std::string& filename);
+
+private:
+
+	struct Segment {
+
+		int id;
+
+		util::point<float,3> p;
+		util::point<float,3> q;
+	};
+
+	static std::vector<Segment> getSegments(const FlatSkeleton& skeleton);
+
+	float        _maxDistance;
+	unsigned int _numThreads;
+};
+
+#endif // TOOLS_ANALYSIS_SKELETON_COMPARISON_H__
+
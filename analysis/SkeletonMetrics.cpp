@@ -0,0 +1,44 @@
+#include <algorithm>
+#include "SkeletonMetrics.h"
+
+SkeletonMetrics::SkeletonMetrics(const FlatSkeleton& skeleton) :
+	numNodes(skeleton.numNodes()),
+	numEdges(skeleton.numEdges()),
+	numBranches(0),
+	numLeaves(0),
+	cableLength(0),
+	meanDiameter(0) {
+
+	std::vector<float> lengths;
+	skeleton.getLengths(lengths);
+
+	for (float length : lengths)
+		cableLength += length;
+
+	if (numNodes == 0)
+		return;
+
+	double diameterSum = 0;
+
+	for (size_t i = 0; i < numNodes; i++) {
+
+		if (skeleton.degree(i) == 1)
+			numLeaves++;
+		if (skeleton.degree(i) > 2)
+			numBranches++;
+
+		diameterSum += skeleton.diameters()[i];
+	}
+
+	meanDiameter = diameterSum/numNodes;
+
+	boundingBox = util::box<float,3>(
+			util::point<float,3>(
+					*std::min_element(skeleton.x().begin(), skeleton.x().end()),
+					*std::min_element(skeleton.y().begin(), skeleton.y().end()),
+					*std::min_element(skeleton.z().begin(), skeleton.z().end())),
+			util::point<float,3>(
+					*std::max_element(skeleton.x().begin(), skeleton.x().end()),
+					*std::max_element(skeleton.y().begin(), skeleton.y().end()),
+					*std::max_element(skeleton.z().begin(), skeleton.z().end())));
+}
@@ -0,0 +1,36 @@
+#ifndef TOOLS_ANALYSIS_SKELETON_METRICS_H__
+#define TOOLS_ANALYSIS_SKELETON_METRICS_H__
+
+#include <util/box.hpp>
+#include "FlatSkeleton.h"
+
+/**
+ * Summary statistics of a skeleton, in world units.
+ */
+struct SkeletonMetrics {
+
+	/**
+	 * Compute the metrics of a skeleton.
+	 */
+	SkeletonMetrics(const FlatSkeleton& skeleton);
+
+	size_t numNodes;
+	size_t numEdges;
+
+	// nodes with more than two neighbors
+	size_t numBranches;
+
+	// nodes with exactly one neighbor
+	size_t numLeaves;
+
+	// the sum of the lengths of all edges
+	double cableLength;
+
+	double meanDiameter;
+
+	// the bounding box of all nodes, empty if there are none
+	util::box<float,3> boundingBox;
+};
+
+#endif // TOOLS_ANALYSIS_SKELETON_METRICS_H__
+
@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <util/Logger.h>
+#include <io/ThreadPool.h>
+#include "Skeletonizer.h"
+
+logger::LogChannel skeletonizerlog("skeletonizerlog", "[Skeletonizer] ");
+
+Skeletonizer::Skeletonizer(
+		std::shared_ptr<ExplicitVolume<uint64_t>> labels,
+		std::shared_ptr<LabelStatistics> statistics,
+		const Teasar::Parameters& parameters,
+		size_t maxVoxels,
+		unsigned int numThreads) :
+	_labels(labels),
+	_statistics(statistics),
+	_parameters(parameters),
+	// voxels are indexed with 32 bit in Teasar
+	_maxVoxels(std::min(maxVoxels, (size_t)std::numeric_limits<uint32_t>::max())),
+	_numThreads(numThreads) {}
+
+std::shared_ptr<Skeleton>
+Skeletonizer::skeletonize(uint64_t id) const {
+
+	auto skeleton = std::make_shared<Skeleton>();
+
+	if (!_statistics->contains(id))
+		return skeleton;
+
+	const LabelStatistics::Label& label = (*_statistics)[id];
+
+	unsigned int extent[3];
+	for (int d = 0; d < 3; d++)
+		extent[d] = label.end[d] - label.begin[d];
+
+	// downsample the mask until it fits, with a border of one background
+	// voxel
+	unsigned int factor = 1;
+	size_t       size[3];
+	for (;; factor++) {
+
+		for (int d = 0; d < 3; d++)
+			size[d] = (extent[d] + factor - 1)/factor + 2;
+
+		if (size[0]*size[1]*size[2] <= _maxVoxels || factor == std::max(extent[0], std::max(extent[1], extent[2])))
+			break;
+	}
+
+	if (factor > 1)
+		LOG_USER(skeletonizerlog)
+				<< "label " << id << " is too large, skeletonizing it at 1/"
+				<< factor << " of the resolution" << std::endl;
+
+	unsigned int width  = _labels->getDiscreteBoundingBox().width();
+	unsigned int height = _labels->getDiscreteBoundingBox().height();
+
+	const uint64_t* data = _labels->data().data();
+
+	// a coarse voxel is foreground if any of its voxels is part of the label,
+	// such that thin parts stay connected
+	std::vector<char> mask(size[0]*size[1]*size[2], 0);
+
+	for (unsigned int z = label.begin[2]; z < label.end[2]; z++)
+		for (unsigned int y = label.begin[1]; y < label.end[1]; y++) {
+
+			const uint64_t* row = data + ((size_t)z*height + y)*width;
+
+			size_t maskZ = (z - label.begin[2])/factor + 1;
+			size_t maskY = (y - label.begin[1])/factor + 1;
+			char*  maskRow = &mask[(maskZ*size[1] + maskY)*size[0]];
+
+			for (unsigned int x = label.begin[0]; x < label.end[0]; x++)
+				if (row[x] == id)
+					maskRow[(x - label.begin[0])/factor + 1] = 1;
+		}
+
+	const util::point<float,3>& resolution = _labels->getResolution();
+	const util::point<float,3>& offset     = _labels->getOffset();
+
+	Teasar teasar(_parameters);
+	teasar.skeletonize(
+			mask,
+			size[0], size[1], size[2],
+			util::point<float,3>(
+					resolution.x()*factor,
+					resolution.y()*factor,
+					resolution.z()*factor),
+			*skeleton);
+
+	// node positions are voxels of the mask, centered in the voxels they
+	// cover
+	skeleton->setResolution(
+			resolution.x()*factor,
+			resolution.y()*factor,
+			resolution.z()*factor);
+	skeleton->setOffset(
+			offset.x() + (label.begin[0] - 0.5*factor)*resolution.x(),
+			offset.y() + (label.begin[1] - 0.5*factor)*resolution.y(),
+			offset.z() + (label.begin[2] - 0.5*factor)*resolution.z());
+
+	LOG_DEBUG(skeletonizerlog)
+			<< "skeleton of label " << id << " has "
+			<< lemon::countNodes(skeleton->graph()) << " nodes" << std::endl;
+
+	return skeleton;
+}
+
+void
+Skeletonizer::skeletonize(
+		const std::vector<uint64_t>& ids,
+		std::function<void(uint64_t, std::shared_ptr<Skeleton>)> done) const {
+
+	std::mutex mutex;
+
+	ThreadPool pool(_numThreads);
+
+	for (uint64_t id : ids)
+		pool.schedule([this, id, &done, &mutex]() {
+
+			std::shared_ptr<Skeleton> skeleton = skeletonize(id);
+
+			std::lock_guard<std::mutex> lock(mutex);
+			done(id, skeleton);
+		});
+
+	pool.wait();
+}
@@ -0,0 +1,60 @@
+#ifndef TOOLS_ANALYSIS_SKELETONIZER_H__
+#define TOOLS_ANALYSIS_SKELETONIZER_H__
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include <imageprocessing/ExplicitVolume.h>
+#include <imageprocessing/Skeleton.h>
+#include "LabelStatistics.h"
+#include "Teasar.h"
+
+/**
+ * Skeletonizes labels of a label volume with TEASAR, in parallel. Only the
+ * bounding box of a label is copied into a mask, which is downsampled for
+ * labels with a bounding box of more than a maximal number of voxels.
+ */
+class Skeletonizer {
+
+public:
+
+	/**
+	 * @param maxVoxels
+	 *              The maximal number of voxels of the mask of a single label.
+	 *              Larger labels are skeletonized at a lower resolution.
+	 * @param numThreads
+	 *              The number of threads to use, 0 for one per core.
+	 */
+	Skeletonizer(
+			std::shared_ptr<ExplicitVolume<uint64_t>> labels,
+			std::shared_ptr<LabelStatistics> statistics,
+			const Teasar::Parameters& parameters = Teasar::Parameters(),
+			size_t maxVoxels = 64*1024*1024,
+			unsigned int numThreads = 0);
+
+	/**
+	 * Skeletonize a single label. Returns an empty skeleton if the label does
+	 * not exist.
+	 */
+	std::shared_ptr<Skeleton> skeletonize(uint64_t id) const;
+
+	/**
+	 * Skeletonize several labels in parallel. The callback is called for each
+	 * skeleton as soon as it is done, one at a time.
+	 */
+	void skeletonize(
+			const std::vector<uint64_t>& ids,
+			std::function<void(uint64_t, std::shared_ptr<Skeleton>)> done) const;
+
+private:
+
+	std::shared_ptr<ExplicitVolume<uint64_t>> _labels;
+	std::shared_ptr<LabelStatistics>          _statistics;
+
+	Teasar::Parameters _parameters;
+	size_t             _maxVoxels;
+	unsigned int       _numThreads;
+};
+
+#endif // TOOLS_ANALYSIS_SKELETONIZER_H__
+
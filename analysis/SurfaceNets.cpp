@@ -0,0 +1,248 @@
+#include <cmath>
+#include <util/Logger.h>
+#include "SurfaceNets.h"
+
+logger::LogChannel surfacenetslog("surfacenetslog", "[SurfaceNets] ");
+
+SurfaceNets::SurfaceNets(
+		const ExplicitVolume<uint64_t>& labels,
+		const LabelStatistics& statistics) :
+	_labels(labels),
+	_statistics(statistics) {}
+
+void
+SurfaceNets::extract(uint64_t id, TriangleMesh& mesh) const {
+
+	mesh.vertices.clear();
+	mesh.normals.clear();
+	mesh.triangles.clear();
+
+	if (!_statistics.contains(id))
+		return;
+
+	const LabelStatistics::Label& label = _statistics[id];
+
+	int width  = _labels.getDiscreteBoundingBox().width();
+	int height = _labels.getDiscreteBoundingBox().height();
+	int depth  = _labels.getDiscreteBoundingBox().depth();
+
+	const uint64_t* data = _labels.data().data();
+
+	// the bounding box of the label with one voxel of background around it,
+	// such that the surface is closed
+	int ox = (int)label.begin[0] - 1;
+	int oy = (int)label.begin[1] - 1;
+	int oz = (int)label.begin[2] - 1;
+	int mx = label.end[0] - label.begin[0] + 2;
+	int my = label.end[1] - label.begin[1] + 2;
+	int mz = label.end[2] - label.begin[2] + 2;
+
+	std::vector<char> inside((size_t)mx*my*mz, 0);
+
+	for (int k = 0; k < mz; k++)
+		for (int j = 0; j < my; j++)
+			for (int i = 0; i < mx; i++) {
+
+				int x = ox + i;
+				int y = oy + j;
+				int z = oz + k;
+
+				if (x < 0 || y < 0 || z < 0 || x >= width || y >= height || z >= depth)
+					continue;
+
+				inside[((size_t)k*my + j)*mx + i] = (data[((size_t)z*height + y)*width + x] == id);
+			}
+
+	auto isInside = [&](int i, int j, int k) { return inside[((size_t)k*my + j)*mx + i]; };
+
+	// a cell spans the centers of eight voxels, the vertex indices of the
+	// cells are kept for the current and the previous layer of cells
+	int cw = mx - 1;
+	int ch = my - 1;
+
+	std::vector<int> layers[2];
+	layers[0].resize((size_t)cw*ch);
+	layers[1].resize((size_t)cw*ch);
+
+	// the twelve edges of a cell as pairs of corners, corners are numbered by
+	// their x, y, and z offset in bit 0, 1, and 2
+	static const int edges[12][2] = {
+		{0, 1}, {2, 3}, {4, 5}, {6, 7},
+		{0, 2}, {1, 3}, {4, 6}, {5, 7},
+		{0, 4}, {1, 5}, {2, 6}, {3, 7}
+	};
+
+	const util::point<float,3>& resolution = _labels.getResolution();
+	const util::point<float,3>& offset     = _labels.getOffset();
+
+	auto addQuad = [&](int c00, int c10, int c11, int c01, bool lowerInside) {
+
+		// counter-clockwise seen from the outside
+		if (lowerInside) {
+
+			uint32_t quad[6] = { (uint32_t)c00, (uint32_t)c10, (uint32_t)c11, (uint32_t)c00, (uint32_t)c11, (uint32_t)c01 };
+			mesh.triangles.insert(mesh.triangles.end(), quad, quad + 6);
+
+		} else {
+
+			uint32_t quad[6] = { (uint32_t)c00, (uint32_t)c11, (uint32_t)c10, (uint32_t)c00, (uint32_t)c01, (uint32_t)c11 };
+			mesh.triangles.insert(mesh.triangles.end(), quad, quad + 6);
+		}
+	};
+
+	for (int k = 0; k < mz - 1; k++) {
+
+		std::vector<int>& current  = layers[k%2];
+		std::vector<int>& previous = layers[(k + 1)%2];
+
+		// place one vertex in each cell crossed by the surface, at the mean of
+		// the crossed edges' centers
+
+		for (int j = 0; j < ch; j++)
+			for (int i = 0; i < cw; i++) {
+
+				bool corners[8];
+				int  numInside = 0;
+				for (int n = 0; n < 8; n++) {
+
+					corners[n] = isInside(i + (n & 1), j + ((n >> 1) & 1), k + (n >> 2));
+					numInside += corners[n];
+				}
+
+				if (numInside == 0 || numInside == 8) {
+
+					current[(size_t)j*cw + i] = -1;
+					continue;
+				}
+
+				float sum[3] = {0, 0, 0};
+				int   numCrossed = 0;
+
+				for (int e = 0; e < 12; e++) {
+
+					int a = edges[e][0];
+					int b = edges[e][1];
+
+					if (corners[a] == corners[b])
+						continue;
+
+					sum[0] += 0.5f*((a & 1) + (b & 1));
+					sum[1] += 0.5f*(((a >> 1) & 1) + ((b >> 1) & 1));
+					sum[2] += 0.5f*((a >> 2) + (b >> 2));
+					numCrossed++;
+				}
+
+				current[(size_t)j*cw + i] = mesh.numVertices();
+
+				// voxel centers are at half the resolution
+				mesh.vertices.push_back(offset.x() + (ox + i + sum[0]/numCrossed + 0.5f)*resolution.x());
+				mesh.vertices.push_back(offset.y() + (oy + j + sum[1]/numCrossed + 0.5f)*resolution.y());
+				mesh.vertices.push_back(offset.z() + (oz + k + sum[2]/numCrossed + 0.5f)*resolution.z());
+			}
+
+		// connect the vertices of the four cells around each voxel edge
+		// crossed by the surface
+
+		// edges in z between voxel layers k and k+1, all cells in the
+		// current layer
+		for (int j = 1; j < my - 1; j++)
+			for (int i = 1; i < mx - 1; i++) {
+
+				bool lower = isInside(i, j, k);
+				if (lower == isInside(i, j, k + 1))
+					continue;
+
+				addQuad(
+						current[(size_t)(j - 1)*cw + i - 1],
+						current[(size_t)(j - 1)*cw + i],
+						current[(size_t)j*cw + i],
+						current[(size_t)j*cw + i - 1],
+						lower);
+			}
+
+		// edges in x and y in voxel layer k, around them are cells of the
+		// previous and current layer
+		if (k == 0)
+			continue;
+
+		for (int j = 1; j < my - 1; j++)
+			for (int i = 0; i < mx - 1; i++) {
+
+				bool lower = isInside(i, j, k);
+				if (lower == isInside(i + 1, j, k))
+					continue;
+
+				addQuad(
+						previous[(size_t)(j - 1)*cw + i],
+						previous[(size_t)j*cw + i],
+						current[(size_t)j*cw + i],
+						current[(size_t)(j - 1)*cw + i],
+						lower);
+			}
+
+		for (int j = 0; j < my - 1; j++)
+			for (int i = 1; i < mx - 1; i++) {
+
+				bool lower = isInside(i, j, k);
+				if (lower == isInside(i, j + 1, k))
+					continue;
+
+				addQuad(
+						previous[(size_t)j*cw + i - 1],
+						current[(size_t)j*cw + i - 1],
+						current[(size_t)j*cw + i],
+						previous[(size_t)j*cw + i],
+						lower);
+			}
+	}
+
+	computeNormals(mesh);
+
+	LOG_DEBUG(surfacenetslog)
+			<< "extracted mesh of label " << id << " with "
+			<< mesh.numVertices() << " vertices and "
+			<< mesh.numTriangles() << " triangles" << std::endl;
+}
+
+void
+SurfaceNets::computeNormals(TriangleMesh& mesh) const {
+
+	mesh.normals.assign(mesh.vertices.size(), 0.0f);
+
+	const std::vector<float>& v = mesh.vertices;
+	std::vector<float>&       n = mesh.normals;
+
+	for (size_t t = 0; t < mesh.triangles.size(); t += 3) {
+
+		size_t a = 3*mesh.triangles[t];
+		size_t b = 3*mesh.triangles[t + 1];
+		size_t c = 3*mesh.triangles[t + 2];
+
+		float ux = v[b] - v[a], uy = v[b + 1] - v[a + 1], uz = v[b + 2] - v[a + 2];
+		float wx = v[c] - v[a], wy = v[c + 1] - v[a + 1], wz = v[c + 2] - v[a + 2];
+
+		// the cross product is weighted by the area of the triangle
+		float nx = uy*wz - uz*wy;
+		float ny = uz*wx - ux*wz;
+		float nz = ux*wy - uy*wx;
+
+		for (size_t i : { a, b, c }) {
+
+			n[i]     += nx;
+			n[i + 1] += ny;
+			n[i + 2] += nz;
+		}
+	}
+
+	for (size_t i = 0; i < n.size(); i += 3) {
+
+		float length = std::sqrt(n[i]*n[i] + n[i + 1]*n[i + 1] + n[i + 2]*n[i + 2]);
+
+		if (length > 0) {
+
+			n[i]     /= length;
+			n[i + 1] /= length;
+			n[i + 2] /= length;
+		}
+	}
+}
@@ -0,0 +1,39 @@
+#ifndef TOOLS_ANALYSIS_SURFACE_NETS_H__
+#define TOOLS_ANALYSIS_SURFACE_NETS_H__
+
+#include <imageprocessing/ExplicitVolume.h>
+#include <io/meshes.h>
+#include "LabelStatistics.h"
+
+/**
+ * Extracts the surface of a label as a triangle mesh with surface nets: one
+ * vertex per cell of eight voxel centers that is crossed by the surface, and
+ * one quad per pair of neighboring voxels of which only one is part of the
+ * label. Only the bounding box of the label is visited, such that meshes of
+ * different labels can be extracted in parallel. Vertices are in world units.
+ */
+class SurfaceNets {
+
+public:
+
+	SurfaceNets(
+			const ExplicitVolume<uint64_t>& labels,
+			const LabelStatistics& statistics);
+
+	/**
+	 * Extract the surface of the given label. The mesh is empty if the label
+	 * does not exist.
+	 */
+	void extract(uint64_t id, TriangleMesh& mesh) const;
+
+private:
+
+	// compute one normal per vertex from the areas of the adjacent triangles
+	void computeNormals(TriangleMesh& mesh) const;
+
+	const ExplicitVolume<uint64_t>& _labels;
+	const LabelStatistics&          _statistics;
+};
+
+#endif // TOOLS_ANALYSIS_SURFACE_NETS_H__
+
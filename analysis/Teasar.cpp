@@ -0,0 +1,311 @@
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+#include <util/Logger.h>
+#include "Teasar.h"
+
+logger::LogChannel teasarlog("teasarlog", "[Teasar] ");
+
+Teasar::Teasar(const Parameters& parameters) :
+	_parameters(parameters) {}
+
+void
+Teasar::skeletonize(
+		const std::vector<char>& mask,
+		unsigned int width,
+		unsigned int height,
+		unsigned int depth,
+		const util::point<float,3>& resolution,
+		Skeleton& skeleton) {
+
+	_width      = width;
+	_height     = height;
+	_depth      = depth;
+	_resolution = resolution;
+
+	size_t size = (size_t)width*height*depth;
+
+	_neighborOffsets.clear();
+	_neighborDistances.clear();
+
+	for (int dz = -1; dz <= 1; dz++)
+		for (int dy = -1; dy <= 1; dy++)
+			for (int dx = -1; dx <= 1; dx++) {
+
+				if (dx == 0 && dy == 0 && dz == 0)
+					continue;
+
+				_neighborOffsets.push_back(((int64_t)dz*height + dy)*width + dx);
+				_neighborDistances.push_back(std::sqrt(
+						dx*dx*resolution.x()*resolution.x() +
+						dy*dy*resolution.y()*resolution.y() +
+						dz*dz*resolution.z()*resolution.z()));
+			}
+
+	distanceTransform(mask);
+
+	float maxBoundaryDistance = 0;
+	for (size_t i = 0; i < size; i++)
+		maxBoundaryDistance = std::max(maxBoundaryDistance, _boundaryDistances[i]);
+	maxBoundaryDistance = std::sqrt(maxBoundaryDistance);
+
+	if (maxBoundaryDistance == 0)
+		return;
+
+	// the penalty of stepping on a voxel, high close to the boundary
+	std::vector<float> penalties(size, 1.0f);
+	for (size_t i = 0; i < size; i++)
+		if (mask[i])
+			penalties[i] = 1.0f + _parameters.penaltyScale*std::pow(
+					1.0f - std::sqrt(_boundaryDistances[i])/maxBoundaryDistance,
+					_parameters.penaltyExponent);
+
+	float inf = std::numeric_limits<float>::infinity();
+
+	std::vector<float>    rootDistances(size, inf);
+	std::vector<float>    penalizedDistances(size, inf);
+	std::vector<uint32_t> parents(size);
+
+	// voxels of components that have been processed, and voxels covered by
+	// the skeleton
+	std::vector<char> done(size, 0);
+	std::vector<char> invalid(size, 0);
+
+	std::unordered_map<uint32_t, Skeleton::Node> nodes;
+
+	auto addNode = [&](uint32_t i) {
+
+		Skeleton::Node node = skeleton.graph().addNode();
+
+		skeleton.positions()[node] = util::point<unsigned int,3>(
+				i%width,
+				(i/width)%height,
+				i/((size_t)width*height));
+		skeleton.diameters()[node] = 2*std::sqrt(_boundaryDistances[i]);
+
+		nodes[i] = node;
+
+		return node;
+	};
+
+	for (size_t seed = 0; seed < size; seed++) {
+
+		if (!mask[seed] || done[seed])
+			continue;
+
+		// the root is the voxel farthest away from any voxel of the component
+		std::vector<uint32_t> reached = dijkstra(seed, mask, 0, rootDistances, 0);
+		uint32_t root = reached.back();
+
+		for (uint32_t i : reached)
+			rootDistances[i] = inf;
+
+		// the voxels of the component, ordered by their distance to the root
+		reached = dijkstra(root, mask, 0, rootDistances, 0);
+		dijkstra(root, mask, &penalties, penalizedDistances, &parents);
+
+		LOG_ALL(teasarlog) << "component with " << reached.size() << " voxels" << std::endl;
+
+		addNode(root);
+		invalidate(root, mask, invalid);
+
+		// trace paths from the farthest voxels not covered yet to the skeleton
+		for (auto target = reached.rbegin(); target != reached.rend(); target++) {
+
+			if (invalid[*target])
+				continue;
+
+			Skeleton::Node previous = lemon::INVALID;
+
+			for (uint32_t i = *target;; i = parents[i]) {
+
+				auto existing = nodes.find(i);
+				Skeleton::Node node = (existing != nodes.end() ? existing->second : addNode(i));
+
+				if (previous != lemon::INVALID)
+					skeleton.graph().addEdge(previous, node);
+
+				if (existing != nodes.end())
+					break;
+
+				invalidate(i, mask, invalid);
+				previous = node;
+			}
+		}
+
+		for (uint32_t i : reached) {
+
+			done[i] = 1;
+			rootDistances[i] = inf;
+			penalizedDistances[i] = inf;
+		}
+	}
+}
+
+void
+Teasar::distanceTransform(const std::vector<char>& mask) {
+
+	size_t size = (size_t)_width*_height*_depth;
+
+	_boundaryDistances.resize(size);
+	for (size_t i = 0; i < size; i++)
+		_boundaryDistances[i] = (mask[i] ? std::numeric_limits<float>::infinity() : 0.0f);
+
+	float* d = _boundaryDistances.data();
+
+	for (unsigned int z = 0; z < _depth; z++)
+		for (unsigned int y = 0; y < _height; y++)
+			distanceTransform1D(d + ((size_t)z*_height + y)*_width, _width, 1, _resolution.x());
+
+	for (unsigned int z = 0; z < _depth; z++)
+		for (unsigned int x = 0; x < _width; x++)
+			distanceTransform1D(d + (size_t)z*_height*_width + x, _height, _width, _resolution.y());
+
+	for (unsigned int y = 0; y < _height; y++)
+		for (unsigned int x = 0; x < _width; x++)
+			distanceTransform1D(d + (size_t)y*_width + x, _depth, (size_t)_width*_height, _resolution.z());
+}
+
+void
+Teasar::distanceTransform1D(float* values, size_t n, size_t stride, float spacing) {
+
+	_line.resize(n);
+	_parabolas.resize(n);
+	_intersections.resize(n + 1);
+
+	for (size_t q = 0; q < n; q++)
+		_line[q] = values[q*stride];
+
+	double inf = std::numeric_limits<double>::infinity();
+
+	// the lower envelope of the parabolas rooted at finite values, k is the
+	// number of parabolas in it
+	size_t k = 0;
+	for (size_t q = 0; q < n; q++) {
+
+		if (std::isinf(_line[q]))
+			continue;
+
+		double pq = q*spacing;
+		double s  = -inf;
+
+		while (k > 0) {
+
+			size_t v  = _parabolas[k - 1];
+			double pv = v*spacing;
+
+			s = ((_line[q] + pq*pq) - (_line[v] + pv*pv))/(2*(pq - pv));
+
+			if (s <= _intersections[k - 1])
+				k--;
+			else
+				break;
+		}
+
+		if (k == 0)
+			s = -inf;
+
+		_parabolas[k]     = q;
+		_intersections[k] = s;
+		k++;
+	}
+
+	if (k == 0)
+		return;
+
+	_intersections[k] = inf;
+
+	size_t j = 0;
+	for (size_t q = 0; q < n; q++) {
+
+		double pq = q*spacing;
+
+		while (_intersections[j + 1] < pq)
+			j++;
+
+		double pv = _parabolas[j]*spacing;
+		values[q*stride] = (pq - pv)*(pq - pv) + _line[_parabolas[j]];
+	}
+}
+
+std::vector<uint32_t>
+Teasar::dijkstra(
+		uint32_t source,
+		const std::vector<char>& mask,
+		const std::vector<float>* penalties,
+		std::vector<float>& distances,
+		std::vector<uint32_t>* parents) {
+
+	typedef std::pair<float, uint32_t> Entry;
+
+	std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+	std::vector<uint32_t> reached;
+
+	distances[source] = 0;
+	if (parents)
+		(*parents)[source] = source;
+	queue.push(Entry(0, source));
+
+	while (!queue.empty()) {
+
+		Entry entry = queue.top();
+		queue.pop();
+
+		uint32_t u = entry.second;
+
+		// outdated entry
+		if (entry.first > distances[u])
+			continue;
+
+		reached.push_back(u);
+
+		// the background border of the mask keeps neighbors inside the volume
+		for (size_t n = 0; n < _neighborOffsets.size(); n++) {
+
+			uint32_t v = u + _neighborOffsets[n];
+
+			if (!mask[v])
+				continue;
+
+			float distance = entry.first + _neighborDistances[n]*(penalties ? (*penalties)[v] : 1.0f);
+
+			if (distance < distances[v]) {
+
+				distances[v] = distance;
+				if (parents)
+					(*parents)[v] = u;
+				queue.push(Entry(distance, v));
+			}
+		}
+	}
+
+	return reached;
+}
+
+void
+Teasar::invalidate(uint32_t center, const std::vector<char>& mask, std::vector<char>& invalid) {
+
+	float radius = _parameters.scale*std::sqrt(_boundaryDistances[center]) + _parameters.constant;
+
+	int cx = center%_width;
+	int cy = (center/_width)%_height;
+	int cz = center/((size_t)_width*_height);
+
+	int rx = radius/_resolution.x();
+	int ry = radius/_resolution.y();
+	int rz = radius/_resolution.z();
+
+	for (int z = std::max(0, cz - rz); z <= std::min((int)_depth - 1, cz + rz); z++)
+		for (int y = std::max(0, cy - ry); y <= std::min((int)_height - 1, cy + ry); y++)
+			for (int x = std::max(0, cx - rx); x <= std::min((int)_width - 1, cx + rx); x++) {
+
+				float dx = (x - cx)*_resolution.x();
+				float dy = (y - cy)*_resolution.y();
+				float dz = (z - cz)*_resolution.z();
+
+				if (dx*dx + dy*dy + dz*dz <= radius*radius)
+					invalid[((size_t)z*_height + y)*_width + x] = 1;
+			}
+}
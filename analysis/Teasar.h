@@ -0,0 +1,109 @@
+#ifndef TOOLS_ANALYSIS_TEASAR_H__
+#define TOOLS_ANALYSIS_TEASAR_H__
+
+#include <cstdint>
+#include <vector>
+#include <imageprocessing/Skeleton.h>
+#include <util/point.hpp>
+
+/**
+ * TEASAR skeletonization of a binary mask (Sato et al., 2000): The skeleton
+ * starts at a root at the end of the longest path through the mask. Paths
+ * from the farthest voxel not covered yet back to the skeleton are added
+ * until all voxels are covered, where a path covers the voxels in a distance
+ * of scale*DBF + constant around it (DBF being the distance to the boundary
+ * of the mask). Paths prefer the center of the mask, since steps close to the
+ * boundary are penalized. Each connected component gets its own tree.
+ */
+class Teasar {
+
+public:
+
+	struct Parameters {
+
+		Parameters() :
+			scale(4),
+			constant(0),
+			penaltyScale(5000),
+			penaltyExponent(16) {}
+
+		// the radius of the region covered by a path, relative to the
+		// distance to the boundary of the mask, and in world units
+		float scale;
+		float constant;
+
+		// the cost of a step is multiplied by
+		// 1 + penaltyScale*(1 - DBF/max DBF)^penaltyExponent
+		float penaltyScale;
+		float penaltyExponent;
+	};
+
+	Teasar(const Parameters& parameters = Parameters());
+
+	/**
+	 * Skeletonize a mask. The mask has to have a border of at least one
+	 * background voxel.
+	 *
+	 * @param mask
+	 *              The mask, x running fastest, non-zero for foreground.
+	 * @param resolution
+	 *              The size of a voxel in world units.
+	 * @param skeleton
+	 *              The skeleton to add nodes and edges to. Node positions are
+	 *              the discrete coordinates of the voxels in the mask, the
+	 *              diameters are in world units.
+	 */
+	void skeletonize(
+			const std::vector<char>& mask,
+			unsigned int width,
+			unsigned int height,
+			unsigned int depth,
+			const util::point<float,3>& resolution,
+			Skeleton& skeleton);
+
+private:
+
+	// squared Euclidean distance of each voxel to the background
+	void distanceTransform(const std::vector<char>& mask);
+
+	// squared distance transform along one line of values with the given
+	// stride and spacing, using the lower envelope of parabolas
+	// (Felzenszwalb and Huttenlocher, 2012)
+	void distanceTransform1D(float* values, size_t n, size_t stride, float spacing);
+
+	// shortest paths from source through the mask, with step costs multiplied
+	// by the penalty of the voxel stepped on (if given), returns the reached
+	// voxels in the order of increasing distance
+	std::vector<uint32_t> dijkstra(
+			uint32_t source,
+			const std::vector<char>& mask,
+			const std::vector<float>* penalties,
+			std::vector<float>& distances,
+			std::vector<uint32_t>* parents);
+
+	// mark the voxels covered by a path voxel as invalid
+	void invalidate(uint32_t center, const std::vector<char>& mask, std::vector<char>& invalid);
+
+	Parameters _parameters;
+
+	unsigned int _width;
+	unsigned int _height;
+	unsigned int _depth;
+
+	util::point<float,3> _resolution;
+
+	// the squared distance to the boundary of each voxel
+	std::vector<float> _boundaryDistances;
+
+	// buffers for the distance transform of a line
+	std::vector<float>  _line;
+	std::vector<size_t> _parabolas;
+	std::vector<double> _intersections;
+
+	// the offsets and step lengths of the 26 neighbors of a voxel
+	std::vector<int64_t> _neighborOffsets;
+	std::vector<float>   _neighborDistances;
+};
+
+#endif // TOOLS_ANALYSIS_TEASAR_H__
+
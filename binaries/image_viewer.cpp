@@ -2,13 +2,20 @@
  * This programs shows individual images.
  */
 
+#include <atomic>
 #include <util/ProgramOptions.h>
 #include <imageprocessing/ExplicitVolume.h>
+#include <scopegraph/Scope.h>
 #include <gui/OverlayView.h>
+#include <gui/PollThrottle.h>
+#include <gui/TiledImageView.h>
 #include <sg_gui/RotateView.h>
 #include <sg_gui/ZoomView.h>
 #include <sg_gui/Window.h>
 #include <io/volumes.h>
+#include <io/ImageCache.h>
+#include <io/Thumbnails.h>
+#include <io/TiledImage.h>
 
 using namespace sg_gui;
 
@@ -17,6 +24,61 @@ util::ProgramOption optionImage(
 		util::_description_text = "A single image or a directory containing images.",
 		util::_is_positional    = true);
 
+util::ProgramOption optionCacheSize(
+		util::_long_name        = "cacheSize",
+		util::_description_text = "The maximal memory in MB to keep decoded images in.",
+		util::_default_value    = 1024);
+
+util::ProgramOption optionPrefetch(
+		util::_long_name        = "prefetch",
+		util::_description_text = "The number of images to decode ahead in the paging direction.",
+		util::_default_value    = 4);
+
+util::ProgramOption optionGridColumns(
+		util::_long_name        = "gridColumns",
+		util::_description_text = "The number of columns of the thumbnail grid.",
+		util::_default_value    = 8);
+
+util::ProgramOption optionGridRows(
+		util::_long_name        = "gridRows",
+		util::_description_text = "The number of rows of the thumbnail grid.",
+		util::_default_value    = 6);
+
+util::ProgramOption optionThumbnailSize(
+		util::_long_name        = "thumbnailSize",
+		util::_description_text = "The maximal width and height of the thumbnails in the grid.",
+		util::_default_value    = 128);
+
+util::ProgramOption optionThumbnailCache(
+		util::_long_name        = "thumbnailCache",
+		util::_description_text = "The directory to store thumbnails in. Defaults to ~/.cache/image_viewer/thumbnails. "
+		                          "Set to 'none' to not store thumbnails.");
+
+util::ProgramOption optionTiledAbove(
+		util::_long_name        = "tiledAbove",
+		util::_description_text = "Show images with more than this number of megapixels tile by tile. Tiled TIFF "
+		                          "images are always shown tile by tile.",
+		util::_default_value    = 64);
+
+std::string
+getThumbnailCacheDirectory() {
+
+	if (optionThumbnailCache) {
+
+		if (optionThumbnailCache.as<std::string>() == "none")
+			return "";
+
+		return optionThumbnailCache.as<std::string>();
+	}
+
+	const char* home = getenv("HOME");
+
+	if (!home)
+		return "";
+
+	return std::string(home) + "/.cache/image_viewer/thumbnails";
+}
+
 int main(int argc, char** argv) {
 
 	try {
@@ -24,62 +86,276 @@ int main(int argc, char** argv) {
 		util::ProgramOptions::init(argc, argv);
 		logger::LogManager::init();
 
-		// read volume and overlay
+		// list images, they are decoded on demand
 
 		std::vector<std::string> files = getImageFiles(optionImage.as<std::string>());
 
-		std::vector<std::shared_ptr<Image>> images;
+		auto cache = std::make_shared<ImageCache>(
+				files,
+				optionCacheSize.as<size_t>()*1024*1024,
+				2,
+				2*(optionPrefetch.as<int>() + 1));
+
+		auto thumbnails = std::make_shared<Thumbnails>(
+				files,
+				optionThumbnailSize.as<unsigned int>(),
+				getThumbnailCacheDirectory());
+
+		// a scope to hide the image view while a tiled image is shown
+
+		class VisibilityScope : public sg::Scope<
+				VisibilityScope,
+				sg::FiltersDown<
+						sg_gui::DrawOpaque,
+						sg_gui::QuerySize,
+						sg_gui::MouseDown,
+						sg_gui::SetImage
+				>,
+				sg::PassesUp<
+						sg_gui::ContentChanged
+				>> {
+
+		public:
+
+			VisibilityScope() : _visible(true) {}
+
+			void setVisible(bool visible) { _visible = visible; }
+
+			bool filterDown(sg_gui::DrawOpaque&) { return _visible; }
+			void unfilterDown(sg_gui::DrawOpaque&) {}
+
+			bool filterDown(sg_gui::QuerySize&) { return _visible; }
+			void unfilterDown(sg_gui::QuerySize&) {}
+
+			bool filterDown(sg_gui::MouseDown&) { return _visible; }
+			void unfilterDown(sg_gui::MouseDown&) {}
+
+			bool filterDown(sg_gui::SetImage&) { return true; }
+			void unfilterDown(sg_gui::SetImage&) {}
 
-		for (const std::string& file : files) {
+		private:
 
-			std::vector<std::string> single = {file};
-			ExplicitVolume<float> v = readVolume<float>(single);
-			auto image = std::make_shared<Image>();
-			*image = v.data().bind<2>(0);
-			image->setIdentifiyer(file);
-			images.push_back(image);
-		}
+			bool _visible;
+		};
 
 		// create a controller
 
 		class Controller : public sg::Agent<
 				Controller,
-				sg::Provides<sg_gui::SetImage>,
-				sg::Accepts<sg_gui::KeyDown>> {
+				sg::Provides<sg_gui::SetImage, sg_gui::ContentChanged>,
+				sg::Accepts<sg_gui::KeyDown, sg_gui::MouseDown, sg_gui::Draw>> {
 
 		public:
 
-			Controller() : _current(0) {}
+			Controller(int prefetch, int columns, int rows, float tiledAbove) :
+				_current(0),
+				_prefetch(prefetch),
+				_grid(false),
+				_columns(columns),
+				_rows(rows),
+				_tiledAbove(tiledAbove),
+				_thumbnailsReady(false) {}
+
+			void setViews(std::shared_ptr<VisibilityScope> imageScope, std::shared_ptr<TiledImageView> tiledView) {
+
+				_imageScope = imageScope;
+				_tiledView  = tiledView;
+			}
+
+			void setImages(
+					std::shared_ptr<ImageCache> images,
+					std::shared_ptr<Thumbnails> thumbnails,
+					const std::vector<std::string>& files) {
 
-			void setImages(const std::vector<std::shared_ptr<Image>>& images) {
+				_images     = images;
+				_thumbnails = thumbnails;
+				_files      = files;
+				_tiled      = std::vector<int>(files.size(), -1);
 
-				_images = images;
+				// thumbnails are created in the background, show them with the
+				// next draw after they became available
+				_thumbnails->setReadyCallback([this]() { _thumbnailsReady = true; });
 
-				if (_images.size() == 0)
+				if (_images->size() == 0)
 					return;
 
 				_current = 0;
-				send<sg_gui::SetImage>(_images[_current]);
+				show();
+
+				prefetch(1);
 			}
 
 			void onSignal(sg_gui::KeyDown& signal) {
 
-				if (_images.size() == 0)
+				if (!_images || _images->size() == 0)
+					return;
+
+				if (signal.key == sg_gui::keys::G) {
+
+					_grid = !_grid;
+					show();
+
 					return;
+				}
+
+				int direction;
 
 				if (signal.key == sg_gui::keys::D)
-					_current = std::min((int)_images.size() - 1, _current + 1);
+					direction = 1;
 				else if (signal.key == sg_gui::keys::A)
-					_current = std::max(0, _current - 1);
+					direction = -1;
 				else return;
 
-				send<sg_gui::SetImage>(_images[_current]);
+				// in grid mode, page through the grids
+				int step = (_grid ? _columns*_rows : 1);
+
+				if (_grid)
+					_current -= _current%step;
+
+				_current = std::max(0, std::min((int)_images->size() - 1, _current + direction*step));
+
+				show();
+
+				if (!_grid)
+					prefetch(direction);
+			}
+
+			void onSignal(sg_gui::MouseDown& signal) {
+
+				// Shift + left click on a thumbnail shows the image
+
+				if (!_grid || signal.button != sg_gui::buttons::Left || !(signal.modifiers & sg_gui::keys::ShiftDown))
+					return;
+
+				util::point<float, 2> pos = signal.ray.position().project<2>();
+				unsigned int size = _thumbnails->getThumbnailSize();
+
+				if (pos.x() < 0 || pos.y() < 0 || pos.x() >= _columns*size || pos.y() >= _rows*size)
+					return;
+
+				int index = (_current - _current%(_columns*_rows)) + (int)(pos.y()/size)*_columns + (int)(pos.x()/size);
+
+				if (index >= (int)_images->size())
+					return;
+
+				_current = index;
+				_grid    = false;
+				show();
+
+				prefetch(1);
+
+				signal.processed = true;
+			}
+
+			void onSignal(sg_gui::Draw& signal) {
+
+				if (!_grid)
+					return;
+
+				// checked first, such that no thumbnail that is done in
+				// between is missed
+				bool creating = _thumbnails->isCreating();
+
+				// update the grid with the thumbnails created since it was
+				// shown
+				bool ready = _thumbnailsReady.exchange(false);
+				if (ready)
+					show();
+
+				// signals are only sent on the GUI thread, ask for another
+				// frame to take the thumbnails still being created
+				if (creating) {
+
+					_poll.wait(signal, ready);
+					send<sg_gui::ContentChanged>();
+				}
 			}
 
 		private:
 
-			std::vector<std::shared_ptr<Image>> _images;
+			void show() {
+
+				bool tiled = (!_grid && isTiled(_current));
+
+				_imageScope->setVisible(!tiled);
+
+				if (tiled) {
+
+					std::cout << "showing image " << _files[_current] << " tile by tile" << std::endl;
+
+					_tiledView->setImage(openTiledImage(_files[_current]));
+					return;
+				}
+
+				_tiledView->setImage(std::shared_ptr<TiledImage>());
+
+				if (_grid) {
+
+					int first = _current - _current%(_columns*_rows);
+					send<sg_gui::SetImage>(_thumbnails->getGrid(first, first + _columns*_rows, _columns));
+
+				} else {
+
+					send<sg_gui::SetImage>(_images->get(_current));
+				}
+			}
+
+			// decode the next images in the given direction and the previous
+			// one in the background
+			void prefetch(int direction) {
+
+				for (int i = 1; i <= _prefetch; i++)
+					prefetchImage(_current + direction*i);
+
+				prefetchImage(_current - direction);
+			}
+
+			void prefetchImage(int i) {
+
+				// tiled images are not read completely
+				if (i >= 0 && i < (int)_files.size() && !isTiled(i))
+					_images->prefetch(i);
+			}
+
+			// should image i be shown tile by tile?
+			bool isTiled(int i) {
+
+				if (_tiled[i] < 0) {
+
+					try {
+
+						vigra::ImageImportInfo info(_files[i].c_str());
+						float megapixels = (float)info.width()*info.height()/1e6;
+
+						_tiled[i] = (megapixels > _tiledAbove || isTiledTiff(_files[i]));
+
+					} catch (std::exception& e) {
+
+						_tiled[i] = 0;
+					}
+				}
+
+				return _tiled[i];
+			}
+
+			std::shared_ptr<ImageCache> _images;
+			std::shared_ptr<Thumbnails> _thumbnails;
 			int _current;
+			int _prefetch;
+
+			bool _grid;
+			int  _columns;
+			int  _rows;
+
+			std::vector<std::string> _files;
+			std::vector<int>         _tiled;
+			float                    _tiledAbove;
+
+			std::shared_ptr<VisibilityScope> _imageScope;
+			std::shared_ptr<TiledImageView>  _tiledView;
+
+			std::atomic<bool> _thumbnailsReady;
+			PollThrottle      _poll;
 		};
 
 		class Logger : public sg::Agent<Logger, sg::Accepts<sg_gui::SetImage, sg_gui::MouseDown>> {
@@ -111,18 +387,27 @@ int main(int argc, char** argv) {
 
 		// visualize
 
-		auto controller = std::make_shared<Controller>();
+		auto controller = std::make_shared<Controller>(
+				optionPrefetch.as<int>(),
+				optionGridColumns.as<int>(),
+				optionGridRows.as<int>(),
+				optionTiledAbove.as<float>());
 		auto logger     = std::make_shared<Logger>();
 		auto imageView  = std::make_shared<ImageView>();
+		auto imageScope = std::make_shared<VisibilityScope>();
+		auto tiledView  = std::make_shared<TiledImageView>();
 		auto zoomView   = std::make_shared<ZoomView>(true);
 		auto window     = std::make_shared<sg_gui::Window>("image_viewer");
 
 		window->add(zoomView);
-		zoomView->add(imageView);
+		zoomView->add(imageScope);
+		zoomView->add(tiledView);
 		zoomView->add(controller);
-		zoomView->add(logger);
+		imageScope->add(imageView);
+		imageScope->add(logger);
 
-		controller->setImages(images);
+		controller->setViews(imageScope, tiledView);
+		controller->setImages(cache, thumbnails, files);
 
 		window->processEvents();
 
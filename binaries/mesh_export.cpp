@@ -0,0 +1,123 @@
+/**
+ * This programs extracts meshes of labels in a volume and writes them to
+ * files.
+ */
+
+#include <boost/lexical_cast.hpp>
+#include <util/ProgramOptions.h>
+#include <util/string.h>
+#include <imageprocessing/ExplicitVolume.h>
+#include <io/volumes.h>
+#include <io/meshes.h>
+#include <io/Hdf5VolumeReader.h>
+#include <analysis/LabelStatistics.h>
+#include <analysis/MeshExporter.h>
+
+util::ProgramOption optionLabels(
+		util::_long_name        = "labels",
+		util::_description_text = "The label volume, a directory of images or <hdf_file>:<dataset>.",
+		util::_is_positional    = true);
+
+util::ProgramOption optionIds(
+		util::_long_name        = "ids",
+		util::_description_text = "Comma separated ids of the labels to export. Default is all labels.");
+
+util::ProgramOption optionLargest(
+		util::_long_name        = "largest",
+		util::_description_text = "Export only the given number of largest labels.");
+
+util::ProgramOption optionOutput(
+		util::_long_name        = "out",
+		util::_description_text = "The directory to write the meshes to, as <id>.<format>. Default is meshes.",
+		util::_default_value    = "meshes");
+
+util::ProgramOption optionFormat(
+		util::_long_name        = "format",
+		util::_description_text = "The mesh format, 'ply' (binary), 'obj', or 'glb' (binary glTF). Default is ply.",
+		util::_default_value    = "ply");
+
+util::ProgramOption optionTranspose(
+		util::_long_name        = "transpose",
+		util::_description_text = "Invert the order of the axises of the label volume.");
+
+util::ProgramOption optionResX(
+		util::_long_name        = "resX",
+		util::_description_text = "x resolution of the label volume.");
+util::ProgramOption optionResY(
+		util::_long_name        = "resY",
+		util::_description_text = "y resolution of the label volume.");
+util::ProgramOption optionResZ(
+		util::_long_name        = "resZ",
+		util::_description_text = "z resolution of the label volume.");
+
+util::ProgramOption optionNumThreads(
+		util::_long_name        = "numThreads",
+		util::_description_text = "The number of threads to use. Default is one per core.",
+		util::_default_value    = 0);
+
+void readLabels(ExplicitVolume<uint64_t>& labels, std::string option) {
+
+	size_t sepPos = option.find_first_of(":");
+	if (sepPos != std::string::npos) {
+
+		vigra::HDF5File file(option.substr(0, sepPos), vigra::HDF5File::OpenMode::ReadOnly);
+		Hdf5VolumeReader hdfReader(file);
+		hdfReader.readVolume(labels, option.substr(sepPos + 1));
+
+	} else {
+
+		readVolume(labels, getImageFiles(option));
+	}
+
+	if (optionResX || optionResY || optionResZ)
+		labels.setResolution(util::point<float, 3>(optionResX, optionResY, optionResZ));
+}
+
+int main(int argc, char** argv) {
+
+	try {
+
+		util::ProgramOptions::init(argc, argv);
+		logger::LogManager::init();
+
+		if (!optionLabels)
+			UTIL_THROW_EXCEPTION(
+					UsageError,
+					"usage: mesh_export <labels> [--ids <id,id,...>] [--out meshes] [--format ply|obj|glb]");
+
+		MeshFormat format = getMeshFormat(optionFormat);
+
+		auto labels = std::make_shared<ExplicitVolume<uint64_t>>();
+		readLabels(*labels, optionLabels);
+
+		if (optionTranspose)
+			labels->transpose();
+
+		auto statistics = std::make_shared<LabelStatistics>(*labels, optionNumThreads.as<unsigned int>());
+
+		std::vector<uint64_t> ids;
+
+		if (optionIds) {
+
+			for (const std::string& token : split(optionIds, ','))
+				ids.push_back(boost::lexical_cast<uint64_t>(token));
+
+		} else if (optionLargest) {
+
+			ids = statistics->getLargest(optionLargest.as<size_t>());
+
+		} else {
+
+			ids = statistics->getIds();
+		}
+
+		LOG_USER(logger::out) << "exporting " << ids.size() << " meshes to " << optionOutput.as<std::string>() << std::endl;
+
+		MeshExporter exporter(labels, statistics, optionOutput, format, optionNumThreads.as<unsigned int>());
+		exporter.exportMeshes(ids);
+
+	} catch (boost::exception& e) {
+
+		handleException(e, std::cerr);
+	}
+}
@@ -0,0 +1,64 @@
+/**
+ * This programs computes edge match scores between two skeletons.
+ */
+
+#include <util/ProgramOptions.h>
+#include <imageprocessing/Skeleton.h>
+#include <io/skeletons.h>
+#include <analysis/SkeletonComparison.h>
+
+util::ProgramOption optionSkeleton(
+		util::_long_name        = "skeleton",
+		util::_description_text = "The source skeleton.",
+		util::_is_positional    = true);
+
+util::ProgramOption optionCompareSkeleton(
+		util::_long_name        = "compare",
+		util::_description_text = "The target skeleton.");
+
+util::ProgramOption optionMaxDistance(
+		util::_long_name        = "maxDistance",
+		util::_description_text = "The distance in world units from which on edges do not match anymore. Default is 10.",
+		util::_default_value    = 10.0);
+
+util::ProgramOption optionOutput(
+		util::_long_name        = "out",
+		util::_description_text = "The file to write the scores to, as lines of <e> <f> <score>. Default is scores.dat.",
+		util::_default_value    = "scores.dat");
+
+util::ProgramOption optionNumThreads(
+		util::_long_name        = "numThreads",
+		util::_description_text = "The number of threads to use. Default is one per core.",
+		util::_default_value    = 0);
+
+int main(int argc, char** argv) {
+
+	try {
+
+		util::ProgramOptions::init(argc, argv);
+		logger::LogManager::init();
+
+		if (!optionSkeleton || !optionCompareSkeleton)
+			UTIL_THROW_EXCEPTION(
+					UsageError,
+					"usage: skeleton_compare <skeleton> --compare <skeleton>");
+
+		Skeleton source;
+		Skeleton target;
+		readSkeleton(optionSkeleton, source);
+		readSkeleton(optionCompareSkeleton, target);
+
+		SkeletonComparison comparison(optionMaxDistance.as<float>(), optionNumThreads.as<unsigned int>());
+
+		std::vector<SkeletonComparison::Match> matches = comparison.match(source, target);
+		SkeletonComparison::write(matches, optionOutput.as<std::string>());
+
+		LOG_USER(logger::out)
+				<< "wrote " << matches.size() << " scores to "
+				<< optionOutput.as<std::string>() << std::endl;
+
+	} catch (boost::exception& e) {
+
+		handleException(e, std::cerr);
+	}
+}
@@ -0,0 +1,263 @@
+/**
+ * This programs computes summary statistics of many skeletons.
+ */
+
+#include <condition_variable>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <boost/filesystem.hpp>
+#include <util/ProgramOptions.h>
+#include <util/string.h>
+#include <imageprocessing/Skeleton.h>
+#include <io/skeletons.h>
+#include <io/ThreadPool.h>
+#include <analysis/FlatSkeleton.h>
+#include <analysis/SkeletonMetrics.h>
+
+util::ProgramOption optionSkeletons(
+		util::_long_name        = "skeletons",
+		util::_description_text = "Skeleton files or directories containing skeleton files in the ITK graph format, separated "
+		                          "by colons. Directories are searched recursively.",
+		util::_is_positional    = true);
+
+util::ProgramOption optionExtension(
+		util::_long_name        = "extension",
+		util::_description_text = "Only consider files with this extension (like '.txt') in directories. Default is all files.");
+
+util::ProgramOption optionOutput(
+		util::_long_name        = "out",
+		util::_description_text = "The file to write the metrics to. Default is metrics.csv.",
+		util::_default_value    = "metrics.csv");
+
+util::ProgramOption optionFormat(
+		util::_long_name        = "format",
+		util::_description_text = "The output format, 'csv' or 'json'. Default is csv.",
+		util::_default_value    = "csv");
+
+util::ProgramOption optionNumThreads(
+		util::_long_name        = "numThreads",
+		util::_description_text = "The number of threads to use. Default is one per core.",
+		util::_default_value    = 0);
+
+std::vector<std::string>
+getSkeletonFiles(const std::string& paths) {
+
+	std::vector<std::string> files;
+
+	for (const std::string& path : split(paths, ':')) {
+
+		boost::filesystem::path p(path);
+
+		if (!boost::filesystem::is_directory(p)) {
+
+			files.push_back(path);
+			continue;
+		}
+
+		std::vector<std::string> dirFiles;
+
+		for (boost::filesystem::recursive_directory_iterator i(p); i != boost::filesystem::recursive_directory_iterator(); i++)
+			if (boost::filesystem::is_regular_file(*i) &&
+			    (!optionExtension || i->path().extension() == optionExtension.as<std::string>()))
+				dirFiles.push_back(i->path().native());
+
+		std::sort(dirFiles.begin(), dirFiles.end());
+		files.insert(files.end(), dirFiles.begin(), dirFiles.end());
+	}
+
+	return files;
+}
+
+std::string
+quoteCsv(const std::string& s) {
+
+	if (s.find_first_of(",\"\n") == std::string::npos)
+		return s;
+
+	std::string quoted = "\"";
+	for (char c : s) {
+
+		if (c == '"')
+			quoted += '"';
+		quoted += c;
+	}
+
+	return quoted + "\"";
+}
+
+std::string
+quoteJson(const std::string& s) {
+
+	std::string quoted = "\"";
+	for (char c : s) {
+
+		if (c == '"' || c == '\\')
+			quoted += '\\';
+		quoted += c;
+	}
+
+	return quoted + "\"";
+}
+
+std::string
+toCsv(const std::string& file, uint64_t id, const SkeletonMetrics& m) {
+
+	std::stringstream line;
+	line.precision(10);
+
+	line
+			<< quoteCsv(file) << "," << id << ","
+			<< m.numNodes << "," << m.numEdges << ","
+			<< m.numBranches << "," << m.numLeaves << ","
+			<< m.cableLength << "," << m.meanDiameter << ","
+			<< m.boundingBox.min().x() << "," << m.boundingBox.min().y() << "," << m.boundingBox.min().z() << ","
+			<< m.boundingBox.max().x() << "," << m.boundingBox.max().y() << "," << m.boundingBox.max().z() << ",\n";
+
+	return line.str();
+}
+
+std::string
+errorToCsv(const std::string& file, const std::string& error) {
+
+	return quoteCsv(file) + ",,,,,,,,,,,,,," + quoteCsv(error) + "\n";
+}
+
+std::string
+toJson(const std::string& file, uint64_t id, const SkeletonMetrics& m) {
+
+	std::stringstream line;
+	line.precision(10);
+
+	line
+			<< "{\"file\": " << quoteJson(file) << ", \"id\": " << id
+			<< ", \"nodes\": " << m.numNodes << ", \"edges\": " << m.numEdges
+			<< ", \"branches\": " << m.numBranches << ", \"leaves\": " << m.numLeaves
+			<< ", \"cable_length\": " << m.cableLength << ", \"mean_diameter\": " << m.meanDiameter
+			<< ", \"bounding_box\": ["
+			<< m.boundingBox.min().x() << ", " << m.boundingBox.min().y() << ", " << m.boundingBox.min().z() << ", "
+			<< m.boundingBox.max().x() << ", " << m.boundingBox.max().y() << ", " << m.boundingBox.max().z() << "]}";
+
+	return line.str();
+}
+
+std::string
+errorToJson(const std::string& file, const std::string& error) {
+
+	return "{\"file\": " + quoteJson(file) + ", \"error\": " + quoteJson(error) + "}";
+}
+
+int main(int argc, char** argv) {
+
+	try {
+
+		util::ProgramOptions::init(argc, argv);
+		logger::LogManager::init();
+
+		if (!optionSkeletons)
+			UTIL_THROW_EXCEPTION(
+					UsageError,
+					"usage: skeleton_metrics <files or directories> [--out metrics.csv] [--format csv|json]");
+
+		bool json = (optionFormat.as<std::string>() == "json");
+		if (!json && optionFormat.as<std::string>() != "csv")
+			UTIL_THROW_EXCEPTION(
+					UsageError,
+					"unknown format " << optionFormat.as<std::string>() << ", expected csv or json");
+
+		std::vector<std::string> files = getSkeletonFiles(optionSkeletons);
+
+		LOG_USER(logger::out) << "computing metrics of " << files.size() << " skeletons" << std::endl;
+
+		std::ofstream out(optionOutput.as<std::string>().c_str());
+		if (!out.good())
+			UTIL_THROW_EXCEPTION(
+					IOError,
+					"can not write " << optionOutput.as<std::string>());
+
+		if (json)
+			out << "[\n";
+		else
+			out << "file,id,nodes,edges,branches,leaves,cable_length,mean_diameter,min_x,min_y,min_z,max_x,max_y,max_z,error\n";
+
+		// results are written in the order of the files as soon as all 
+		// previous ones are done, such that only a few have to be kept
+		std::mutex                    mutex;
+		std::condition_variable       written;
+		std::map<size_t, std::string> done;
+		size_t                        next = 0;
+
+		// the maximal number of files to process ahead of the next one to
+		// write, such that a slow file does not let the finished ones pile up
+		const size_t maxAhead = 1024;
+
+		{
+			ThreadPool pool(optionNumThreads.as<unsigned int>(), 256);
+
+			for (size_t i = 0; i < files.size(); i++) {
+
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					while (i >= next + maxAhead)
+						written.wait(lock);
+				}
+
+				pool.schedule([&, i]() {
+
+					std::string line;
+
+					// a file that can not be processed gets an error row, such
+					// that the files after it are still written
+					try {
+
+						Skeleton skeleton;
+						uint64_t id = readSkeleton(files[i], skeleton);
+
+						FlatSkeleton    flat(skeleton);
+						SkeletonMetrics metrics(flat);
+						line = (json ? toJson(files[i], id, metrics) : toCsv(files[i], id, metrics));
+
+					} catch (std::exception& e) {
+
+						LOG_ERROR(logger::out) << "can not process " << files[i] << ": " << e.what() << std::endl;
+						line = (json ? errorToJson(files[i], e.what()) : errorToCsv(files[i], e.what()));
+
+					} catch (...) {
+
+						LOG_ERROR(logger::out) << "can not process " << files[i] << std::endl;
+						line = (json ? errorToJson(files[i], "unknown error") : errorToCsv(files[i], "unknown error"));
+					}
+
+					std::lock_guard<std::mutex> lock(mutex);
+
+					done[i] = line;
+
+					for (auto j = done.find(next); j != done.end(); j = done.find(next)) {
+
+						if (json)
+							out << (next > 0 ? ",\n" : "") << j->second;
+						else
+							out << j->second;
+
+						done.erase(j);
+						next++;
+					}
+
+					written.notify_all();
+				});
+			}
+
+			pool.wait();
+		}
+
+		if (json)
+			out << "\n]\n";
+
+		LOG_USER(logger::out) << "wrote metrics to " << optionOutput.as<std::string>() << std::endl;
+
+	} catch (boost::exception& e) {
+
+		handleException(e, std::cerr);
+	}
+}
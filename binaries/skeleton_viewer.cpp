@@ -14,6 +14,7 @@
 #include <sg_gui/Window.h>
 #include <io/volumes.h>
 #include <io/skeletons.h>
+#include <analysis/SkeletonComparison.h>
 
 using namespace sg_gui;
 
@@ -30,6 +31,11 @@ util::ProgramOption optionEdgeMatchScores(
 		util::_description_text = "A file containing edge match scores between the two skeletons as lines of <e> <f> <score>. "
 		                          "If a directory is provided, load all score files in there.");
 
+util::ProgramOption optionMatchDistance(
+		util::_long_name        = "matchDistance",
+		util::_description_text = "If no edge match scores are given, compute them for edges of the two skeletons closer than "
+		                          "this distance in world units.");
+
 util::ProgramOption optionVolume(
 		util::_long_name        = "volume",
 		util::_description_text = "The volume to show around the skeleton.");
@@ -60,8 +66,8 @@ int main(int argc, char** argv) {
 		if (optionVolume) {
 
 			std::vector<std::string> files = getImageFiles(optionVolume.as<std::string>());
-			auto volume = std::make_shared<ExplicitVolume<float>>();
-			*volume = readVolume<float>(files);
+			volume = std::make_shared<ExplicitVolume<float>>();
+			readVolume(*volume, files);
 			volume->setResolution(util::point<float, 3>(optionResX, optionResY, optionResZ));
 		}
 
@@ -103,6 +109,14 @@ int main(int argc, char** argv) {
 				s->setTarget(skeletons->get(2));
 			}
 			skeletonView->setEdgeMatchScores(scores);
+
+		} else if (optionMatchDistance && optionCompareSkeleton) {
+
+			SkeletonComparison comparison(optionMatchDistance.as<float>());
+
+			std::vector<std::shared_ptr<SkeletonEdgeMatchScores>> scores;
+			scores.push_back(comparison.compare(skeletons->get(1), skeletons->get(2)));
+			skeletonView->setEdgeMatchScores(scores);
 		}
 
 		if (volume) {
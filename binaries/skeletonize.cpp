@@ -0,0 +1,167 @@
+/**
+ * This programs creates skeletons of labels in a volume.
+ */
+
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+#include <util/ProgramOptions.h>
+#include <util/string.h>
+#include <imageprocessing/ExplicitVolume.h>
+#include <io/volumes.h>
+#include <io/skeletons.h>
+#include <io/Hdf5VolumeReader.h>
+#include <analysis/LabelStatistics.h>
+#include <analysis/Skeletonizer.h>
+
+util::ProgramOption optionLabels(
+		util::_long_name        = "labels",
+		util::_description_text = "The label volume, a directory of images or <hdf_file>:<dataset>.",
+		util::_is_positional    = true);
+
+util::ProgramOption optionIds(
+		util::_long_name        = "ids",
+		util::_description_text = "Comma separated ids of the labels to skeletonize. Default is all labels.");
+
+util::ProgramOption optionLargest(
+		util::_long_name        = "largest",
+		util::_description_text = "Skeletonize only the given number of largest labels.");
+
+util::ProgramOption optionOutput(
+		util::_long_name        = "out",
+		util::_description_text = "The directory to write the skeletons to, as <id>.txt in the ITK graph format. Default is "
+		                          "skeletons.",
+		util::_default_value    = "skeletons");
+
+util::ProgramOption optionScale(
+		util::_long_name        = "scale",
+		util::_description_text = "The radius of the region covered by a skeleton path, relative to the distance to the "
+		                          "boundary of the label. Default is 4.",
+		util::_default_value    = 4);
+
+util::ProgramOption optionConstant(
+		util::_long_name        = "constant",
+		util::_description_text = "A constant added to the radius of the region covered by a skeleton path, in world units. "
+		                          "Default is 0.",
+		util::_default_value    = 0);
+
+util::ProgramOption optionMaxVoxels(
+		util::_long_name        = "maxVoxels",
+		util::_description_text = "The maximal size of the bounding box of a label in voxels. Larger labels are skeletonized at "
+		                          "a lower resolution. Default is 67108864.",
+		util::_default_value    = 64*1024*1024);
+
+util::ProgramOption optionTranspose(
+		util::_long_name        = "transpose",
+		util::_description_text = "Invert the order of the axises of the label volume.");
+
+util::ProgramOption optionResX(
+		util::_long_name        = "resX",
+		util::_description_text = "x resolution of the label volume.");
+util::ProgramOption optionResY(
+		util::_long_name        = "resY",
+		util::_description_text = "y resolution of the label volume.");
+util::ProgramOption optionResZ(
+		util::_long_name        = "resZ",
+		util::_description_text = "z resolution of the label volume.");
+
+util::ProgramOption optionNumThreads(
+		util::_long_name        = "numThreads",
+		util::_description_text = "The number of threads to use. Default is one per core.",
+		util::_default_value    = 0);
+
+void readLabels(ExplicitVolume<uint64_t>& labels, std::string option) {
+
+	size_t sepPos = option.find_first_of(":");
+	if (sepPos != std::string::npos) {
+
+		vigra::HDF5File file(option.substr(0, sepPos), vigra::HDF5File::OpenMode::ReadOnly);
+		Hdf5VolumeReader hdfReader(file);
+		hdfReader.readVolume(labels, option.substr(sepPos + 1));
+
+	} else {
+
+		readVolume(labels, getImageFiles(option));
+	}
+
+	if (optionResX || optionResY || optionResZ)
+		labels.setResolution(util::point<float, 3>(optionResX, optionResY, optionResZ));
+}
+
+int main(int argc, char** argv) {
+
+	try {
+
+		util::ProgramOptions::init(argc, argv);
+		logger::LogManager::init();
+
+		if (!optionLabels)
+			UTIL_THROW_EXCEPTION(
+					UsageError,
+					"usage: skeletonize <labels> [--ids <id,id,...>] [--out skeletons]");
+
+		auto labels = std::make_shared<ExplicitVolume<uint64_t>>();
+		readLabels(*labels, optionLabels);
+
+		if (optionTranspose)
+			labels->transpose();
+
+		auto statistics = std::make_shared<LabelStatistics>(*labels, optionNumThreads.as<unsigned int>());
+
+		std::vector<uint64_t> ids;
+
+		if (optionIds) {
+
+			for (const std::string& token : split(optionIds, ','))
+				ids.push_back(boost::lexical_cast<uint64_t>(token));
+
+		} else if (optionLargest) {
+
+			ids = statistics->getLargest(optionLargest.as<size_t>());
+
+		} else {
+
+			ids = statistics->getIds();
+		}
+
+		std::string directory = optionOutput;
+		boost::filesystem::create_directories(directory);
+
+		LOG_USER(logger::out) << "skeletonizing " << ids.size() << " labels" << std::endl;
+
+		Teasar::Parameters parameters;
+		parameters.scale    = optionScale;
+		parameters.constant = optionConstant;
+
+		Skeletonizer skeletonizer(
+				labels,
+				statistics,
+				parameters,
+				optionMaxVoxels.as<size_t>(),
+				optionNumThreads.as<unsigned int>());
+
+		size_t numWritten = 0;
+
+		// each skeleton is written as soon as it is done
+		skeletonizer.skeletonize(ids, [&](uint64_t id, std::shared_ptr<Skeleton> skeleton) {
+
+			if (lemon::countNodes(skeleton->graph()) == 0) {
+
+				LOG_USER(logger::out) << "label " << id << " does not exist, skipping it" << std::endl;
+				return;
+			}
+
+			std::string filename =
+					(boost::filesystem::path(directory) /
+					(boost::lexical_cast<std::string>(id) + ".txt")).native();
+
+			writeSkeleton(filename, *skeleton, id);
+			numWritten++;
+		});
+
+		LOG_USER(logger::out) << "wrote " << numWritten << " skeletons to " << directory << std::endl;
+
+	} catch (boost::exception& e) {
+
+		handleException(e, std::cerr);
+	}
+}
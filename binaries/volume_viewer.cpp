@@ -2,21 +2,35 @@
  * This programs visualizes a volume.
  */
 
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <sstream>
+#include <boost/lexical_cast.hpp>
 #include <util/ProgramOptions.h>
 #include <util/string.h>
 #include <imageprocessing/ExplicitVolume.h>
 #include <imageprocessing/Skeleton.h>
 #include <imageprocessing/Skeletons.h>
+#include <gui/CameraScope.h>
 #include <gui/OverlayView.h>
+#include <gui/RemoteControl.h>
 #include <gui/SegmentController.h>
+#include <gui/SegmentBatchScope.h>
 #include <gui/SkeletonView.h>
+#include <gui/SlabScope.h>
 #include <sg_gui/MeshView.h>
 #include <sg_gui/RotateView.h>
 #include <sg_gui/ZoomView.h>
 #include <sg_gui/Window.h>
 #include <io/volumes.h>
+#include <io/ImageStack.h>
 #include <io/skeletons.h>
 #include <io/Hdf5VolumeReader.h>
+#include <analysis/LabelStatistics.h>
+#include <analysis/MeshExporter.h>
+#include <analysis/Skeletonizer.h>
+#include <analysis/RegionAdjacencyGraph.h>
 
 using namespace sg_gui;
 
@@ -25,9 +39,15 @@ util::ProgramOption optionVolume(
 		util::_description_text = "The volume to show.",
 		util::_is_positional    = true);
 
+util::ProgramOption optionLazy(
+		util::_long_name        = "lazy",
+		util::_description_text = "If the volume is a directory of images, read the images on demand while stepping through the "
+		                          "stack instead of loading all of them at startup. Can not be combined with --transpose.");
+
 util::ProgramOption optionNormalizeVolume(
 		util::_long_name        = "normalize",
-		util::_description_text = "Normalize the intensities of the volume to show. Does not change the overlay.");
+		util::_description_text = "Normalize the intensities of the volume to show by adjusting the contrast window to the "
+		                          "range of values. Does not change the volume or the overlay.");
 
 util::ProgramOption optionTranspose(
 		util::_long_name        = "transpose",
@@ -42,6 +62,31 @@ util::ProgramOption optionOverlay(
 		util::_short_name       = "o",
 		util::_description_text = "A volume containing integer values to be shown as a label overlay.");
 
+util::ProgramOption optionChannels(
+		util::_long_name        = "channels",
+		util::_description_text = "A comma separated list of further volumes to blend over the volume, each in its own color "
+		                          "(red, green, blue, yellow, cyan, magenta). Same format as the volume.");
+
+util::ProgramOption optionChannelAlpha(
+		util::_long_name        = "channelAlpha",
+		util::_description_text = "The opacity of the channels.",
+		util::_default_value    = 0.5);
+
+util::ProgramOption optionLabelLayers(
+		util::_long_name        = "labelLayers",
+		util::_description_text = "A comma separated list of further label volumes to blend over the volume. Label 0 is "
+		                          "transparent. The axises are inverted as for the overlay.");
+
+util::ProgramOption optionLabelAlpha(
+		util::_long_name        = "labelAlpha",
+		util::_description_text = "The opacity of the label layers.",
+		util::_default_value    = 0.5);
+
+util::ProgramOption optionCacheSize(
+		util::_long_name        = "cacheSize",
+		util::_description_text = "The memory in MB to keep sections of volumes read on demand in, shared by all layers.",
+		util::_default_value    = 1024);
+
 util::ProgramOption optionResX(
 		util::_long_name        = "resX",
 		util::_description_text = "x resolution of the volume.");
@@ -56,6 +101,107 @@ util::ProgramOption optionSkeleton(
 		util::_long_name        = "skeleton",
 		util::_description_text = "Paths to a files containing skeletons to show. Files are separated by colons.");
 
+util::ProgramOption optionRoiBegin(
+		util::_long_name        = "roiBegin",
+		util::_description_text = "The begin of a region of interest as x,y,z in world units. If given, only the parts of the "
+		                          "volume, overlay, and skeletons inside the region of interest are read.");
+
+util::ProgramOption optionRoiEnd(
+		util::_long_name        = "roiEnd",
+		util::_description_text = "The end of a region of interest as x,y,z in world units.");
+
+util::ProgramOption optionSlabSections(
+		util::_long_name        = "slabSections",
+		util::_description_text = "The number of sections on each side of the current one to show meshes and skeletons in, "
+		                          "when restricted to the current section (toggled with 't'). Default is 10.",
+		util::_default_value    = 10);
+
+util::ProgramOption optionSkeletonize(
+		util::_long_name        = "skeletonize",
+		util::_description_text = "Create the skeletons of shown segments of the overlay that don't have one with TEASAR.");
+
+util::ProgramOption optionTeasarScale(
+		util::_long_name        = "teasarScale",
+		util::_description_text = "The radius of the region covered by a skeleton path, relative to the distance to the "
+		                          "boundary of the segment. Default is 4.",
+		util::_default_value    = 4);
+
+util::ProgramOption optionTeasarConstant(
+		util::_long_name        = "teasarConstant",
+		util::_description_text = "A constant added to the radius of the region covered by a skeleton path, in world units. "
+		                          "Default is 0.",
+		util::_default_value    = 0);
+
+util::ProgramOption optionMeshDirectory(
+		util::_long_name        = "meshDirectory",
+		util::_description_text = "The directory to write the meshes of the visible segments to (with 'e'). Default is meshes.",
+		util::_default_value    = "meshes");
+
+util::ProgramOption optionMeshFormat(
+		util::_long_name        = "meshFormat",
+		util::_description_text = "The format of exported meshes, 'ply' (binary), 'obj', or 'glb' (binary glTF). Default is ply.",
+		util::_default_value    = "ply");
+
+util::ProgramOption optionCommandPipe(
+		util::_long_name        = "commandPipe",
+		util::_description_text = "A named pipe to read segment commands from (as entered with 'i'), one per line. It is "
+		                          "created if it does not exist.");
+
+util::ProgramOption optionRemoteControl(
+		util::_long_name        = "remoteControl",
+		util::_description_text = "A UNIX domain socket to create for other programs to control the viewer with, sending one "
+		                          "JSON command per line.");
+
+util::point<float,3> parsePoint(std::string option) {
+
+	std::vector<std::string> tokens = split(option, ',');
+
+	if (tokens.size() != 3)
+		UTIL_THROW_EXCEPTION(
+				UsageError,
+				"expected x,y,z, got " << option);
+
+	return util::point<float,3>(
+			boost::lexical_cast<float>(tokens[0]),
+			boost::lexical_cast<float>(tokens[1]),
+			boost::lexical_cast<float>(tokens[2]));
+}
+
+/**
+ * Get the region of interest from the command line. Returns false if none was 
+ * given.
+ */
+bool getRoi(util::box<float,3>& roi) {
+
+	if (!optionRoiBegin && !optionRoiEnd)
+		return false;
+
+	float inf = std::numeric_limits<float>::infinity();
+
+	util::point<float,3> begin(-inf, -inf, -inf);
+	util::point<float,3> end(inf, inf, inf);
+
+	if (optionRoiBegin)
+		begin = parsePoint(optionRoiBegin);
+	if (optionRoiEnd)
+		end = parsePoint(optionRoiEnd);
+
+	roi = util::box<float,3>(begin, end);
+
+	return true;
+}
+
+/**
+ * The resolution of volumes read from images.
+ */
+util::point<float,3> getImageResolution() {
+
+	if (optionResX || optionResY || optionResZ)
+		return util::point<float, 3>(optionResX, optionResY, optionResZ);
+
+	return util::point<float, 3>(1.0, 1.0, 1.0);
+}
+
 template <typename T>
 void readVolumeFromOption(ExplicitVolume<T>& volume, std::string option) {
 
@@ -68,7 +214,12 @@ void readVolumeFromOption(ExplicitVolume<T>& volume, std::string option) {
 
 		vigra::HDF5File file(hdfFileName, vigra::HDF5File::OpenMode::ReadOnly);
 		Hdf5VolumeReader hdfReader(file);
-		hdfReader.readVolume(volume, dataset);
+
+		util::box<float,3> roi;
+		if (getRoi(roi))
+			hdfReader.readVolume(volume, dataset, roi);
+		else
+			hdfReader.readVolume(volume, dataset);
 
 		if (optionResX || optionResY || optionResZ)
 			volume.setResolution(util::point<float, 3>(optionResX, optionResY, optionResZ));
@@ -77,9 +228,204 @@ void readVolumeFromOption(ExplicitVolume<T>& volume, std::string option) {
 	} else {
 
 		std::vector<std::string> files = getImageFiles(option);
-		volume = readVolume<float>(files);
-		if (optionResX || optionResY || optionResZ)
-			volume.setResolution(util::point<float, 3>(optionResX, optionResY, optionResZ));
+
+		util::box<float,3> roi;
+		if (getRoi(roi)) {
+
+			readVolume(volume, files, roi, getImageResolution());
+
+		} else {
+
+			readVolume(volume, files);
+			if (optionResX || optionResY || optionResZ)
+				volume.setResolution(util::point<float, 3>(optionResX, optionResY, optionResZ));
+		}
+	}
+}
+
+/**
+ * Get the adjacency graph of the overlay. The graph is cached in a file next
+ * to the overlay and only extracted if the cache is missing or outdated.
+ *
+ * @param transposed
+ *              Whether the axises of the overlay were inverted after
+ *              reading.
+ */
+std::shared_ptr<RegionAdjacencyGraph> getRegionAdjacencyGraph(
+		const ExplicitVolume<uint64_t>& overlay,
+		std::string option,
+		bool transposed) {
+
+	auto rag = std::make_shared<RegionAdjacencyGraph>();
+
+	std::string source;
+	std::string cacheFile;
+
+	size_t sepPos = option.find_first_of(":");
+	if (sepPos != std::string::npos) {
+
+		std::string dataset = option.substr(sepPos + 1);
+		std::replace(dataset.begin(), dataset.end(), '/', '_');
+
+		source    = option.substr(0, sepPos);
+		cacheFile = source + "." + dataset + ".rag";
+
+	} else {
+
+		source = option;
+		while (source.size() > 1 && source[source.size() - 1] == '/')
+			source = source.substr(0, source.size() - 1);
+
+		cacheFile = source + ".rag";
+	}
+
+	// identify the overlay by the files it was read from (a directory does
+	// not change when the images in it are rewritten), how it was read, and
+	// the part of it that was read
+	std::vector<std::string> files;
+	if (sepPos != std::string::npos)
+		files.push_back(source);
+	else
+		files = getImageFiles(source);
+
+	std::stringstream sources;
+	for (const std::string& file : files)
+		sources
+				<< file << " "
+				<< boost::filesystem::last_write_time(file) << " "
+				<< boost::filesystem::file_size(file) << "\n";
+
+	std::stringstream key;
+	key
+			<< "rag " << std::hex << std::hash<std::string>()(sources.str()) << std::dec
+			<< " transposed " << transposed
+			<< " " << overlay.getDiscreteBoundingBox().width()
+			<< " " << overlay.getDiscreteBoundingBox().height()
+			<< " " << overlay.getDiscreteBoundingBox().depth()
+			<< " " << overlay.getOffset();
+
+	if (rag->read(cacheFile, key.str()))
+		return rag;
+
+	LOG_USER(logger::out) << "extracting adjacency graph of overlay..." << std::endl;
+
+	rag->extract(overlay);
+	rag->write(cacheFile, key.str());
+
+	return rag;
+}
+
+VoxelType getVoxelTypeFromOption(std::string option) {
+
+	size_t sepPos = option.find_first_of(":");
+	if (sepPos != std::string::npos) {
+
+		std::string hdfFileName = option.substr(0, sepPos);
+		std::string dataset     = option.substr(sepPos + 1);
+
+		vigra::HDF5File file(hdfFileName, vigra::HDF5File::OpenMode::ReadOnly);
+		Hdf5VolumeReader hdfReader(file);
+		return hdfReader.getVoxelType(dataset);
+	}
+
+	return getVoxelType(getImageFiles(option));
+}
+
+/**
+ * Show a volume in the overlay view. A channel of -1 shows the volume as the
+ * raw volume, other channels are blended over it in their own color.
+ */
+template <typename T>
+void showRawVolume(OverlayView& overlayView, std::string option, int channel) {
+
+	static const float colors[6][3] = {
+		{1, 0, 0}, {0, 1, 0}, {0, 0, 1},
+		{1, 1, 0}, {0, 1, 1}, {1, 0, 1}
+	};
+
+	bool isHdf = (option.find_first_of(":") != std::string::npos);
+
+	if (optionLazy && !isHdf) {
+
+		// a transposed section would need a row of every image
+		if (optionTranspose)
+			UTIL_THROW_EXCEPTION(
+					UsageError,
+					"--lazy can not be combined with --transpose");
+
+		auto stack = std::make_shared<ImageStack<T>>(getImageFiles(option));
+		util::point<float,3> resolution = getImageResolution();
+		stack->setResolution(resolution);
+
+		util::box<float,3> roi;
+		if (getRoi(roi)) {
+
+			vigra::Shape3 begin, shape;
+			getDiscreteRoi(
+					roi,
+					vigra::Shape3(stack->width(), stack->height(), stack->depth()),
+					resolution,
+					util::point<float,3>(0, 0, 0),
+					begin,
+					shape);
+
+			stack->crop(begin, shape);
+			stack->setOffset(util::point<float,3>(
+					begin[0]*resolution.x(),
+					begin[1]*resolution.y(),
+					begin[2]*resolution.z()));
+		}
+
+		if (channel < 0) {
+
+			overlayView.setRawVolume(stack);
+
+		} else {
+
+			const float* color = colors[channel%6];
+			channel = overlayView.addRawLayer(stack, option, color[0], color[1], color[2], optionChannelAlpha.as<float>());
+		}
+
+	} else {
+
+		auto volume = std::make_shared<ExplicitVolume<T>>();
+		readVolumeFromOption(*volume, option);
+
+		if (optionTranspose)
+			volume->transpose();
+
+		if (channel < 0) {
+
+			overlayView.setRawVolume(volume);
+
+		} else {
+
+			const float* color = colors[channel%6];
+			channel = overlayView.addRawLayer(volume, option, color[0], color[1], color[2], optionChannelAlpha.as<float>());
+		}
+	}
+
+	if (optionNormalizeVolume)
+		overlayView.normalizeContrast(channel < 0 ? 0 : channel);
+}
+
+/**
+ * Read a volume in its native voxel type and show it in the overlay view.
+ */
+void showVolume(OverlayView& overlayView, std::string option, int channel) {
+
+	switch (getVoxelTypeFromOption(option)) {
+
+		case VoxelUint8:
+			showRawVolume<uint8_t>(overlayView, option, channel);
+			break;
+
+		case VoxelUint16:
+			showRawVolume<uint16_t>(overlayView, option, channel);
+			break;
+
+		default:
+			showRawVolume<float>(overlayView, option, channel);
 	}
 }
 
@@ -140,34 +486,38 @@ int main(int argc, char** argv) {
 		util::ProgramOptions::init(argc, argv);
 		logger::LogManager::init();
 
-		// read volume and overlay
+		// read overlay and skeletons
 
-		auto volume  = std::make_shared<ExplicitVolume<float>>();
 		auto overlay = std::make_shared<ExplicitVolume<uint64_t>>();
 		auto skeletons = std::make_shared<Skeletons>();
 
-		if (optionVolume)
-			readVolumeFromOption(*volume, optionVolume);
-
-		if (optionNormalizeVolume)
-			volume->normalize();
-
 		if (optionOverlay)
 			readVolumeFromOption(*overlay, optionOverlay);
 
-		if (optionTranspose)
-			volume->transpose();
-
 		if (optionTransposeOverlay && optionOverlay)
 			overlay->transpose();
 
+		auto labelStatistics = std::make_shared<LabelStatistics>(*overlay);
+
+		auto rag = std::make_shared<RegionAdjacencyGraph>();
+
+		if (optionOverlay) {
+
+			LOG_USER(logger::out) << "overlay contains " << labelStatistics->size() << " labels" << std::endl;
+
+			rag = getRegionAdjacencyGraph(*overlay, optionOverlay, optionTransposeOverlay);
+		}
+
 		if (optionSkeleton) {
 
+			util::box<float,3> roi;
+			bool clip = getRoi(roi);
+
 			std::vector<std::string> files = split(optionSkeleton, ':');
 			for (std::string file : files) {
 
 				auto skeleton = std::make_shared<Skeleton>();
-				size_t id = readSkeleton(file, *skeleton);
+				size_t id = readSkeleton(file, *skeleton, clip ? &roi : 0);
 				skeletons->add(id, skeleton);
 			}
 		}
@@ -176,29 +526,89 @@ int main(int argc, char** argv) {
 
 		auto overlayView        = std::make_shared<OverlayView>();
 		auto meshView           = std::make_shared<MeshView>(overlay);
-		auto segmentController  = std::make_shared<SegmentController>(overlay);
+		auto meshScope          = std::make_shared<SegmentBatchScope>();
+		auto slabScope          = std::make_shared<SlabScope>(optionSlabSections.as<unsigned int>());
+		auto segmentController  = std::make_shared<SegmentController>(overlay, labelStatistics, rag);
 		auto skeletonView       = std::make_shared<SkeletonView>();
 		auto rotateView         = std::make_shared<RotateView>();
+		auto cameraScope        = std::make_shared<CameraScope>();
 		auto zoomView           = std::make_shared<ZoomView>(true);
 		auto window             = std::make_shared<sg_gui::Window>("volume_viewer");
 		auto recorder           = std::make_shared<Recorder>(window);
 
 		window->add(zoomView);
 		window->add(recorder);
-		zoomView->add(rotateView);
+		zoomView->add(cameraScope);
+		cameraScope->add(rotateView);
+
+		if (optionRemoteControl)
+			window->add(std::make_shared<RemoteControl>(window, optionRemoteControl.as<std::string>()));
 
 		rotateView->add(overlayView);
-		overlayView->setRawVolume(volume);
 		overlayView->setLabelsVolume(overlay);
-		overlayView->add(meshView);
+
+		overlayView->setCacheSize(optionCacheSize.as<size_t>()*1024*1024);
+
+		// read the raw volume and the channels in their native voxel type
+
+		if (optionVolume)
+			showVolume(*overlayView, optionVolume, -1);
+
+		if (optionChannels) {
+
+			std::vector<std::string> channels = split(optionChannels, ',');
+			for (unsigned int i = 0; i < channels.size(); i++)
+				showVolume(*overlayView, channels[i], i);
+		}
+
+		if (optionLabelLayers) {
+
+			for (std::string option : split(optionLabelLayers, ',')) {
+
+				auto labels = std::make_shared<ExplicitVolume<uint64_t>>();
+				readVolumeFromOption(*labels, option);
+
+				if (optionTransposeOverlay)
+					labels->transpose();
+
+				overlayView->addLabelsLayer(labels, option, optionLabelAlpha.as<float>());
+			}
+		}
+
+		overlayView->add(slabScope);
+		slabScope->add(meshScope);
+		meshScope->add(meshView);
 		overlayView->add(segmentController);
 
-		if (skeletons->size() > 0) {
+		segmentController->setMeshExporter(
+				std::make_shared<MeshExporter>(
+						overlay,
+						labelStatistics,
+						optionMeshDirectory,
+						getMeshFormat(optionMeshFormat)));
+
+		if (optionCommandPipe)
+			segmentController->listen(optionCommandPipe.as<std::string>());
+
+		if (skeletons->size() > 0 || (optionSkeletonize && optionOverlay)) {
 
-			overlayView->add(skeletonView);
+			slabScope->add(skeletonView);
 			skeletonView->setSkeletons(skeletons);
 		}
 
+		if (optionSkeletonize && optionOverlay) {
+
+			Teasar::Parameters parameters;
+			parameters.scale    = optionTeasarScale;
+			parameters.constant = optionTeasarConstant;
+
+			skeletonView->setSkeletonizer(
+					std::make_shared<Skeletonizer>(
+							overlay,
+							labelStatistics,
+							parameters));
+		}
+
 		window->processEvents();
 
 	} catch (boost::exception& e) {
@@ -0,0 +1,228 @@
+#include <algorithm>
+#include <cmath>
+#include <util/Logger.h>
+#include "CameraScope.h"
+
+logger::LogChannel camerascopelog("camerascopelog", "[CameraScope] ");
+
+CameraScope::CameraScope() :
+	_zoom(1.0),
+	_angles(0, 0, 0),
+	_center(0, 0, 0),
+	_haveCenter(false),
+	_contentCenter(0, 0, 0) {
+
+	update();
+}
+
+void
+CameraScope::onSignal(SetZoom& signal) {
+
+	if (signal.getZoom() <= 0)
+		return;
+
+	LOG_DEBUG(camerascopelog) << "setting zoom to " << signal.getZoom() << std::endl;
+
+	_zoom = signal.getZoom();
+	update();
+
+	send<sg_gui::ContentChanged>();
+}
+
+void
+CameraScope::onSignal(SetRotation& signal) {
+
+	LOG_DEBUG(camerascopelog) << "setting rotation to " << signal.getAngles() << std::endl;
+
+	_angles = signal.getAngles();
+	update();
+
+	send<sg_gui::ContentChanged>();
+}
+
+void
+CameraScope::onSignal(SetCenter& signal) {
+
+	LOG_DEBUG(camerascopelog) << "setting center to " << signal.getCenter() << std::endl;
+
+	_center     = signal.getCenter();
+	_haveCenter = true;
+	update();
+
+	send<sg_gui::ContentChanged>();
+}
+
+void
+CameraScope::onSignal(ResetView&) {
+
+	_zoom       = 1.0;
+	_angles     = util::point<float,3>(0, 0, 0);
+	_haveCenter = false;
+	update();
+
+	send<sg_gui::ContentChanged>();
+}
+
+void
+CameraScope::unfilterDown(sg_gui::QuerySize& signal) {
+
+	const util::box<float,3>& size = signal.getSize();
+
+	_contentCenter = util::point<float,3>(
+			0.5*(size.min().x() + size.max().x()),
+			0.5*(size.min().y() + size.max().y()),
+			0.5*(size.min().z() + size.max().z()));
+}
+
+bool
+CameraScope::filterDown(sg_gui::MouseDown& signal) {
+
+	if (!_transformed)
+		return true;
+
+	_ray = signal.ray;
+	signal.ray = util::ray<float,3>(toContent(_ray.position()), unrotate(_ray.direction()));
+
+	return true;
+}
+
+void
+CameraScope::unfilterDown(sg_gui::MouseDown& signal) {
+
+	if (!_transformed)
+		return;
+
+	signal.ray = _ray;
+}
+
+bool
+CameraScope::filterDown(sg_gui::KeyDown& signal) {
+
+	if (signal.key == sg_gui::keys::R && _transformed) {
+
+		ResetView reset;
+		onSignal(reset);
+	}
+
+	return true;
+}
+
+void
+CameraScope::update() {
+
+	const float toRadians = M_PI/180.0;
+
+	float cx = std::cos(_angles.x()*toRadians), sx = std::sin(_angles.x()*toRadians);
+	float cy = std::cos(_angles.y()*toRadians), sy = std::sin(_angles.y()*toRadians);
+	float cz = std::cos(_angles.z()*toRadians), sz = std::sin(_angles.z()*toRadians);
+
+	// same order as the glRotate calls in applyTransformation(), i.e.,
+	// Rz*Ry*Rx
+	float rx[9] = { 1, 0, 0,   0, cx, -sx,   0, sx, cx };
+	float ry[9] = { cy, 0, sy,   0, 1, 0,   -sy, 0, cy };
+	float rz[9] = { cz, -sz, 0,   sz, cz, 0,   0, 0, 1 };
+
+	float ryx[9];
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			ryx[i*3 + j] = ry[i*3]*rx[j] + ry[i*3 + 1]*rx[3 + j] + ry[i*3 + 2]*rx[6 + j];
+
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			_rotation[i*3 + j] = rz[i*3]*ryx[j] + rz[i*3 + 1]*ryx[3 + j] + rz[i*3 + 2]*ryx[6 + j];
+
+	_rotated     = (_angles.x() != 0 || _angles.y() != 0 || _angles.z() != 0);
+	_transformed = (_zoom != 1.0 || _rotated || _haveCenter);
+}
+
+void
+CameraScope::applyTransformation() {
+
+	util::point<float,3> center = getCenter();
+
+	glTranslatef(_contentCenter.x(), _contentCenter.y(), _contentCenter.z());
+	glScalef(_zoom, _zoom, _zoom);
+	glRotatef(_angles.z(), 0, 0, 1);
+	glRotatef(_angles.y(), 0, 1, 0);
+	glRotatef(_angles.x(), 1, 0, 0);
+	glTranslatef(-center.x(), -center.y(), -center.z());
+}
+
+util::point<float,3>
+CameraScope::toContent(const util::point<float,3>& p) const {
+
+	util::point<float,3> center = getCenter();
+
+	util::point<float,3> v = unrotate(util::point<float,3>(
+			(p.x() - _contentCenter.x())/_zoom,
+			(p.y() - _contentCenter.y())/_zoom,
+			(p.z() - _contentCenter.z())/_zoom));
+
+	return util::point<float,3>(
+			center.x() + v.x(),
+			center.y() + v.y(),
+			center.z() + v.z());
+}
+
+util::box<float,3>
+CameraScope::toContent(const util::box<float,3>& box) const {
+
+	bool boundedX = (box.max().x() > box.min().x());
+	bool boundedY = (box.max().y() > box.min().y());
+	bool boundedZ = (box.max().z() > box.min().z());
+
+	if (!_rotated) {
+
+		// axes without extent stay unbounded
+		util::point<float,3> min = toContent(box.min());
+		util::point<float,3> max = toContent(box.max());
+
+		return util::box<float,3>(
+				util::point<float,3>(
+						boundedX ? min.x() : box.min().x(),
+						boundedY ? min.y() : box.min().y(),
+						boundedZ ? min.z() : box.min().z()),
+				util::point<float,3>(
+						boundedX ? max.x() : box.max().x(),
+						boundedY ? max.y() : box.max().y(),
+						boundedZ ? max.z() : box.max().z()));
+	}
+
+	// an unbounded axis is unbounded in all directions after rotation
+	if (!boundedX || !boundedY || !boundedZ)
+		return util::box<float,3>(
+				util::point<float,3>(0, 0, 0),
+				util::point<float,3>(0, 0, 0));
+
+	util::point<float,3> min = toContent(box.min());
+	util::point<float,3> max = min;
+
+	for (int i = 1; i < 8; i++) {
+
+		util::point<float,3> corner = toContent(util::point<float,3>(
+				(i & 1 ? box.max().x() : box.min().x()),
+				(i & 2 ? box.max().y() : box.min().y()),
+				(i & 4 ? box.max().z() : box.min().z())));
+
+		min = util::point<float,3>(
+				std::min(min.x(), corner.x()),
+				std::min(min.y(), corner.y()),
+				std::min(min.z(), corner.z()));
+		max = util::point<float,3>(
+				std::max(max.x(), corner.x()),
+				std::max(max.y(), corner.y()),
+				std::max(max.z(), corner.z()));
+	}
+
+	return util::box<float,3>(min, max);
+}
+
+util::point<float,3>
+CameraScope::unrotate(const util::point<float,3>& v) const {
+
+	// the inverse of a rotation is its transpose
+	return util::point<float,3>(
+			_rotation[0]*v.x() + _rotation[3]*v.y() + _rotation[6]*v.z(),
+			_rotation[1]*v.x() + _rotation[4]*v.y() + _rotation[7]*v.z(),
+			_rotation[2]*v.x() + _rotation[5]*v.y() + _rotation[8]*v.z());
+}
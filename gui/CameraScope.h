@@ -0,0 +1,150 @@
+#ifndef TOOLS_GUI_CAMERA_SCOPE_H__
+#define TOOLS_GUI_CAMERA_SCOPE_H__
+
+#include <scopegraph/Scope.h>
+#include <sg_gui/GuiSignals.h>
+#include <sg_gui/KeySignals.h>
+#include <sg_gui/MouseSignals.h>
+#include <sg_gui/OpenGl.h>
+#include <util/box.hpp>
+#include <util/ray.hpp>
+#include "ViewSignals.h"
+
+/**
+ * Scope to set the view on its content programmatically, through SetZoom,
+ * SetRotation, SetCenter, and ResetView signals. The content is scaled and
+ * rotated around its center, or around the location given by SetCenter,
+ * which is moved to the center of the content. The regions of interest of
+ * draw signals and the rays of mouse signals are mapped back into the
+ * coordinates of the content, such that views inside do not need to know
+ * about the transformation. 'r' resets the view.
+ */
+class CameraScope :
+		public sg::Scope<
+				CameraScope,
+				sg::Accepts<
+						SetZoom,
+						SetRotation,
+						SetCenter,
+						ResetView
+				>,
+				sg::FiltersDown<
+						sg_gui::DrawOpaque,
+						sg_gui::Draw,
+						sg_gui::DrawTranslucent,
+						sg_gui::QuerySize,
+						sg_gui::MouseDown,
+						sg_gui::KeyDown
+				>,
+				sg::Provides<
+						sg_gui::ContentChanged
+				>,
+				sg::PassesUp<
+						sg_gui::ContentChanged,
+						sg_gui::VolumePointSelected
+				>
+		> {
+
+public:
+
+	CameraScope();
+
+	void onSignal(SetZoom& signal);
+
+	void onSignal(SetRotation& signal);
+
+	void onSignal(SetCenter& signal);
+
+	void onSignal(ResetView& signal);
+
+	bool filterDown(sg_gui::DrawOpaque& signal) { return transform(signal); }
+	void unfilterDown(sg_gui::DrawOpaque& signal) { untransform(signal); }
+
+	bool filterDown(sg_gui::Draw& signal) { return transform(signal); }
+	void unfilterDown(sg_gui::Draw& signal) { untransform(signal); }
+
+	bool filterDown(sg_gui::DrawTranslucent& signal) { return transform(signal); }
+	void unfilterDown(sg_gui::DrawTranslucent& signal) { untransform(signal); }
+
+	bool filterDown(sg_gui::QuerySize&) { return true; }
+	void unfilterDown(sg_gui::QuerySize& signal);
+
+	bool filterDown(sg_gui::MouseDown& signal);
+	void unfilterDown(sg_gui::MouseDown& signal);
+
+	bool filterDown(sg_gui::KeyDown& signal);
+	void unfilterDown(sg_gui::KeyDown&) {}
+
+private:
+
+	template <typename DrawSignal>
+	bool transform(DrawSignal& signal) {
+
+		if (!_transformed)
+			return true;
+
+		_roi        = signal.roi();
+		_resolution = signal.resolution();
+
+		signal.roi()        = toContent(_roi);
+		signal.resolution() = _resolution*_zoom;
+
+		glMatrixMode(GL_MODELVIEW);
+		glPushMatrix();
+		applyTransformation();
+
+		return true;
+	}
+
+	template <typename DrawSignal>
+	void untransform(DrawSignal& signal) {
+
+		if (!_transformed)
+			return;
+
+		glMatrixMode(GL_MODELVIEW);
+		glPopMatrix();
+
+		signal.roi()        = _roi;
+		signal.resolution() = _resolution;
+	}
+
+	// compute the rotation matrix and whether there is any transformation
+	void update();
+
+	void applyTransformation();
+
+	// the location that is moved to the center of the content
+	util::point<float,3> getCenter() const { return (_haveCenter ? _center : _contentCenter); }
+
+	// map a point of the view into the content
+	util::point<float,3> toContent(const util::point<float,3>& p) const;
+
+	// map a box of the view into the content, conservatively
+	util::box<float,3> toContent(const util::box<float,3>& box) const;
+
+	// rotate a vector by the inverse rotation
+	util::point<float,3> unrotate(const util::point<float,3>& v) const;
+
+	float                _zoom;
+	util::point<float,3> _angles;
+	util::point<float,3> _center;
+	bool                 _haveCenter;
+
+	// the center of the bounding box of the content
+	util::point<float,3> _contentCenter;
+
+	// row-major rotation matrix for _angles
+	float _rotation[9];
+	bool  _rotated;
+	bool  _transformed;
+
+	// the region of interest and resolution of the draw signal, and the ray of
+	// the mouse signal passing through
+	util::box<float,3>   _roi;
+	util::point<float,3> _resolution;
+	util::ray<float,3>   _ray;
+};
+
+#endif // TOOLS_GUI_CAMERA_SCOPE_H__
+
@@ -0,0 +1,171 @@
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <util/Logger.h>
+#include "CommandChannel.h"
+
+logger::LogChannel commandchannellog("commandchannellog", "[CommandChannel] ");
+
+// the maximal length of a command read from the pipe, longer ones are
+// discarded
+static const size_t MaxLineLength = 1024*1024;
+
+CommandChannel::CommandChannel() :
+	_commands(std::make_shared<Commands>()),
+	_listening(false),
+	_stop(false) {}
+
+CommandChannel::~CommandChannel() {
+
+	_stop = true;
+
+	if (_pipeThread.joinable())
+		_pipeThread.join();
+}
+
+void
+CommandChannel::readLine() {
+
+	{
+		std::lock_guard<std::mutex> lock(_commands->mutex);
+
+		if (_commands->readingLine)
+			return;
+
+		_commands->readingLine = true;
+	}
+
+	// detached, since reading from the console can not be interrupted
+	std::thread(&CommandChannel::readConsole, _commands).detach();
+}
+
+void
+CommandChannel::listen(const std::string& path) {
+
+	if (_listening)
+		return;
+
+	_listening = true;
+	_pipeThread = std::thread(&CommandChannel::readPipe, this, path);
+}
+
+bool
+CommandChannel::next(std::string& command) {
+
+	std::lock_guard<std::mutex> lock(_commands->mutex);
+
+	if (_commands->lines.empty())
+		return false;
+
+	command = _commands->lines.front();
+	_commands->lines.pop_front();
+
+	return true;
+}
+
+bool
+CommandChannel::busy() {
+
+	std::lock_guard<std::mutex> lock(_commands->mutex);
+
+	return _listening || _commands->readingLine || !_commands->lines.empty();
+}
+
+void
+CommandChannel::readConsole(std::shared_ptr<Commands> commands) {
+
+	std::string line;
+	std::getline(std::cin, line);
+
+	std::lock_guard<std::mutex> lock(commands->mutex);
+
+	commands->lines.push_back(line);
+	commands->readingLine = false;
+}
+
+void
+CommandChannel::readPipe(std::string path) {
+
+	if (mkfifo(path.c_str(), 0600) != 0 && errno != EEXIST) {
+
+		LOG_ERROR(commandchannellog) << "can not create command pipe " << path << ": " << std::strerror(errno) << std::endl;
+		_listening = false;
+		return;
+	}
+
+	// opened for reading and writing, such that the pipe stays open when
+	// writers come and go
+	int fd = open(path.c_str(), O_RDWR | O_NONBLOCK);
+
+	if (fd < 0) {
+
+		LOG_ERROR(commandchannellog) << "can not open command pipe " << path << ": " << std::strerror(errno) << std::endl;
+		_listening = false;
+		return;
+	}
+
+	LOG_USER(commandchannellog) << "reading commands from " << path << std::endl;
+
+	std::string partial;
+	char        buffer[4096];
+
+	// set while the rest of a too long line is skipped
+	bool discarding = false;
+
+	while (!_stop) {
+
+		// wake up regularly to see whether we should stop
+		pollfd p;
+		p.fd     = fd;
+		p.events = POLLIN;
+
+		if (poll(&p, 1, 100) <= 0)
+			continue;
+
+		ssize_t n = read(fd, buffer, sizeof(buffer));
+		if (n <= 0)
+			continue;
+
+		partial.append(buffer, n);
+
+		if (discarding) {
+
+			size_t end = partial.find('\n');
+			if (end == std::string::npos) {
+
+				partial.clear();
+				continue;
+			}
+
+			partial.erase(0, end + 1);
+			discarding = false;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(_commands->mutex);
+
+			size_t end;
+			while ((end = partial.find('\n')) != std::string::npos) {
+
+				_commands->lines.push_back(partial.substr(0, end));
+				partial.erase(0, end + 1);
+			}
+		}
+
+		if (partial.size() > MaxLineLength) {
+
+			LOG_ERROR(commandchannellog)
+					<< "discarding a command of more than " << MaxLineLength
+					<< " bytes from " << path << std::endl;
+
+			partial.clear();
+			discarding = true;
+		}
+	}
+
+	close(fd);
+}
@@ -0,0 +1,78 @@
+#ifndef TOOLS_GUI_COMMAND_CHANNEL_H__
+#define TOOLS_GUI_COMMAND_CHANNEL_H__
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * Reads text commands, one per line, on background threads, such that the
+ * GUI thread never blocks on input. Commands come from the console (a single
+ * line at a time, when asked for) or from a named pipe (FIFO) other local
+ * tools can write to. The GUI thread polls for commands with next().
+ */
+class CommandChannel {
+
+public:
+
+	CommandChannel();
+
+	/**
+	 * Stops listening on the named pipe. A pending console read can not be
+	 * interrupted and is abandoned.
+	 */
+	~CommandChannel();
+
+	/**
+	 * Read one line from the console in the background. Does nothing if a
+	 * line is being read already.
+	 */
+	void readLine();
+
+	/**
+	 * Read lines from the named pipe at the given path in the background,
+	 * until the channel is destroyed. The pipe is created if it does not
+	 * exist.
+	 */
+	void listen(const std::string& path);
+
+	/**
+	 * Get the next command. Returns false if there is none.
+	 */
+	bool next(std::string& command);
+
+	/**
+	 * True while a command is being read or waits to be taken, i.e., as long
+	 * as next() should be polled.
+	 */
+	bool busy();
+
+private:
+
+	// the commands read so far, shared with the console reader thread, which
+	// might outlive the channel while blocked on input
+	struct Commands {
+
+		Commands() : readingLine(false) {}
+
+		std::deque<std::string> lines;
+		std::mutex              mutex;
+		bool                    readingLine;
+	};
+
+	static void readConsole(std::shared_ptr<Commands> commands);
+
+	void readPipe(std::string path);
+
+	std::shared_ptr<Commands> _commands;
+
+	std::thread       _pipeThread;
+	std::atomic<bool> _listening;
+	std::atomic<bool> _stop;
+};
+
+#endif // TOOLS_GUI_COMMAND_CHANNEL_H__
+
@@ -0,0 +1,123 @@
+#include <algorithm>
+#include "ContrastShader.h"
+#include <util/Logger.h>
+
+logger::LogChannel contrastshaderlog("contrastshaderlog", "[ContrastShader] ");
+
+// fixed function vertex processing provides the texture coordinates, all we
+// need is the fragment stage
+static const char* contrastFragmentShader =
+		"#version 120\n"
+		"uniform sampler2D image;\n"
+		"uniform float windowMin;\n"
+		"uniform float windowWidth;\n"
+		"uniform float gamma;\n"
+		"void main() {\n"
+		"	vec4 texel = texture2D(image, gl_TexCoord[0].st);\n"
+		"	float v = clamp((texel.r - windowMin)/windowWidth, 0.0, 1.0);\n"
+		"	v = pow(v, 1.0/gamma);\n"
+		"	gl_FragColor = vec4(gl_Color.rgb*v, gl_Color.a*texel.a);\n"
+		"}\n";
+
+ContrastShader::ContrastShader() :
+	_program(0),
+	_prevProgram(0),
+	_compiled(false),
+	_failed(false),
+	_width(1.0),
+	_level(0.5),
+	_gamma(1.0) {}
+
+ContrastShader::~ContrastShader() {
+
+	if (!_compiled)
+		return;
+
+	sg_gui::OpenGl::Guard guard;
+
+	glDeleteProgram(_program);
+}
+
+void
+ContrastShader::setWindow(float width, float level) {
+
+	_width = std::max(width, 1e-6f);
+	_level = level;
+}
+
+void
+ContrastShader::setGamma(float gamma) {
+
+	_gamma = std::max(gamma, 1e-3f);
+}
+
+void
+ContrastShader::enable() {
+
+	if (!_compiled && !_failed)
+		compile();
+
+	if (_failed)
+		return;
+
+	glGetIntegerv(GL_CURRENT_PROGRAM, &_prevProgram);
+	glUseProgram(_program);
+
+	glUniform1i(glGetUniformLocation(_program, "image"), 0);
+	glUniform1f(glGetUniformLocation(_program, "windowMin"), _level - 0.5*_width);
+	glUniform1f(glGetUniformLocation(_program, "windowWidth"), _width);
+	glUniform1f(glGetUniformLocation(_program, "gamma"), _gamma);
+}
+
+void
+ContrastShader::disable() {
+
+	if (_failed)
+		return;
+
+	glUseProgram(_prevProgram);
+}
+
+void
+ContrastShader::compile() {
+
+	GLuint shader = glCreateShader(GL_FRAGMENT_SHADER);
+	glShaderSource(shader, 1, &contrastFragmentShader, 0);
+	glCompileShader(shader);
+
+	GLint status;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+
+	if (status != GL_TRUE) {
+
+		char log[1024];
+		glGetShaderInfoLog(shader, 1024, 0, log);
+		LOG_ERROR(contrastshaderlog) << "could not compile contrast shader: " << log << std::endl;
+
+		glDeleteShader(shader);
+		_failed = true;
+		return;
+	}
+
+	_program = glCreateProgram();
+	glAttachShader(_program, shader);
+	glLinkProgram(_program);
+
+	// the program keeps the shader alive as long as it needs it
+	glDeleteShader(shader);
+
+	glGetProgramiv(_program, GL_LINK_STATUS, &status);
+
+	if (status != GL_TRUE) {
+
+		char log[1024];
+		glGetProgramInfoLog(_program, 1024, 0, log);
+		LOG_ERROR(contrastshaderlog) << "could not link contrast shader: " << log << std::endl;
+
+		glDeleteProgram(_program);
+		_failed = true;
+		return;
+	}
+
+	_compiled = true;
+}
@@ -0,0 +1,64 @@
+#ifndef TOOLS_GUI_CONTRAST_SHADER_H__
+#define TOOLS_GUI_CONTRAST_SHADER_H__
+
+#include <sg_gui/OpenGl.h>
+
+/**
+ * A GLSL fragment program that maps the intensities of a textured raw image
+ * through a window/level transfer function followed by a gamma correction.
+ * Changing the contrast only changes the uniforms of the program, the voxel
+ * data itself is never touched.
+ *
+ * Intensities are given in texture units, i.e., normalized integer textures
+ * are in [0,1], float textures keep their values.
+ */
+class ContrastShader {
+
+public:
+
+	ContrastShader();
+
+	~ContrastShader();
+
+	/**
+	 * Set the width and the center of the intensity window.
+	 */
+	void setWindow(float width, float level);
+
+	/**
+	 * Set the gamma to apply after windowing.
+	 */
+	void setGamma(float gamma);
+
+	float getWindowWidth() const { return _width; }
+	float getWindowLevel() const { return _level; }
+	float getGamma() const { return _gamma; }
+
+	/**
+	 * Use the program for subsequent draw calls. Has to be called with a valid
+	 * OpenGl context. Falls back to the fixed function pipeline, if the program
+	 * could not be compiled.
+	 */
+	void enable();
+
+	/**
+	 * Restore the program that was active before the last call to enable().
+	 */
+	void disable();
+
+private:
+
+	void compile();
+
+	GLuint _program;
+	GLint  _prevProgram;
+	bool   _compiled;
+	bool   _failed;
+
+	float _width;
+	float _level;
+	float _gamma;
+};
+
+#endif // TOOLS_GUI_CONTRAST_SHADER_H__
+
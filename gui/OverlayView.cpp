@@ -1,28 +1,62 @@
 #include "OverlayView.h"
 #include <util/ProgramOptions.h>
+#include <util/Logger.h>
+
+logger::LogChannel overlayviewlog("overlayviewlog", "[OverlayView] ");
 
 util::ProgramOption optionShowNormals(
 		util::_long_name        = "showNormals",
 		util::_description_text = "Show the mesh normals.");
 
 OverlayView::OverlayView() :
-	_rawScope(std::make_shared<RawScope>()),
+	_cache(std::make_shared<SectionCache>()),
+	_selectedLayer(0),
 	_labelsScope(std::make_shared<LabelsScope>()),
-	_rawView(std::make_shared<sg_gui::VolumeView>()),
 	_labelsView(std::make_shared<sg_gui::VolumeView>()),
-	_alpha(1.0) {
+	_alpha(1.0),
+	_haveSection(false),
+	_sectionZ(0),
+	_sectionThickness(0) {
 
-	_rawScope->add(_rawView);
-	_labelsScope->add(_labelsView);
+	addLayer(std::make_shared<RawVolumeView>(_cache), "raw", true);
 
-	add(_rawScope);
+	_labelsScope->add(_labelsView);
 	add(_labelsScope);
 }
 
-void
-OverlayView::setRawVolume(std::shared_ptr<ExplicitVolume<float>> volume) {
+unsigned int
+OverlayView::addLabelsLayer(
+		std::shared_ptr<ExplicitVolume<uint64_t>> labels,
+		const std::string& name,
+		float alpha) {
+
+	auto view = std::make_shared<RawVolumeView>(_cache);
+	view->setPrimary(false);
+	view->setLabels(labels);
+	view->setAlpha(alpha);
+
+	unsigned int index = addLayer(view, name, false);
+	send<sg_gui::ContentChanged>();
+
+	return index;
+}
 
-	_rawView->setVolume(volume);
+unsigned int
+OverlayView::addLayer(std::shared_ptr<RawVolumeView> view, const std::string& name, bool contrast) {
+
+	Layer layer;
+	layer.name     = name;
+	layer.scope    = std::make_shared<RawScope>(contrast);
+	layer.view     = view;
+	layer.contrast = contrast;
+
+	_layers.push_back(layer);
+
+	// the view gets the current section when the scope is added
+	layer.scope->add(view);
+	add(layer.scope);
+
+	return _layers.size() - 1;
 }
 
 void
@@ -31,6 +65,30 @@ OverlayView::setLabelsVolume(std::shared_ptr<ExplicitVolume<uint64_t>> volume) {
 	//_labelsView->setVolume(volume);
 }
 
+void
+OverlayView::setContrast(float width, float level) {
+
+	_layers[_selectedLayer].scope->getContrastShader().setWindow(width, level);
+	send<sg_gui::ContentChanged>();
+}
+
+void
+OverlayView::setGamma(float gamma) {
+
+	_layers[_selectedLayer].scope->getContrastShader().setGamma(gamma);
+	send<sg_gui::ContentChanged>();
+}
+
+void
+OverlayView::normalizeContrast(unsigned int layer) {
+
+	float min, max;
+	_layers[layer].view->getIntensityRange(min, max);
+
+	_layers[layer].scope->getContrastShader().setWindow(max - min, 0.5*(max + min));
+	send<sg_gui::ContentChanged>();
+}
+
 void
 OverlayView::onSignal(sg_gui::KeyDown& signal) {
 
@@ -45,8 +103,101 @@ OverlayView::onSignal(sg_gui::KeyDown& signal) {
 
 	if (signal.key == sg_gui::keys::L) {
 
-		_rawScope->toggleZBufferWrites();
+		_layers[0].scope->toggleZBufferWrites();
 		_labelsScope->toggleVisibility();
 		send<sg_gui::ContentChanged>();
 	}
+
+	bool shift = (signal.modifiers & sg_gui::keys::ShiftDown);
+
+	// layer selection and visibility
+
+	if (signal.key == sg_gui::keys::V) {
+
+		Layer& selected = _layers[_selectedLayer];
+
+		if (shift) {
+
+			selected.view->setVisible(!selected.view->isVisible());
+
+			LOG_USER(overlayviewlog)
+					<< (selected.view->isVisible() ? "showing" : "hiding")
+					<< " layer " << selected.name << std::endl;
+
+		} else {
+
+			_selectedLayer = (_selectedLayer + 1)%_layers.size();
+
+			LOG_USER(overlayviewlog)
+					<< "selected layer " << _layers[_selectedLayer].name
+					<< (_layers[_selectedLayer].contrast ? "" : ", contrast controls do not apply to labels")
+					<< std::endl;
+		}
+	}
+
+	// contrast controls, shift inverts the direction
+
+	bool contrastKey =
+			signal.key == sg_gui::keys::W ||
+			signal.key == sg_gui::keys::B ||
+			signal.key == sg_gui::keys::G ||
+			signal.key == sg_gui::keys::X;
+
+	if (contrastKey && !_layers[_selectedLayer].contrast) {
+
+		LOG_USER(overlayviewlog)
+				<< "contrast controls do not apply to the labels layer "
+				<< _layers[_selectedLayer].name << ", select another one with 'v'" << std::endl;
+		return;
+	}
+
+	ContrastShader& contrast = _layers[_selectedLayer].scope->getContrastShader();
+
+	if (signal.key == sg_gui::keys::W) {
+
+		float width = contrast.getWindowWidth();
+		setContrast(shift ? width*1.1 : width/1.1, contrast.getWindowLevel());
+	}
+
+	if (signal.key == sg_gui::keys::B) {
+
+		float step = 0.05*contrast.getWindowWidth();
+		float level = contrast.getWindowLevel();
+		setContrast(contrast.getWindowWidth(), shift ? level + step : level - step);
+	}
+
+	if (signal.key == sg_gui::keys::G) {
+
+		float gamma = contrast.getGamma();
+		setGamma(shift ? gamma*1.1 : gamma/1.1);
+	}
+
+	if (signal.key == sg_gui::keys::X) {
+
+		setContrast(1.0, 0.5);
+		setGamma(1.0);
+	}
+
+	if (contrastKey)
+		LOG_USER(overlayviewlog)
+				<< "window " << contrast.getWindowWidth()
+				<< ", level " << contrast.getWindowLevel()
+				<< ", gamma " << contrast.getGamma() << std::endl;
+}
+
+void
+OverlayView::onInnerSignal(SectionChanged& signal) {
+
+	_haveSection      = true;
+	_sectionZ         = signal.getZ();
+	_sectionThickness = signal.getThickness();
+
+	sendInner(signal);
+}
+
+void
+OverlayView::onInnerSignal(sg::AgentAdded& /*signal*/) {
+
+	if (_haveSection)
+		sendInner<SectionChanged>(_sectionZ, _sectionThickness);
 }
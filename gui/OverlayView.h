@@ -1,10 +1,22 @@
 #ifndef TOOLS_GUI_OVERLAY_VIEW_H__
 #define TOOLS_GUI_OVERLAY_VIEW_H__
 
+#include <string>
+#include <vector>
 #include <scopegraph/Scope.h>
 #include <sg_gui/VolumeView.h>
 #include <sg_gui/KeySignals.h>
-
+#include "ContrastShader.h"
+#include "RawVolumeView.h"
+#include "SectionCache.h"
+
+/**
+ * Shows a raw volume and any number of layers on top of it, like prediction
+ * channels or segmentations, each with its own color and opacity. The
+ * sections of all layers are loaded into one SectionCache, such that they
+ * share a common memory budget. 'v' selects the layer the contrast controls
+ * act on (they don't apply to labels layers), 'Shift'+'v' shows or hides it.
+ */
 class OverlayView :
 		public sg::Scope<
 				OverlayView,
@@ -14,8 +26,13 @@ class OverlayView :
 				sg::Provides<
 						sg_gui::ContentChanged
 				>,
+				sg::AcceptsInner<
+						SectionChanged,
+						sg::AgentAdded
+				>,
 				sg::ProvidesInner<
-						sg_gui::ChangeAlpha
+						sg_gui::ChangeAlpha,
+						SectionChanged
 				>,
 				sg::PassesUp<
 						sg_gui::ContentChanged,
@@ -27,16 +44,94 @@ public:
 
 	OverlayView();
 
-	void setRawVolume(std::shared_ptr<ExplicitVolume<float>> volume);
+	/**
+	 * Set the raw volume to show, either an ExplicitVolume or an ImageStack of 
+	 * uint8_t, uint16_t, or float. The volume is shown in its native voxel 
+	 * type.
+	 */
+	template <typename Volume>
+	void setRawVolume(std::shared_ptr<Volume> volume) {
+
+		_layers[0].view->setVolume(volume);
+	}
+
+	/**
+	 * Add a volume to show on top of the raw volume (like a prediction
+	 * channel), in the same formats as setRawVolume(). Intensities are shown
+	 * in the given color, with the given opacity. Returns the index of the new
+	 * layer.
+	 */
+	template <typename Volume>
+	unsigned int addRawLayer(
+			std::shared_ptr<Volume> volume,
+			const std::string& name,
+			float r, float g, float b,
+			float alpha) {
+
+		auto view = std::make_shared<RawVolumeView>(_cache);
+		view->setPrimary(false);
+		view->setVolume(volume);
+		view->setColor(r, g, b);
+		view->setAlpha(alpha);
+
+		unsigned int index = addLayer(view, name, true);
+		send<sg_gui::ContentChanged>();
+
+		return index;
+	}
+
+	/**
+	 * Add a volume of labels to show on top of the raw volume, each label in a
+	 * random color with the given opacity. Returns the index of the new layer.
+	 */
+	unsigned int addLabelsLayer(
+			std::shared_ptr<ExplicitVolume<uint64_t>> labels,
+			const std::string& name,
+			float alpha);
+
+	/**
+	 * Set the memory budget for the loaded sections of all layers.
+	 */
+	void setCacheSize(size_t bytes) { _cache->setMaxBytes(bytes); }
 
 	void setLabelsVolume(std::shared_ptr<ExplicitVolume<uint64_t>> volume);
 
+	/**
+	 * Set the intensity window of the selected layer. Intensities outside the 
+	 * window will be clamped to black or white.
+	 */
+	void setContrast(float width, float level);
+
+	/**
+	 * Set the gamma correction to apply to the selected layer after 
+	 * windowing.
+	 */
+	void setGamma(float gamma);
+
+	/**
+	 * Set the intensity window of a layer to the range of its values. Layer 0 
+	 * is the raw volume.
+	 */
+	void normalizeContrast(unsigned int layer = 0);
+
 	void onSignal(sg_gui::KeyDown& signal);
 
+	/**
+	 * Forward changes of the current raw section to the other views, e.g., to
+	 * restrict them to a slab around it.
+	 */
+	void onInnerSignal(SectionChanged& signal);
+
+	/**
+	 * Tell views added later about the current section.
+	 */
+	void onInnerSignal(sg::AgentAdded& signal);
+
 private:
 
 	/**
-	 * Scope preventing change alpha signals to get to raw images.
+	 * Scope preventing change alpha signals to get to raw images. Draws the 
+	 * raw images through the contrast shader, if enabled.
 	 */
 	class RawScope : public sg::Scope<
 			RawScope,
@@ -45,13 +140,16 @@ private:
 					sg_gui::DrawOpaque
 			>,
 			sg::PassesUp<
-					sg_gui::ContentChanged
+					sg_gui::ContentChanged,
+					SectionChanged
 			>
 	> {
 
 	public:
 
-		RawScope() : _zBufferWrites(false) {}
+		RawScope(bool contrast) :
+			_zBufferWrites(false),
+			_contrast(contrast) {}
 
 		bool filterDown(sg_gui::ChangeAlpha&) { return false; }
 		void unfilterDown(sg_gui::ChangeAlpha&) {}
@@ -65,21 +163,32 @@ private:
 				glDepthMask(GL_FALSE);
 			}
 
+			if (_contrast)
+				_contrastShader.enable();
+
 			return true;
 		}
 
 		void unfilterDown(sg_gui::DrawOpaque&) {
 
+			if (_contrast)
+				_contrastShader.disable();
+
 			if (!_zBufferWrites)
 				glDepthMask(_prevDepthMask);
 		}
 
 		void toggleZBufferWrites() { _zBufferWrites = !_zBufferWrites; }
 
+		ContrastShader& getContrastShader() { return _contrastShader; }
+
 	private:
 
 		bool _zBufferWrites;
+		bool _contrast;
 		GLboolean _prevDepthMask;
+
+		ContrastShader _contrastShader;
 	};
 
 	/**
@@ -149,12 +258,35 @@ private:
 		bool _visible;
 	};
 
-	std::shared_ptr<RawScope>           _rawScope;
+	struct Layer {
+
+		std::string                    name;
+		std::shared_ptr<RawScope>      scope;
+		std::shared_ptr<RawVolumeView> view;
+
+		// false for labels, which are shown without contrast adjustment
+		bool contrast;
+	};
+
+	unsigned int addLayer(std::shared_ptr<RawVolumeView> view, const std::string& name, bool contrast);
+
+	std::shared_ptr<SectionCache> _cache;
+
+	// the raw volume first, then the other layers in the order they are drawn
+	std::vector<Layer> _layers;
+
+	// the layer the contrast controls act on
+	unsigned int _selectedLayer;
+
 	std::shared_ptr<LabelsScope>        _labelsScope;
-	std::shared_ptr<sg_gui::VolumeView> _rawView;
 	std::shared_ptr<sg_gui::VolumeView> _labelsView;
 
 	double _alpha;
+
+	// the last section shown of the raw volume
+	bool  _haveSection;
+	float _sectionZ;
+	float _sectionThickness;
 };
 
 #endif // TOOLS_GUI_OVERLAY_VIEW_H__
@@ -0,0 +1,25 @@
+#include <thread>
+#include "PollThrottle.h"
+
+PollThrottle::PollThrottle(double interval) :
+	_interval(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(interval))),
+	_last(Clock::now()) {
+
+	_view.fill(0);
+}
+
+void
+PollThrottle::wait(sg_gui::Draw& signal, bool active) {
+
+	std::array<float,9> view = {{
+			signal.roi().min().x(), signal.roi().min().y(), signal.roi().min().z(),
+			signal.roi().max().x(), signal.roi().max().y(), signal.roi().max().z(),
+			signal.resolution().x(), signal.resolution().y(), signal.resolution().z() }};
+
+	// the user is navigating or new input arrived, don't slow down
+	if (!active && view == _view)
+		std::this_thread::sleep_until(_last + _interval);
+
+	_view = view;
+	_last = Clock::now();
+}
@@ -0,0 +1,48 @@
+#ifndef TOOLS_GUI_POLL_THROTTLE_H__
+#define TOOLS_GUI_POLL_THROTTLE_H__
+
+#include <array>
+#include <chrono>
+#include <sg_gui/GuiSignals.h>
+
+/**
+ * Paces the frames an agent asks for to poll for input that arrives on other
+ * threads. Signals are only sent on the GUI thread, so such an agent asks for
+ * another frame from its draw handler for as long as it waits for input. To
+ * not redraw at full rate while nothing happens, a frame that shows the same
+ * view as the previous one is delayed until a minimal interval passed since
+ * then. Frames that change the view are not delayed.
+ */
+class PollThrottle {
+
+public:
+
+	/**
+	 * @param interval
+	 *              The minimal time between two frames of an unchanged view,
+	 *              in seconds.
+	 */
+	PollThrottle(double interval = 0.1);
+
+	/**
+	 * Call from the draw handler before asking for another frame to poll.
+	 *
+	 * @param active
+	 *              Whether input was handled with this frame, in which case
+	 *              it is not delayed.
+	 */
+	void wait(sg_gui::Draw& signal, bool active);
+
+private:
+
+	typedef std::chrono::steady_clock Clock;
+
+	Clock::duration   _interval;
+	Clock::time_point _last;
+
+	// the region of interest and resolution of the previous frame
+	std::array<float,9> _view;
+};
+
+#endif // TOOLS_GUI_POLL_THROTTLE_H__
+
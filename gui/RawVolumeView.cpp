@@ -0,0 +1,511 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include "RawVolumeView.h"
+#include <sg_gui/Colors.h>
+#include <util/Logger.h>
+
+logger::LogChannel rawvolumeviewlog("rawvolumeviewlog", "[RawVolumeView] ");
+
+const unsigned int RawVolumeView::BrickSize;
+const unsigned int RawVolumeView::TextureDistance;
+
+RawVolumeView::RawVolumeView(std::shared_ptr<SectionCache> cache) :
+	_cache(cache),
+	_internalFormat(GL_LUMINANCE8),
+	_format(GL_LUMINANCE),
+	_type(GL_UNSIGNED_BYTE),
+	_width(0),
+	_height(0),
+	_depth(0),
+	_section(0),
+	_bricksX(0),
+	_bricksY(0),
+	_visibleBeginX(0),
+	_visibleBeginY(0),
+	_visibleEndX(0),
+	_visibleEndY(0),
+	_alpha(1.0),
+	_visible(true),
+	_primary(true) {
+
+	_color[0] = _color[1] = _color[2] = 1.0;
+}
+
+RawVolumeView::~RawVolumeView() {
+
+	deleteTextures(true);
+}
+
+void
+RawVolumeView::setSections(
+		unsigned int width,
+		unsigned int height,
+		unsigned int depth,
+		const util::point<float,3>& resolution,
+		const util::point<float,3>& offset,
+		const util::box<float,3>& boundingBox,
+		GLint internalFormat,
+		GLenum format,
+		GLenum type,
+		SectionPrefetcher::Loader sectionLoader,
+		size_t sectionBytes,
+		IntensityRange intensityRange) {
+
+	deleteTextures(true);
+
+	_width          = width;
+	_height         = height;
+	_depth          = depth;
+	_resolution     = resolution;
+	_offset         = offset;
+	_boundingBox    = boundingBox;
+	_internalFormat = internalFormat;
+	_format         = format;
+	_type           = type;
+	_intensityRange = intensityRange;
+	_section        = 0;
+	_bricksX        = (width + BrickSize - 1)/BrickSize;
+	_bricksY        = (height + BrickSize - 1)/BrickSize;
+	_visibleBeginX  = 0;
+	_visibleBeginY  = 0;
+	_visibleEndX    = _bricksX;
+	_visibleEndY    = _bricksY;
+
+	_prefetcher.reset(new SectionPrefetcher(sectionLoader, depth, _cache, sectionBytes));
+	_prefetcher->setCurrentSection(0);
+
+	LOG_DEBUG(rawvolumeviewlog)
+			<< "showing volume of size " << _width << "x" << _height << "x" << _depth << std::endl;
+
+	if (_primary)
+		send<SectionChanged>(_offset.z(), _resolution.z());
+	send<sg_gui::ContentChanged>();
+}
+
+void
+RawVolumeView::setLabels(std::shared_ptr<ExplicitVolume<uint64_t>> labels) {
+
+	unsigned int width  = labels->getDiscreteBoundingBox().width();
+	unsigned int height = labels->getDiscreteBoundingBox().height();
+
+	auto sectionLoader = [labels, width, height](unsigned int z) -> SectionPrefetcher::Section {
+
+		// one RGBA color per voxel, transparent for the background
+		auto colors = std::make_shared<std::vector<unsigned char>>(4*width*height, 0);
+
+		const uint64_t* label = &labels->data()(0, 0, z);
+
+		uint64_t      previous = 0;
+		unsigned char r = 0, g = 0, b = 0;
+
+		for (size_t i = 0; i < (size_t)width*height; i++) {
+
+			if (label[i] == 0)
+				continue;
+
+			// labels come in runs, look up the color only when it changes
+			if (label[i] != previous) {
+
+				sg_gui::idToRgb(label[i], r, g, b);
+				previous = label[i];
+			}
+
+			(*colors)[4*i]     = r;
+			(*colors)[4*i + 1] = g;
+			(*colors)[4*i + 2] = b;
+			(*colors)[4*i + 3] = 255;
+		}
+
+		return SectionPrefetcher::Section(colors, colors->data());
+	};
+
+	auto intensityRange = [](unsigned int, float& min, float& max) {
+
+		min = 0;
+		max = 1;
+	};
+
+	setSections(
+			width,
+			height,
+			labels->getDiscreteBoundingBox().depth(),
+			labels->getResolution(),
+			labels->getOffset(),
+			labels->getBoundingBox(),
+			GL_RGBA8,
+			GL_RGBA,
+			GL_UNSIGNED_BYTE,
+			sectionLoader,
+			4*width*height,
+			intensityRange);
+}
+
+void
+RawVolumeView::setColor(float r, float g, float b) {
+
+	_color[0] = r;
+	_color[1] = g;
+	_color[2] = b;
+
+	send<sg_gui::ContentChanged>();
+}
+
+void
+RawVolumeView::setAlpha(float alpha) {
+
+	_alpha = alpha;
+
+	send<sg_gui::ContentChanged>();
+}
+
+void
+RawVolumeView::setVisible(bool visible) {
+
+	_visible = visible;
+
+	send<sg_gui::ContentChanged>();
+}
+
+void
+RawVolumeView::getIntensityRange(float& min, float& max) {
+
+	if (!_prefetcher) {
+
+		min = 0;
+		max = 1;
+		return;
+	}
+
+	_intensityRange(_section, min, max);
+}
+
+void
+RawVolumeView::onSignal(sg_gui::DrawOpaque& signal) {
+
+	if (!_prefetcher || _depth == 0 || !_visible)
+		return;
+
+	updateVisibleBricks(signal.roi());
+
+	// the current section, fetched only if one of its bricks is missing
+	SectionPrefetcher::Section data;
+
+	// labels are transparent where there are none
+	bool blend = (_alpha < 1.0 || _format == GL_RGBA);
+	bool wasBlending = glIsEnabled(GL_BLEND);
+
+	if (blend) {
+
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	}
+
+	float z = _offset.z() + _section*_resolution.z();
+
+	glEnable(GL_TEXTURE_2D);
+	glColor4f(_color[0], _color[1], _color[2], _alpha);
+
+	for (unsigned int brickY = _visibleBeginY; brickY < _visibleEndY; brickY++)
+		for (unsigned int brickX = _visibleBeginX; brickX < _visibleEndX; brickX++) {
+
+			auto key = std::make_pair(_section, brickY*_bricksX + brickX);
+
+			if (!_bricks.count(key)) {
+
+				if (!data)
+					data = _prefetcher->getSection(_section);
+
+				// the section failed to load, nothing to show
+				if (!data)
+					continue;
+
+				_bricks[key] = uploadBrick(_section, brickX, brickY, data);
+			}
+
+			float minX = _offset.x() + brickX*BrickSize*_resolution.x();
+			float minY = _offset.y() + brickY*BrickSize*_resolution.y();
+			float maxX = _offset.x() + std::min((brickX + 1)*BrickSize, _width)*_resolution.x();
+			float maxY = _offset.y() + std::min((brickY + 1)*BrickSize, _height)*_resolution.y();
+
+			glBindTexture(GL_TEXTURE_2D, _bricks[key]);
+
+			glBegin(GL_QUADS);
+			glTexCoord2f(0, 0); glVertex3f(minX, minY, z);
+			glTexCoord2f(1, 0); glVertex3f(maxX, minY, z);
+			glTexCoord2f(1, 1); glVertex3f(maxX, maxY, z);
+			glTexCoord2f(0, 1); glVertex3f(minX, maxY, z);
+			glEnd();
+		}
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glDisable(GL_TEXTURE_2D);
+
+	if (blend && !wasBlending)
+		glDisable(GL_BLEND);
+
+	// the current section is on screen, use the remaining time of this frame
+	// to get the next ones to the GPU
+	uploadPrefetched();
+}
+
+void
+RawVolumeView::onSignal(sg_gui::QuerySize& signal) {
+
+	if (!_prefetcher)
+		return;
+
+	signal.setSize(_boundingBox);
+}
+
+void
+RawVolumeView::onSignal(sg_gui::MouseDown& signal) {
+
+	if (!_prefetcher || !_primary)
+		return;
+
+	// wheel with modifiers is used for zooming and scaling
+	if (signal.modifiers & (sg_gui::keys::ControlDown | sg_gui::keys::ShiftDown))
+		return;
+
+	if (signal.button == sg_gui::buttons::WheelUp) {
+
+		if (_section + 1 < _depth)
+			setCurrentSection(_section + 1);
+
+		signal.processed = true;
+	}
+
+	if (signal.button == sg_gui::buttons::WheelDown) {
+
+		if (_section > 0)
+			setCurrentSection(_section - 1);
+
+		signal.processed = true;
+	}
+
+	if (signal.button == sg_gui::buttons::Left) {
+
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+		if (now - _lastLeftClick < std::chrono::milliseconds(300))
+			selectPoint(signal.ray);
+
+		_lastLeftClick = now;
+	}
+}
+
+void
+RawVolumeView::onSignal(SetSection& signal) {
+
+	if (!_prefetcher || !_primary)
+		return;
+
+	unsigned int z = getSection(signal.getZ());
+
+	if (z != _section)
+		setCurrentSection(z);
+}
+
+void
+RawVolumeView::onSignal(SectionChanged& signal) {
+
+	if (!_prefetcher || _primary)
+		return;
+
+	// follow the primary view, to the section containing the center of its
+	// current one
+	unsigned int z = getSection(signal.getZ() + 0.5*signal.getThickness());
+
+	if (z != _section)
+		setCurrentSection(z, false);
+}
+
+unsigned int
+RawVolumeView::getSection(float z) const {
+
+	int section = std::floor((z - _offset.z())/_resolution.z());
+
+	return std::max(0, std::min((int)_depth - 1, section));
+}
+
+void
+RawVolumeView::setCurrentSection(unsigned int z, bool notify) {
+
+	_section = z;
+	_prefetcher->setCurrentSection(z);
+
+	if (notify)
+		send<SectionChanged>(_offset.z() + _section*_resolution.z(), _resolution.z());
+	send<sg_gui::ContentChanged>();
+}
+
+void
+RawVolumeView::updateVisibleBricks(const util::box<float,3>& roi) {
+
+	// an empty region of interest does not restrict anything
+	_visibleBeginX = 0;
+	_visibleBeginY = 0;
+	_visibleEndX   = _bricksX;
+	_visibleEndY   = _bricksY;
+
+	float brickWidth  = BrickSize*_resolution.x();
+	float brickHeight = BrickSize*_resolution.y();
+
+	if (roi.max().x() > roi.min().x()) {
+
+		float begin = std::floor((roi.min().x() - _offset.x())/brickWidth);
+		float end   = std::ceil((roi.max().x() - _offset.x())/brickWidth);
+
+		_visibleBeginX = std::min((float)_bricksX, std::max(0.0f, begin));
+		_visibleEndX   = std::min((float)_bricksX, std::max(0.0f, end));
+	}
+
+	if (roi.max().y() > roi.min().y()) {
+
+		float begin = std::floor((roi.min().y() - _offset.y())/brickHeight);
+		float end   = std::ceil((roi.max().y() - _offset.y())/brickHeight);
+
+		_visibleBeginY = std::min((float)_bricksY, std::max(0.0f, begin));
+		_visibleEndY   = std::min((float)_bricksY, std::max(0.0f, end));
+	}
+}
+
+GLuint
+RawVolumeView::uploadBrick(unsigned int z, unsigned int brickX, unsigned int brickY, SectionPrefetcher::Section data) {
+
+	unsigned int beginX = brickX*BrickSize;
+	unsigned int beginY = brickY*BrickSize;
+	unsigned int width  = std::min(BrickSize, _width - beginX);
+	unsigned int height = std::min(BrickSize, _height - beginY);
+
+	// don't mix the colors of neighboring labels
+	GLint minFilter = (_format == GL_RGBA ? GL_NEAREST : GL_LINEAR);
+
+	GLuint texture;
+
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	// read the brick straight out of the section
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, _width);
+	glPixelStorei(GL_UNPACK_SKIP_PIXELS, beginX);
+	glPixelStorei(GL_UNPACK_SKIP_ROWS, beginY);
+
+	glTexImage2D(
+			GL_TEXTURE_2D,
+			0,
+			_internalFormat,
+			width,
+			height,
+			0,
+			_format,
+			_type,
+			data.get());
+
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+	glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	LOG_ALL(rawvolumeviewlog) << "uploaded brick " << brickX << ", " << brickY << " of section " << z << std::endl;
+
+	return texture;
+}
+
+void
+RawVolumeView::uploadPrefetched() {
+
+	// limit the number of uploads per frame to keep drawing responsive
+	const unsigned int maxUploads = 8;
+
+	unsigned int lookahead = std::min(_prefetcher->getLookahead(), TextureDistance);
+	unsigned int uploaded  = 0;
+
+	for (auto& section : _prefetcher->getLoadedSections()) {
+
+		unsigned int z = section.first;
+
+		if (!section.second)
+			continue;
+
+		if (std::abs((int)z - (int)_section) > (int)lookahead)
+			continue;
+
+		for (unsigned int brickY = _visibleBeginY; brickY < _visibleEndY && uploaded < maxUploads; brickY++)
+			for (unsigned int brickX = _visibleBeginX; brickX < _visibleEndX && uploaded < maxUploads; brickX++) {
+
+				auto key = std::make_pair(z, brickY*_bricksX + brickX);
+
+				if (_bricks.count(key))
+					continue;
+
+				_bricks[key] = uploadBrick(z, brickX, brickY, section.second);
+				uploaded++;
+			}
+
+		if (uploaded == maxUploads)
+			break;
+	}
+
+	deleteTextures(false);
+}
+
+void
+RawVolumeView::deleteTextures(bool all) {
+
+	if (_bricks.empty())
+		return;
+
+	sg_gui::OpenGl::Guard guard;
+
+	for (auto i = _bricks.begin(); i != _bricks.end();) {
+
+		unsigned int z      = i->first.first;
+		unsigned int brickX = i->first.second%_bricksX;
+		unsigned int brickY = i->first.second/_bricksX;
+
+		bool far = (std::abs((int)z - (int)_section) > (int)TextureDistance);
+
+		// keep a margin of one brick around the visible ones for panning
+		bool outside =
+				(brickX + 1 < _visibleBeginX || brickX > _visibleEndX ||
+				 brickY + 1 < _visibleBeginY || brickY > _visibleEndY);
+
+		if (all || far || outside) {
+
+			glDeleteTextures(1, &i->second);
+			i = _bricks.erase(i);
+
+		} else {
+
+			++i;
+		}
+	}
+}
+
+void
+RawVolumeView::selectPoint(const util::ray<float,3>& ray) {
+
+	if (ray.direction().z() == 0)
+		return;
+
+	// intersect with the center of the current section
+	float z = _offset.z() + (_section + 0.5)*_resolution.z();
+	float t = (z - ray.position().z())/ray.direction().z();
+
+	util::point<float,3> point = ray.position() + ray.direction()*t;
+
+	if (!_boundingBox.contains(point))
+		return;
+
+	LOG_DEBUG(rawvolumeviewlog) << "selected point " << point << std::endl;
+
+	send<sg_gui::VolumePointSelected>(point);
+}
@@ -0,0 +1,300 @@
+#ifndef TOOLS_GUI_RAW_VOLUME_VIEW_H__
+#define TOOLS_GUI_RAW_VOLUME_VIEW_H__
+
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <map>
+#include <scopegraph/Agent.h>
+#include <imageprocessing/ExplicitVolume.h>
+#include <io/ImageStack.h>
+#include <sg_gui/GuiSignals.h>
+#include <sg_gui/MouseSignals.h>
+#include <sg_gui/KeySignals.h>
+#include <sg_gui/VolumeView.h>
+#include <sg_gui/OpenGl.h>
+#include "SectionPrefetcher.h"
+#include "SectionSignals.h"
+
+/**
+ * Texture formats matching the supported voxel types.
+ */
+template <typename T>
+struct SectionTextureFormat {};
+
+template <>
+struct SectionTextureFormat<uint8_t> {
+
+	static const GLint  InternalFormat = GL_LUMINANCE8;
+	static const GLenum Type           = GL_UNSIGNED_BYTE;
+};
+
+template <>
+struct SectionTextureFormat<uint16_t> {
+
+	static const GLint  InternalFormat = GL_LUMINANCE16;
+	static const GLenum Type           = GL_UNSIGNED_SHORT;
+};
+
+template <>
+struct SectionTextureFormat<float> {
+
+	// unclamped, such that the contrast window can be set in the units of the
+	// volume
+	static const GLint  InternalFormat = GL_LUMINANCE32F_ARB;
+	static const GLenum Type           = GL_FLOAT;
+};
+
+/**
+ * Shows the sections of a raw volume in its native voxel type. Sections are
+ * uploaded as textures of matching format (8 bit, 16 bit, or float
+ * luminance), such that the intensities can be mapped to the screen by a
+ * shader without ever converting the volume. Label volumes are shown with a
+ * random color per label instead.
+ *
+ * Sections ahead of the current one in the direction of navigation are loaded
+ * by a SectionPrefetcher and uploaded while drawing, such that stepping
+ * through the stack does not have to wait for the data. The loaded sections
+ * are kept in a SectionCache, which can be shared by several views.
+ *
+ * Sections are uploaded in bricks of BrickSize x BrickSize voxels, and only
+ * the bricks in the region of interest of the draw signals are uploaded and
+ * kept, such that the memory taken on the GPU depends on what is visible,
+ * not on the size of the volume.
+ *
+ * Several views can be shown on top of each other, each with its own color
+ * and opacity. Only the primary view reacts to navigation and reports the
+ * current section, the others follow its SectionChanged signals.
+ */
+class RawVolumeView :
+		public sg::Agent<
+				RawVolumeView,
+				sg::Accepts<
+						sg_gui::DrawOpaque,
+						sg_gui::QuerySize,
+						sg_gui::MouseDown,
+						SetSection,
+						SectionChanged
+				>,
+				sg::Provides<
+						sg_gui::ContentChanged,
+						sg_gui::VolumePointSelected,
+						SectionChanged
+				>
+		> {
+
+public:
+
+	/**
+	 * The edge length of the bricks sections are uploaded in.
+	 */
+	static const unsigned int BrickSize = 512;
+
+	/**
+	 * The number of sections around the current one to keep bricks of on the
+	 * GPU. Independent of how many sections are loaded ahead into memory.
+	 */
+	static const unsigned int TextureDistance = 4;
+
+	RawVolumeView(std::shared_ptr<SectionCache> cache = std::make_shared<SectionCache>());
+
+	~RawVolumeView();
+
+	/**
+	 * Show a volume that is kept in memory.
+	 */
+	template <typename T>
+	void setVolume(std::shared_ptr<ExplicitVolume<T>> volume) {
+
+		auto sectionLoader = [volume](unsigned int z) -> SectionPrefetcher::Section {
+
+			// share ownership with the volume, no copy needed
+			return SectionPrefetcher::Section(volume, &volume->data()(0, 0, z));
+		};
+
+		auto intensityRange = [volume](unsigned int, float& min, float& max) {
+
+			T vmin, vmax;
+			volume->data().minmax(&vmin, &vmax);
+			toTextureUnits<T>(vmin, vmax, min, max);
+		};
+
+		setSections(
+				volume->getDiscreteBoundingBox().width(),
+				volume->getDiscreteBoundingBox().height(),
+				volume->getDiscreteBoundingBox().depth(),
+				volume->getResolution(),
+				volume->getOffset(),
+				volume->getBoundingBox(),
+				SectionTextureFormat<T>::InternalFormat,
+				GL_LUMINANCE,
+				SectionTextureFormat<T>::Type,
+				sectionLoader,
+				0,
+				intensityRange);
+	}
+
+	/**
+	 * Show a volume stored as a stack of images, which are read on demand.
+	 */
+	template <typename T>
+	void setVolume(std::shared_ptr<ImageStack<T>> stack) {
+
+		auto sectionLoader = [stack](unsigned int z) -> SectionPrefetcher::Section {
+
+			auto section = stack->readSection(z);
+			return SectionPrefetcher::Section(section, section->data());
+		};
+
+		auto intensityRange = [stack](unsigned int z, float& min, float& max) {
+
+			T vmin, vmax;
+			stack->readSection(z)->minmax(&vmin, &vmax);
+			toTextureUnits<T>(vmin, vmax, min, max);
+		};
+
+		setSections(
+				stack->width(),
+				stack->height(),
+				stack->depth(),
+				stack->getResolution(),
+				stack->getOffset(),
+				stack->getBoundingBox(),
+				SectionTextureFormat<T>::InternalFormat,
+				GL_LUMINANCE,
+				SectionTextureFormat<T>::Type,
+				sectionLoader,
+				stack->width()*stack->height()*sizeof(T),
+				intensityRange);
+	}
+
+	/**
+	 * Show a volume of labels, each in a random color. Label 0 is transparent.
+	 */
+	void setLabels(std::shared_ptr<ExplicitVolume<uint64_t>> labels);
+
+	/**
+	 * Set the color to tint the intensities with, white by default.
+	 */
+	void setColor(float r, float g, float b);
+
+	/**
+	 * Set the opacity of the view.
+	 */
+	void setAlpha(float alpha);
+
+	void setVisible(bool visible);
+
+	bool isVisible() const { return _visible; }
+
+	/**
+	 * Set whether this view reacts to navigation (the default), or follows
+	 * the section of another view.
+	 */
+	void setPrimary(bool primary) { _primary = primary; }
+
+	/**
+	 * Get the range of intensities of the volume in texture units, i.e.,
+	 * normalized to [0,1] for integer volumes. For volumes in memory, this
+	 * involves a pass over the whole volume. For volumes read on demand, only
+	 * the current section is considered.
+	 */
+	void getIntensityRange(float& min, float& max);
+
+	void onSignal(sg_gui::DrawOpaque& signal);
+
+	void onSignal(sg_gui::QuerySize& signal);
+
+	void onSignal(sg_gui::MouseDown& signal);
+
+	void onSignal(SetSection& signal);
+
+	void onSignal(SectionChanged& signal);
+
+private:
+
+	typedef std::function<void(unsigned int, float&, float&)> IntensityRange;
+
+	template <typename T>
+	static void toTextureUnits(T vmin, T vmax, float& min, float& max) {
+
+		// integer textures get normalized to [0,1]
+		float scale = (std::numeric_limits<T>::is_integer ? 1.0/std::numeric_limits<T>::max() : 1.0);
+		min = scale*vmin;
+		max = scale*vmax;
+	}
+
+	void setSections(
+			unsigned int width,
+			unsigned int height,
+			unsigned int depth,
+			const util::point<float,3>& resolution,
+			const util::point<float,3>& offset,
+			const util::box<float,3>& boundingBox,
+			GLint internalFormat,
+			GLenum format,
+			GLenum type,
+			SectionPrefetcher::Loader sectionLoader,
+			size_t sectionBytes,
+			IntensityRange intensityRange);
+
+	// the section containing the given z coordinate, clamped to the volume
+	unsigned int getSection(float z) const;
+
+	// show another section, tell the other views about it if notify is set
+	void setCurrentSection(unsigned int z, bool notify = true);
+
+	// find the bricks in the region of interest
+	void updateVisibleBricks(const util::box<float,3>& roi);
+
+	GLuint uploadBrick(unsigned int z, unsigned int brickX, unsigned int brickY, SectionPrefetcher::Section data);
+
+	void uploadPrefetched();
+
+	// delete bricks too far from the current section or the visible ones
+	void deleteTextures(bool all);
+
+	void selectPoint(const util::ray<float,3>& ray);
+
+	std::unique_ptr<SectionPrefetcher> _prefetcher;
+
+	IntensityRange _intensityRange;
+
+	std::shared_ptr<SectionCache> _cache;
+
+	GLint  _internalFormat;
+	GLenum _format;
+	GLenum _type;
+
+	unsigned int _width;
+	unsigned int _height;
+	unsigned int _depth;
+
+	util::point<float,3> _resolution;
+	util::point<float,3> _offset;
+	util::box<float,3>   _boundingBox;
+
+	unsigned int _section;
+
+	// the number of bricks per section, and the range of bricks visible in
+	// the last draw
+	unsigned int _bricksX;
+	unsigned int _bricksY;
+	unsigned int _visibleBeginX;
+	unsigned int _visibleBeginY;
+	unsigned int _visibleEndX;
+	unsigned int _visibleEndY;
+
+	// uploaded bricks by z and brick index
+	std::map<std::pair<unsigned int, unsigned int>, GLuint> _bricks;
+
+	float _color[3];
+	float _alpha;
+	bool  _visible;
+	bool  _primary;
+
+	std::chrono::steady_clock::time_point _lastLeftClick;
+};
+
+#endif // TOOLS_GUI_RAW_VOLUME_VIEW_H__
+
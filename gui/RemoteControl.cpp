@@ -0,0 +1,574 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <util/Logger.h>
+#include <util/exceptions.h>
+#include "RemoteControl.h"
+
+logger::LogChannel remotecontrollog("remotecontrollog", "[RemoteControl] ");
+
+// the number of draws after requesting a screenshot until it is saved
+static const int ScreenshotFrames = 2;
+
+// the maximal length of a command line, clients sending longer ones are
+// disconnected
+static const size_t MaxLineLength = 1024*1024;
+
+RemoteControl::RemoteControl(std::shared_ptr<sg_gui::Window> window, const std::string& path) :
+	_window(window),
+	_path(path),
+	_stop(false),
+	_nextClient(0),
+	_screenshotDelay(0) {
+
+	sockaddr_un address;
+	std::memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+
+	if (path.size() >= sizeof(address.sun_path))
+		UTIL_THROW_EXCEPTION(
+				UsageError,
+				"socket path " << path << " is too long");
+
+	std::strcpy(address.sun_path, path.c_str());
+
+	// replace sockets left over from earlier runs, but nothing else
+	struct stat info;
+	if (stat(path.c_str(), &info) == 0) {
+
+		if (!S_ISSOCK(info.st_mode))
+			UTIL_THROW_EXCEPTION(
+					IOError,
+					path << " exists and is not a socket");
+
+		unlink(path.c_str());
+	}
+
+	_socket = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+	if (_socket < 0 ||
+	    bind(_socket, (sockaddr*)&address, sizeof(address)) != 0 ||
+	    listen(_socket, 16) != 0)
+		UTIL_THROW_EXCEPTION(
+				IOError,
+				"can not listen on " << path << ": " << std::strerror(errno));
+
+	int wake[2];
+	if (pipe2(wake, O_NONBLOCK | O_CLOEXEC) != 0)
+		UTIL_THROW_EXCEPTION(
+				IOError,
+				"can not create pipe: " << std::strerror(errno));
+
+	_wakeRead  = wake[0];
+	_wakeWrite = wake[1];
+
+	LOG_USER(remotecontrollog) << "listening for commands on " << path << std::endl;
+
+	_serverThread = std::thread(&RemoteControl::serve, this);
+}
+
+RemoteControl::~RemoteControl() {
+
+	_stop = true;
+	wake();
+
+	if (_serverThread.joinable())
+		_serverThread.join();
+
+	for (auto& client : _clients)
+		close(client.second.fd);
+
+	close(_socket);
+	close(_wakeRead);
+	close(_wakeWrite);
+
+	unlink(_path.c_str());
+}
+
+void
+RemoteControl::onSignal(sg_gui::Draw& signal) {
+
+	if (_screenshotDelay > 0) {
+
+		// nothing changes until the screenshot is saved
+		if (--_screenshotDelay > 0) {
+
+			send<sg_gui::ContentChanged>();
+			return;
+		}
+
+		for (const Command& screenshot : _screenshots)
+			reply(screenshot.client, screenshot.id, "");
+		_screenshots.clear();
+
+		wake();
+	}
+
+	bool applied = applyCommands();
+
+	// signals are only sent on the GUI thread, ask for another frame to poll
+	// for commands, slowly while none arrive
+	_poll.wait(signal, applied || _screenshotDelay > 0);
+	send<sg_gui::ContentChanged>();
+}
+
+bool
+RemoteControl::applyCommands() {
+
+	std::vector<Command> commands;
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		while (!_commands.empty()) {
+
+			commands.push_back(_commands.front());
+			_commands.pop_front();
+
+			if (commands.back().type == Command::Screenshot && commands.back().error.empty())
+				break;
+		}
+	}
+
+	if (commands.empty())
+		return false;
+
+	// the net changes of all commands
+	std::set<uint64_t>   show, hide;
+	bool                 reset = false;
+	bool                 haveCenter = false, haveZoom = false, haveRotation = false, haveSection = false, haveAlpha = false;
+	util::point<float,3> center, rotation;
+	float                zoom = 1, section = 0, alpha = 1;
+
+	for (const Command& command : commands) {
+
+		if (!command.error.empty())
+			continue;
+
+		switch (command.type) {
+
+			case Command::Show:
+				for (uint64_t id : command.ids)
+					if (_visible.insert(id).second && !hide.erase(id))
+						show.insert(id);
+				break;
+
+			case Command::Hide:
+				for (uint64_t id : command.ids)
+					if (_visible.erase(id) && !show.erase(id))
+						hide.insert(id);
+				break;
+
+			case Command::Clear:
+				for (uint64_t id : _visible)
+					if (!show.erase(id))
+						hide.insert(id);
+				_visible.clear();
+				break;
+
+			case Command::Section:
+				section     = command.value;
+				haveSection = true;
+				break;
+
+			case Command::Goto:
+				center      = command.point;
+				section     = command.point.z();
+				haveCenter  = true;
+				haveSection = true;
+				break;
+
+			case Command::Zoom:
+				zoom     = command.value;
+				haveZoom = true;
+				break;
+
+			case Command::Rotate:
+				rotation     = command.point;
+				haveRotation = true;
+				break;
+
+			case Command::Reset:
+				reset        = true;
+				haveCenter   = false;
+				haveZoom     = false;
+				haveRotation = false;
+				break;
+
+			case Command::Alpha:
+				alpha     = command.value;
+				haveAlpha = true;
+				break;
+
+			case Command::Screenshot:
+				_screenshots.push_back(command);
+				break;
+		}
+	}
+
+	LOG_DEBUG(remotecontrollog)
+			<< "applying " << commands.size() << " commands, showing "
+			<< show.size() << " and hiding " << hide.size() << " segments" << std::endl;
+
+	if (!hide.empty())
+		send<HideSegments>(hide);
+	if (!show.empty())
+		send<ShowSegments>(show);
+	if (reset)
+		send<ResetView>();
+	if (haveCenter)
+		send<SetCenter>(center);
+	if (haveZoom)
+		send<SetZoom>(zoom);
+	if (haveRotation)
+		send<SetRotation>(rotation);
+	if (haveSection)
+		send<SetSection>(section);
+	if (haveAlpha)
+		send<sg_gui::ChangeAlpha>(alpha);
+
+	if (!_screenshots.empty()) {
+
+		_window->requestNextFrameSave();
+		_screenshotDelay = ScreenshotFrames;
+	}
+
+	for (const Command& command : commands)
+		if (command.type != Command::Screenshot || !command.error.empty())
+			reply(command.client, command.id, command.error);
+
+	wake();
+
+	return true;
+}
+
+void
+RemoteControl::reply(int client, const std::string& id, const std::string& error) {
+
+	std::stringstream message;
+	message << "{";
+
+	if (!id.empty()) {
+
+		message << "\"id\": \"";
+		for (char c : id) {
+
+			if (c == '"' || c == '\\') {
+
+				message << '\\' << c;
+
+			} else if ((unsigned char)c < 0x20) {
+
+				// control characters are not allowed in JSON strings
+				char escaped[7];
+				std::snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned int)c);
+				message << escaped;
+
+			} else {
+
+				message << c;
+			}
+		}
+		message << "\", ";
+	}
+
+	if (error.empty())
+		message << "\"ok\": true}\n";
+	else
+		message << "\"error\": \"" << error << "\"}\n";
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	// the client might be gone already
+	auto i = _clients.find(client);
+	if (i != _clients.end())
+		i->second.out += message.str();
+}
+
+void
+RemoteControl::wake() {
+
+	char c = 0;
+	if (write(_wakeWrite, &c, 1) < 0) {
+
+		// the pipe is full, the server thread will wake up anyway
+	}
+}
+
+void
+RemoteControl::serve() {
+
+	std::vector<pollfd> fds;
+	std::vector<int>    clients;
+
+	while (!_stop) {
+
+		fds.clear();
+		clients.clear();
+
+		pollfd p;
+		p.fd     = _socket;
+		p.events = POLLIN;
+		fds.push_back(p);
+		p.fd     = _wakeRead;
+		fds.push_back(p);
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+
+			for (auto& client : _clients) {
+
+				p.fd     = client.second.fd;
+				p.events = POLLIN | (client.second.out.empty() ? 0 : POLLOUT);
+				fds.push_back(p);
+				clients.push_back(client.first);
+			}
+		}
+
+		// wake up regularly to see whether we should stop
+		if (poll(fds.data(), fds.size(), 100) <= 0)
+			continue;
+
+		if (fds[1].revents & POLLIN) {
+
+			char buffer[256];
+			while (read(_wakeRead, buffer, sizeof(buffer)) > 0) {}
+		}
+
+		for (size_t i = 0; i < clients.size(); i++) {
+
+			short events = fds[i + 2].revents;
+
+			bool open = true;
+
+			if (events & (POLLIN | POLLHUP | POLLERR))
+				open = receive(clients[i]);
+			if (open && (events & POLLOUT))
+				open = transmit(clients[i]);
+
+			if (!open) {
+
+				LOG_DEBUG(remotecontrollog) << "client " << clients[i] << " disconnected" << std::endl;
+
+				std::lock_guard<std::mutex> lock(_mutex);
+
+				close(_clients[clients[i]].fd);
+				_clients.erase(clients[i]);
+			}
+		}
+
+		if (fds[0].revents & POLLIN) {
+
+			int fd;
+			while ((fd = accept4(_socket, 0, 0, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+
+				std::lock_guard<std::mutex> lock(_mutex);
+
+				LOG_DEBUG(remotecontrollog) << "client " << _nextClient << " connected" << std::endl;
+
+				_clients[_nextClient].fd = fd;
+				_nextClient++;
+			}
+		}
+	}
+}
+
+bool
+RemoteControl::receive(int client) {
+
+	// only this thread changes the set of clients and their input buffers
+	Client& c = _clients.find(client)->second;
+
+	bool   open = true;
+	char   buffer[65536];
+	size_t received = 0;
+
+	// read at most a line's worth at a time, such that a client sending
+	// without pause does not keep the others waiting
+	while (received < MaxLineLength) {
+
+		ssize_t n = read(c.fd, buffer, sizeof(buffer));
+
+		if (n > 0) {
+
+			c.in.append(buffer, n);
+			received += n;
+			continue;
+		}
+
+		if (n < 0 && errno == EINTR)
+			continue;
+
+		if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+			open = false;
+
+		break;
+	}
+
+	// parse outside of the lock, such that the GUI thread does not have to
+	// wait for it
+	std::vector<Command> commands;
+
+	size_t begin = 0;
+	size_t end;
+	while ((end = c.in.find('\n', begin)) != std::string::npos) {
+
+		std::string line = c.in.substr(begin, end - begin);
+		begin = end + 1;
+
+		if (line.find_first_not_of(" \t\r") == std::string::npos)
+			continue;
+
+		// invalid commands are queued as well, to keep the replies in order
+		Command command;
+		command.client = client;
+		parse(line, command);
+
+		commands.push_back(command);
+	}
+	c.in.erase(0, begin);
+
+	if (!commands.empty()) {
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		_commands.insert(_commands.end(), commands.begin(), commands.end());
+	}
+
+	if (c.in.size() > MaxLineLength) {
+
+		LOG_ERROR(remotecontrollog)
+				<< "client " << client << " sent more than " << MaxLineLength
+				<< " bytes without a newline, disconnecting" << std::endl;
+		return false;
+	}
+
+	return open;
+}
+
+bool
+RemoteControl::transmit(int client) {
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	Client& c = _clients.find(client)->second;
+
+	while (!c.out.empty()) {
+
+		ssize_t n = ::send(c.fd, c.out.data(), c.out.size(), MSG_NOSIGNAL);
+
+		if (n > 0) {
+
+			c.out.erase(0, n);
+			continue;
+		}
+
+		if (n < 0 && errno == EINTR)
+			continue;
+
+		return (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+	}
+
+	return true;
+}
+
+bool
+RemoteControl::parse(const std::string& line, Command& command) {
+
+	boost::property_tree::ptree tree;
+
+	try {
+
+		std::istringstream stream(line);
+		boost::property_tree::read_json(stream, tree);
+
+	} catch (boost::property_tree::json_parser_error& e) {
+
+		command.error = "invalid JSON";
+		return false;
+	}
+
+	try {
+
+		command.id = tree.get<std::string>("id", "");
+
+		std::string name = tree.get<std::string>("cmd", "");
+
+		if (name == "show" || name == "hide") {
+
+			command.type = (name == "show" ? Command::Show : Command::Hide);
+
+			for (auto& id : tree.get_child("ids"))
+				command.ids.push_back(id.second.get_value<uint64_t>());
+
+		} else if (name == "clear") {
+
+			command.type = Command::Clear;
+
+		} else if (name == "section") {
+
+			command.type  = Command::Section;
+			command.value = tree.get<float>("z");
+
+		} else if (name == "goto") {
+
+			command.type  = Command::Goto;
+			command.point = util::point<float,3>(tree.get<float>("x"), tree.get<float>("y"), tree.get<float>("z"));
+
+		} else if (name == "zoom") {
+
+			command.type  = Command::Zoom;
+			command.value = tree.get<float>("factor");
+
+			if (command.value <= 0) {
+
+				command.error = "zoom factor has to be positive";
+				return false;
+			}
+
+		} else if (name == "rotate") {
+
+			command.type  = Command::Rotate;
+			command.point = util::point<float,3>(tree.get<float>("x", 0), tree.get<float>("y", 0), tree.get<float>("z", 0));
+
+		} else if (name == "reset") {
+
+			command.type = Command::Reset;
+
+		} else if (name == "alpha") {
+
+			command.type  = Command::Alpha;
+			command.value = tree.get<float>("value");
+
+			if (command.value < 0 || command.value > 1) {
+
+				command.error = "alpha has to be in [0,1]";
+				return false;
+			}
+
+		} else if (name == "screenshot") {
+
+			command.type = Command::Screenshot;
+
+		} else {
+
+			command.error = "unknown command";
+			return false;
+		}
+
+	} catch (boost::property_tree::ptree_error& e) {
+
+		command.error = "missing or invalid argument";
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,182 @@
+#ifndef TOOLS_GUI_REMOTE_CONTROL_H__
+#define TOOLS_GUI_REMOTE_CONTROL_H__
+
+#include <atomic>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <scopegraph/Agent.h>
+#include <sg_gui/GuiSignals.h>
+#include <sg_gui/Window.h>
+#include <util/point.hpp>
+#include "PollThrottle.h"
+#include "SectionSignals.h"
+#include "SegmentSignals.h"
+#include "ViewSignals.h"
+
+/**
+ * Lets other programs drive the viewer through a local UNIX domain socket.
+ * Clients send one JSON object per line, e.g.,
+ *
+ *   {"cmd": "show", "ids": [1, 2, 3]}
+ *   {"cmd": "goto", "x": 100, "y": 200, "z": 50}
+ *   {"cmd": "screenshot", "id": "frame-1"}
+ *
+ * and get one JSON reply per command, in order, after it took effect:
+ *
+ *   {"id": "frame-1", "ok": true}
+ *
+ * Commands are
+ *
+ *   show, hide       "ids": segments to show or hide
+ *   clear            hide all segments shown through the socket
+ *   section          "z": show the section at z (world units)
+ *   goto             "x", "y", "z": center the view on a location and show
+ *                    its section
+ *   zoom             "factor": magnification relative to fitting the window
+ *   rotate           "x", "y", "z": rotation around the axes in degrees
+ *   reset            undo goto, zoom, and rotate
+ *   alpha            "value": opacity of the segments in [0,1]
+ *   screenshot       save the next frame (replied to once it is drawn)
+ *
+ * The socket is served on a background thread. All commands received until
+ * the next draw are applied at once: segment changes are merged into single
+ * ShowSegments and HideSegments signals, and of several view changes only
+ * the last one is sent. A screenshot ends the batch, such that it shows
+ * exactly the commands before it. Clients that send lines longer than 1 MB
+ * are disconnected.
+ */
+class RemoteControl :
+		public sg::Agent<
+				RemoteControl,
+				sg::Accepts<
+						sg_gui::Draw
+				>,
+				sg::Provides<
+						sg_gui::ContentChanged,
+						sg_gui::ChangeAlpha,
+						ShowSegments,
+						HideSegments,
+						SetSection,
+						SetZoom,
+						SetRotation,
+						SetCenter,
+						ResetView
+				>
+		> {
+
+public:
+
+	/**
+	 * @param window
+	 *              The window to save screenshots of.
+	 * @param path
+	 *              The path of the socket to create. An existing socket at
+	 *              this path is replaced.
+	 */
+	RemoteControl(std::shared_ptr<sg_gui::Window> window, const std::string& path);
+
+	/**
+	 * Stops serving and removes the socket.
+	 */
+	~RemoteControl();
+
+	void onSignal(sg_gui::Draw& signal);
+
+private:
+
+	struct Command {
+
+		Command() : type(Show), value(0), client(0) {}
+
+		enum Type {
+
+			Show,
+			Hide,
+			Clear,
+			Section,
+			Goto,
+			Zoom,
+			Rotate,
+			Reset,
+			Alpha,
+			Screenshot
+		};
+
+		Type                  type;
+		std::vector<uint64_t> ids;
+		util::point<float,3>  point;
+		float                 value;
+
+		// the client to reply to, the id of the command to echo, and why the
+		// command is invalid, if it is
+		int         client;
+		std::string id;
+		std::string error;
+	};
+
+	struct Client {
+
+		int         fd;
+		std::string in;
+		std::string out;
+	};
+
+	void serve();
+
+	// read available data from a client and queue the commands, returns false
+	// if the client disconnected or sent a too long line
+	bool receive(int client);
+
+	// write as much of the pending replies as possible, returns false if the
+	// client disconnected
+	bool transmit(int client);
+
+	// parse a line, returns false and sets the error message of the command
+	// if the line is not a valid command
+	static bool parse(const std::string& line, Command& command);
+
+	// apply the commands received so far, until the first screenshot, returns
+	// false if there were none
+	bool applyCommands();
+
+	void reply(int client, const std::string& id, const std::string& error);
+
+	// wake up the server thread to send replies
+	void wake();
+
+	std::shared_ptr<sg_gui::Window> _window;
+
+	std::string _path;
+	int         _socket;
+	int         _wakeRead;
+	int         _wakeWrite;
+
+	std::thread       _serverThread;
+	std::atomic<bool> _stop;
+
+	// commands to be applied with the next draw and pending replies, shared
+	// with the server thread
+	std::deque<Command>    _commands;
+	std::map<int, Client>  _clients;
+	std::mutex             _mutex;
+	int                    _nextClient;
+
+	// screenshot commands waiting for their frame to be saved, and the number
+	// of draws until then
+	std::vector<Command> _screenshots;
+	int                  _screenshotDelay;
+
+	// the segments shown through the socket
+	std::set<uint64_t> _visible;
+
+	PollThrottle _poll;
+};
+
+#endif // TOOLS_GUI_REMOTE_CONTROL_H__
+
@@ -0,0 +1,143 @@
+#include <util/Logger.h>
+#include "SectionCache.h"
+
+logger::LogChannel sectioncachelog("sectioncachelog", "[SectionCache] ");
+
+SectionCache::SectionCache(size_t maxBytes) :
+	_bytes(0),
+	_maxBytes(maxBytes) {}
+
+void
+SectionCache::setMaxBytes(size_t maxBytes) {
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	_maxBytes = maxBytes;
+	evict(Key(0, 0));
+}
+
+size_t
+SectionCache::getBytes() {
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	return _bytes;
+}
+
+void
+SectionCache::insert(const void* owner, unsigned int z, Section section, size_t bytes) {
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	Key key(owner, z);
+
+	auto i = _entries.find(key);
+	if (i != _entries.end())
+		erase(i);
+
+	_lru.push_front(key);
+
+	Entry& entry  = _entries[key];
+	entry.section = section;
+	entry.bytes   = bytes;
+	entry.lru     = _lru.begin();
+
+	_bytes += bytes;
+
+	evict(key);
+}
+
+bool
+SectionCache::contains(const void* owner, unsigned int z) {
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	return _entries.count(Key(owner, z)) > 0;
+}
+
+bool
+SectionCache::get(const void* owner, unsigned int z, Section& section) {
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	auto i = _entries.find(Key(owner, z));
+	if (i == _entries.end())
+		return false;
+
+	// move to the front of the LRU list
+	_lru.splice(_lru.begin(), _lru, i->second.lru);
+
+	section = i->second.section;
+
+	return true;
+}
+
+std::vector<std::pair<unsigned int, SectionCache::Section>>
+SectionCache::getSections(const void* owner) {
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	std::vector<std::pair<unsigned int, Section>> sections;
+
+	for (auto i = _entries.lower_bound(Key(owner, 0)); i != _entries.end() && i->first.first == owner; ++i)
+		sections.push_back(std::make_pair(i->first.second, i->second.section));
+
+	return sections;
+}
+
+void
+SectionCache::erase(const void* owner, unsigned int z) {
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	auto i = _entries.find(Key(owner, z));
+	if (i != _entries.end())
+		erase(i);
+}
+
+void
+SectionCache::erase(const void* owner) {
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	auto i = _entries.lower_bound(Key(owner, 0));
+	while (i != _entries.end() && i->first.first == owner) {
+
+		auto next = i;
+		++next;
+		erase(i);
+		i = next;
+	}
+}
+
+void
+SectionCache::evict(const Key& keep) {
+
+	auto i = _lru.end();
+
+	while (_bytes > _maxBytes && i != _lru.begin()) {
+
+		--i;
+
+		if (*i == keep)
+			continue;
+
+		auto entry = _entries.find(*i);
+
+		// erasing invalidates the list iterator, continue from its successor
+		auto next = i;
+		++next;
+		erase(entry);
+		i = next;
+
+		LOG_ALL(sectioncachelog) << "evicted a section, " << _bytes << " bytes in use" << std::endl;
+	}
+}
+
+void
+SectionCache::erase(std::map<Key, Entry>::iterator i) {
+
+	_bytes -= i->second.bytes;
+	_lru.erase(i->second.lru);
+	_entries.erase(i);
+}
@@ -0,0 +1,104 @@
+#ifndef TOOLS_GUI_SECTION_CACHE_H__
+#define TOOLS_GUI_SECTION_CACHE_H__
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * Loaded sections of several volumes, within a common memory budget. The
+ * sections are owned by the SectionPrefetchers of the volumes, which all
+ * share one cache. If the sections take more memory than the budget, the
+ * ones used least recently are dropped first, whichever volume they belong
+ * to. Can be used concurrently from several threads.
+ */
+class SectionCache {
+
+public:
+
+	typedef std::shared_ptr<const void> Section;
+
+	/**
+	 * @param maxBytes
+	 *              The memory budget for all sections.
+	 */
+	SectionCache(size_t maxBytes = 1024*1024*1024);
+
+	void setMaxBytes(size_t maxBytes);
+
+	size_t getMaxBytes() const { return _maxBytes; }
+
+	/**
+	 * The memory currently taken by the cached sections.
+	 */
+	size_t getBytes();
+
+	/**
+	 * Add a section of the given owner. The section itself is kept, even if
+	 * it alone exceeds the budget.
+	 *
+	 * @param bytes
+	 *              The memory the section takes. Sections that only refer to
+	 *              memory held elsewhere (like sections of a volume in
+	 *              memory) can be added with 0.
+	 */
+	void insert(const void* owner, unsigned int z, Section section, size_t bytes);
+
+	/**
+	 * True if the section is cached. Sections that failed to load are cached
+	 * as empty sections.
+	 */
+	bool contains(const void* owner, unsigned int z);
+
+	/**
+	 * Get a section and mark it as used. Returns false if it is not cached,
+	 * such that an empty section that failed to load can be told apart from
+	 * a missing one.
+	 */
+	bool get(const void* owner, unsigned int z, Section& section);
+
+	/**
+	 * Get all cached sections of an owner, ordered by z. Does not count as a
+	 * use.
+	 */
+	std::vector<std::pair<unsigned int, Section>> getSections(const void* owner);
+
+	void erase(const void* owner, unsigned int z);
+
+	/**
+	 * Remove all sections of an owner.
+	 */
+	void erase(const void* owner);
+
+private:
+
+	typedef std::pair<const void*, unsigned int> Key;
+
+	struct Entry {
+
+		Section                   section;
+		size_t                    bytes;
+		std::list<Key>::iterator  lru;
+	};
+
+	// drop least recently used sections until the budget is met, but keep
+	// the one given
+	void evict(const Key& keep);
+
+	void erase(std::map<Key, Entry>::iterator i);
+
+	std::map<Key, Entry> _entries;
+
+	// the keys of all entries, most recently used first
+	std::list<Key> _lru;
+
+	size_t _bytes;
+	size_t _maxBytes;
+
+	std::mutex _mutex;
+};
+
+#endif // TOOLS_GUI_SECTION_CACHE_H__
+
@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <cmath>
+#include "SectionPrefetcher.h"
+#include <util/Logger.h>
+
+logger::LogChannel sectionprefetcherlog("sectionprefetcherlog", "[SectionPrefetcher] ");
+
+SectionPrefetcher::SectionPrefetcher(
+		Loader loader,
+		unsigned int depth,
+		std::shared_ptr<SectionCache> cache,
+		size_t sectionBytes,
+		unsigned int maxLookahead) :
+	_loader(loader),
+	_depth(depth),
+	_maxLookahead(std::max(maxLookahead, 1u)),
+	_cache(cache),
+	_sectionBytes(sectionBytes),
+	_inFlight(-1),
+	_current(0),
+	_direction(1),
+	_speed(0),
+	_latency(0),
+	_lastChange(Clock::now()),
+	_stop(false) {
+
+	_thread = std::thread(&SectionPrefetcher::run, this);
+}
+
+SectionPrefetcher::~SectionPrefetcher() {
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+
+	_queueChanged.notify_all();
+	_thread.join();
+
+	_cache->erase(this);
+}
+
+void
+SectionPrefetcher::setCurrentSection(unsigned int z) {
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	Clock::time_point now = Clock::now();
+	double elapsed = std::chrono::duration<double>(now - _lastChange).count();
+
+	if (z != _current) {
+
+		int steps = (int)z - (int)_current;
+		_direction = (steps > 0 ? 1 : -1);
+
+		// after a pause, start over with the speed estimate
+		if (elapsed > 1.0)
+			_speed = 0;
+		else
+			_speed = 0.5*_speed + 0.5*std::abs(steps)/std::max(elapsed, 1e-3);
+	}
+
+	_current    = z;
+	_lastChange = now;
+
+	evict();
+	queueAhead();
+
+	_queueChanged.notify_all();
+}
+
+SectionPrefetcher::Section
+SectionPrefetcher::getSection(unsigned int z) {
+
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	// wait for the I/O thread, if it is working on this section already
+	while (_inFlight == (int)z)
+		_sectionLoaded.wait(lock);
+
+	// empty if it failed to load before, it is not tried again until it was
+	// dropped from the cache
+	Section section;
+	if (_cache->get(this, z, section))
+		return section;
+
+	lock.unlock();
+	section = load(z);
+	lock.lock();
+
+	_cache->insert(this, z, section, _sectionBytes);
+
+	return section;
+}
+
+std::vector<std::pair<unsigned int, SectionPrefetcher::Section>>
+SectionPrefetcher::getLoadedSections() {
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	return _cache->getSections(this);
+}
+
+unsigned int
+SectionPrefetcher::getLookahead() {
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	return lookahead();
+}
+
+void
+SectionPrefetcher::run() {
+
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	while (true) {
+
+		while (!_stop && _queue.empty())
+			_queueChanged.wait(lock);
+
+		if (_stop)
+			return;
+
+		unsigned int z = _queue.front();
+		_queue.pop_front();
+
+		if (_cache->contains(this, z))
+			continue;
+
+		_inFlight = z;
+
+		lock.unlock();
+		Section section = load(z);
+		lock.lock();
+
+		_cache->insert(this, z, section, _sectionBytes);
+		_inFlight = -1;
+
+		_sectionLoaded.notify_all();
+	}
+}
+
+SectionPrefetcher::Section
+SectionPrefetcher::load(unsigned int z) {
+
+	Clock::time_point start = Clock::now();
+
+	Section section;
+
+	try {
+
+		section = _loader(z);
+
+	} catch (std::exception& e) {
+
+		LOG_ERROR(sectionprefetcherlog) << "failed to load section " << z << ": " << e.what() << std::endl;
+	}
+
+	double latency = std::chrono::duration<double>(Clock::now() - start).count();
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	_latency = (_latency == 0 ? latency : 0.8*_latency + 0.2*latency);
+
+	LOG_ALL(sectionprefetcherlog) << "loaded section " << z << " in " << latency << "s" << std::endl;
+
+	return section;
+}
+
+void
+SectionPrefetcher::queueAhead() {
+
+	_queue.clear();
+
+	unsigned int n = lookahead();
+
+	for (unsigned int i = 1; i <= n; i++) {
+
+		int z = (int)_current + _direction*(int)i;
+
+		if (z < 0 || z >= (int)_depth)
+			break;
+
+		if (!_cache->contains(this, z))
+			_queue.push_back(z);
+	}
+
+	// keep the section behind the current one, in case the user turns around
+	int behind = (int)_current - _direction;
+	if (behind >= 0 && behind < (int)_depth && !_cache->contains(this, behind))
+		_queue.push_back(behind);
+}
+
+void
+SectionPrefetcher::evict() {
+
+	for (auto& section : _cache->getSections(this)) {
+
+		unsigned int distance = std::abs((int)section.first - (int)_current);
+
+		if (distance > _maxLookahead)
+			_cache->erase(this, section.first);
+	}
+}
+
+unsigned int
+SectionPrefetcher::lookahead() {
+
+	// the number of sections we will pass while loading one, with a safety
+	// factor of two
+	double passed = 2*_speed*_latency;
+
+	return std::min(_maxLookahead, 1 + (unsigned int)std::ceil(passed));
+}
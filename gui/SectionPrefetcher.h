@@ -0,0 +1,125 @@
+#ifndef TOOLS_GUI_SECTION_PREFETCHER_H__
+#define TOOLS_GUI_SECTION_PREFETCHER_H__
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "SectionCache.h"
+
+/**
+ * Loads the sections of a volume ahead of the currently shown one on a
+ * background I/O thread. The prefetcher observes the direction and speed of
+ * the navigation through the stack and adapts the number of sections to load
+ * ahead to the measured loading latency. Loaded sections are kept in a
+ * SectionCache, which can be shared with the prefetchers of other volumes to
+ * limit the memory all of them take together.
+ */
+class SectionPrefetcher {
+
+public:
+
+	/**
+	 * The data of a section, in whatever format the loader provides.
+	 */
+	typedef SectionCache::Section Section;
+
+	/**
+	 * Loads a section. Will be called from the I/O thread.
+	 */
+	typedef std::function<Section(unsigned int)> Loader;
+
+	/**
+	 * @param cache
+	 *              The cache to keep loaded sections in.
+	 * @param sectionBytes
+	 *              The memory a loaded section takes, 0 if the sections refer
+	 *              to memory held elsewhere.
+	 */
+	SectionPrefetcher(
+			Loader loader,
+			unsigned int depth,
+			std::shared_ptr<SectionCache> cache,
+			size_t sectionBytes,
+			unsigned int maxLookahead = 32);
+
+	~SectionPrefetcher();
+
+	/**
+	 * Tell the prefetcher which section is shown now. Updates the estimate of
+	 * the navigation speed and queues the sections ahead for loading.
+	 */
+	void setCurrentSection(unsigned int z);
+
+	/**
+	 * Get the data of a section. Blocks if the section was not loaded, yet.
+	 * Returns an empty section if it failed to load, without trying again
+	 * while it is in the cache.
+	 */
+	Section getSection(unsigned int z);
+
+	/**
+	 * Get all sections of this volume that are currently in the cache, ordered
+	 * by z. Sections that failed to load are empty.
+	 */
+	std::vector<std::pair<unsigned int, Section>> getLoadedSections();
+
+	/**
+	 * The number of sections currently loaded ahead of the current one.
+	 */
+	unsigned int getLookahead();
+
+	/**
+	 * The maximal distance to the current section in which sections are kept.
+	 */
+	unsigned int getMaxLookahead() const { return _maxLookahead; }
+
+private:
+
+	typedef std::chrono::steady_clock Clock;
+
+	void run();
+
+	Section load(unsigned int z);
+
+	void queueAhead();
+
+	void evict();
+
+	unsigned int lookahead();
+
+	Loader       _loader;
+	unsigned int _depth;
+	unsigned int _maxLookahead;
+
+	// loaded sections, by this prefetcher and z
+	std::shared_ptr<SectionCache> _cache;
+	size_t                        _sectionBytes;
+
+	// sections to load, in order
+	std::deque<unsigned int> _queue;
+
+	// the section the I/O thread is working on, -1 if none
+	int _inFlight;
+
+	unsigned int      _current;
+	int               _direction;
+	double            _speed;
+	double            _latency;
+	Clock::time_point _lastChange;
+
+	std::mutex              _mutex;
+	std::condition_variable _queueChanged;
+	std::condition_variable _sectionLoaded;
+	bool                    _stop;
+
+	std::thread _thread;
+};
+
+#endif // TOOLS_GUI_SECTION_PREFETCHER_H__
+
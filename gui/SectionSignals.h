@@ -0,0 +1,59 @@
+#ifndef TOOLS_GUI_SECTION_SIGNALS_H__
+#define TOOLS_GUI_SECTION_SIGNALS_H__
+
+#include <sg_gui/GuiSignals.h>
+
+/**
+ * Sent when the section shown of a volume changed.
+ */
+class SectionChanged : public sg_gui::GuiSignal {
+
+public:
+
+	typedef sg_gui::GuiSignal parent_type;
+
+	/**
+	 * @param z
+	 *              The z coordinate of the shown section in world units.
+	 * @param thickness
+	 *              The thickness of a section in world units.
+	 */
+	SectionChanged(float z, float thickness) :
+		_z(z),
+		_thickness(thickness) {}
+
+	float getZ() const { return _z; }
+
+	float getThickness() const { return _thickness; }
+
+private:
+
+	float _z;
+	float _thickness;
+};
+
+/**
+ * Ask volume views to show the section closest to the given z coordinate.
+ */
+class SetSection : public sg_gui::GuiSignal {
+
+public:
+
+	typedef sg_gui::GuiSignal parent_type;
+
+	/**
+	 * @param z
+	 *              The z coordinate of the section to show in world units.
+	 */
+	SetSection(float z) :
+		_z(z) {}
+
+	float getZ() const { return _z; }
+
+private:
+
+	float _z;
+};
+
+#endif // TOOLS_GUI_SECTION_SIGNALS_H__
+
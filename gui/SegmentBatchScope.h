@@ -0,0 +1,85 @@
+#ifndef TOOLS_GUI_SEGMENT_BATCH_SCOPE_H__
+#define TOOLS_GUI_SEGMENT_BATCH_SCOPE_H__
+
+#include <scopegraph/Scope.h>
+#include <sg_gui/GuiSignals.h>
+#include <sg_gui/SegmentSignals.h>
+#include "SegmentSignals.h"
+
+/**
+ * Scope for views that only understand single sg_gui::ShowSegment and 
+ * sg_gui::HideSegment signals (like sg_gui::MeshView). Splits ShowSegments 
+ * and HideSegments into single signals for the views inside, and sends only 
+ * one ContentChanged for all of them.
+ */
+class SegmentBatchScope :
+		public sg::Scope<
+				SegmentBatchScope,
+				sg::Accepts<
+						ShowSegments,
+						HideSegments
+				>,
+				sg::Provides<
+						sg_gui::ContentChanged
+				>,
+				sg::AcceptsInner<
+						sg_gui::ContentChanged
+				>,
+				sg::ProvidesInner<
+						sg_gui::ShowSegment,
+						sg_gui::HideSegment
+				>
+		> {
+
+public:
+
+	SegmentBatchScope() :
+		_inBatch(false),
+		_changed(false) {}
+
+	void onSignal(ShowSegments& signal) {
+
+		startBatch();
+		for (uint64_t id : signal.getIds())
+			sendInner<sg_gui::ShowSegment>(id);
+		stopBatch();
+	}
+
+	void onSignal(HideSegments& signal) {
+
+		startBatch();
+		for (uint64_t id : signal.getIds())
+			sendInner<sg_gui::HideSegment>(id);
+		stopBatch();
+	}
+
+	void onInnerSignal(sg_gui::ContentChanged&) {
+
+		if (_inBatch)
+			_changed = true;
+		else
+			send<sg_gui::ContentChanged>();
+	}
+
+private:
+
+	void startBatch() {
+
+		_inBatch = true;
+		_changed = false;
+	}
+
+	void stopBatch() {
+
+		_inBatch = false;
+
+		if (_changed)
+			send<sg_gui::ContentChanged>();
+	}
+
+	bool _inBatch;
+	bool _changed;
+};
+
+#endif // TOOLS_GUI_SEGMENT_BATCH_SCOPE_H__
+
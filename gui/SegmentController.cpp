@@ -1,12 +1,20 @@
-#include <queue>
 #include "SegmentController.h"
 #include <util/Logger.h>
+#include <util/exceptions.h>
 #include <util/string.h>
 
 logger::LogChannel segmentcontrollerlog("segmentcontrollerlog", "[SegmentController] ");
 
-SegmentController::SegmentController(std::shared_ptr<ExplicitVolume<uint64_t>> labels) :
-	_labels(labels) {}
+SegmentController::SegmentController(
+		std::shared_ptr<ExplicitVolume<uint64_t>> labels,
+		std::shared_ptr<LabelStatistics> statistics,
+		std::shared_ptr<RegionAdjacencyGraph> rag) :
+	_labels(labels),
+	_statistics(statistics),
+	_rag(rag),
+	_selected(0),
+	_running(0),
+	_worker(1) {}
 
 void
 SegmentController::onSignal(sg_gui::VolumePointSelected& signal) {
@@ -25,6 +33,7 @@ SegmentController::onSignal(sg_gui::VolumePointSelected& signal) {
 
 	LOG_DEBUG(segmentcontrollerlog) << "selected label " << label << std::endl;
 
+	_selected = label;
 	toggleSegment(label);
 }
 
@@ -33,48 +42,170 @@ SegmentController::onSignal(sg_gui::KeyDown& signal) {
 
 	if (signal.key == sg_gui::keys::I) {
 
-		LOG_USER(segmentcontrollerlog) << "enter label to show (or 'all' or 'largest <k>'): " << std::endl;
+		LOG_USER(segmentcontrollerlog)
+				<< "enter label to show (or 'all', 'largest <k>', 'top <k>' to list the largest labels, "
+				<< "or 'neighbors <k> [<label>]' to show the k neighbors with the largest contact area "
+				<< "of the label or the last selected one): " << std::endl;
 
-		char input[10000];
-		std::cin.getline(input, 10000);
+		// the line is read in the background and executed with the next draw
+		// after it was entered
+		_commands.readLine();
+		send<sg_gui::ContentChanged>();
+	}
 
-		if (std::string(input) == "all") {
+	if (signal.key == sg_gui::keys::C) {
 
-			showAllSegments();
+		if (!_visibleSegments.empty())
+			send<HideSegments>(_visibleSegments);
+		_visibleSegments.clear();
+	}
 
-		} else if (std::string(input).find("largest ") == 0) {
+	if (signal.key == sg_gui::keys::E)
+		exportVisibleSegments();
+}
 
-			size_t k = boost::lexical_cast<size_t>(std::string(input).substr(8));
-			showLargestSegments(k);
+void
+SegmentController::onSignal(sg_gui::Draw& signal) {
 
-		} else {
+	bool active = false;
+
+	std::string command;
+	while (_commands.next(command)) {
+
+		executeCommand(command);
+		active = true;
+	}
+
+	std::deque<std::function<void()>> results;
+	{
+		std::lock_guard<std::mutex> lock(_resultsMutex);
+		results.swap(_results);
+	}
+
+	for (auto& result : results) {
+
+		if (result)
+			result();
+		_running--;
+		active = true;
+	}
+
+	// signals are only sent on the GUI thread, ask for another frame to poll
+	// again, slowly while nothing happens
+	if (_commands.busy() || _running > 0) {
+
+		_poll.wait(signal, active);
+		send<sg_gui::ContentChanged>();
+	}
+}
+
+void
+SegmentController::executeCommand(const std::string& command) {
+
+	LOG_DEBUG(segmentcontrollerlog) << "executing command '" << command << "'" << std::endl;
+
+	try {
+
+		if (command == "all") {
+
+			runInBackground([this]() -> std::function<void()> {
 
-			try {
+				std::vector<uint64_t> ids = _statistics->getIds();
 
-				std::vector<std::string> tokens = split(input, ',');
+				return [this, ids]() {
 
-				for (auto& token : tokens) {
+					LOG_USER(segmentcontrollerlog) << "showing " << ids.size() << " meshes..." << std::endl;
+					showSegments(ids);
+				};
+			});
 
-					uint64_t label = boost::lexical_cast<uint64_t>(token);
-					toggleSegment(label);
-				}
+		} else if (command.find("largest ") == 0) {
 
-			} catch (std::exception& e) {
+			size_t k = boost::lexical_cast<size_t>(command.substr(8));
 
-				LOG_ERROR(segmentcontrollerlog) << "invalid input" << std::endl;
+			runInBackground([this, k]() -> std::function<void()> {
+
+				std::vector<uint64_t> ids = _statistics->getLargest(k);
+
+				return [this, ids]() {
+
+					LOG_USER(segmentcontrollerlog) << "showing " << ids.size() << " largest meshes..." << std::endl;
+					showSegments(ids);
+				};
+			});
+
+		} else if (command.find("top ") == 0) {
+
+			size_t k = boost::lexical_cast<size_t>(command.substr(4));
+
+			runInBackground([this, k]() -> std::function<void()> {
+
+				listLargestSegments(k);
+				return std::function<void()>();
+			});
+
+		} else if (command.find("neighbors ") == 0) {
+
+			std::vector<std::string> tokens = split(command.substr(10), ' ');
+
+			size_t   k  = boost::lexical_cast<size_t>(tokens.at(0));
+			uint64_t id = (tokens.size() > 1 ? boost::lexical_cast<uint64_t>(tokens[1]) : _selected);
+
+			if (id == 0) {
+
+				LOG_USER(segmentcontrollerlog) << "no segment selected" << std::endl;
 				return;
 			}
+
+			runInBackground([this, id, k]() -> std::function<void()> {
+
+				std::vector<uint64_t> ids = getNeighbors(id, k);
+
+				return [this, ids]() { showSegments(ids); };
+			});
+
+		} else {
+
+			std::vector<std::string> tokens = split(command, ',');
+
+			for (auto& token : tokens) {
+
+				uint64_t label = boost::lexical_cast<uint64_t>(token);
+				toggleSegment(label);
+			}
 		}
-	}
 
-	if (signal.key == sg_gui::keys::C) {
+	} catch (std::exception& e) {
 
-		for (uint64_t id : _visibleSegments)
-			send<sg_gui::HideSegment>(id);
-		_visibleSegments.clear();
+		LOG_ERROR(segmentcontrollerlog) << "invalid input '" << command << "'" << std::endl;
 	}
 }
 
+void
+SegmentController::runInBackground(std::function<std::function<void()>()> job) {
+
+	_running++;
+
+	_worker.schedule([this, job]() {
+
+		std::function<void()> result;
+
+		try {
+
+			result = job();
+
+		} catch (...) {
+
+			result = []() { LOG_ERROR(segmentcontrollerlog) << "command failed" << std::endl; };
+		}
+
+		std::lock_guard<std::mutex> lock(_resultsMutex);
+		_results.push_back(result);
+	});
+
+	send<sg_gui::ContentChanged>();
+}
+
 void
 SegmentController::toggleSegment(uint64_t id) {
 
@@ -91,48 +222,99 @@ SegmentController::toggleSegment(uint64_t id) {
 }
 
 void
-SegmentController::showAllSegments() {
-
-	std::set<uint64_t> allIds;
-	for (uint64_t id : _labels->data())
-		allIds.insert(id);
+SegmentController::showSegments(const std::vector<uint64_t>& ids) {
 
-	LOG_USER(segmentcontrollerlog) << "showing " << allIds.size() << " meshes..." << std::endl;
+	std::set<uint64_t> hidden;
+	for (uint64_t id : ids)
+		if (!_visibleSegments.count(id))
+			hidden.insert(id);
 
-	for (uint64_t id : allIds) {
+	if (hidden.empty())
+		return;
 
-		send<sg_gui::ShowSegment>(id);
-		_visibleSegments.insert(id);
-	}
+	send<ShowSegments>(hidden);
+	_visibleSegments.insert(hidden.begin(), hidden.end());
 }
 
 void
-SegmentController::showLargestSegments(size_t k) {
+SegmentController::listLargestSegments(size_t k) {
+
+	LOG_USER(segmentcontrollerlog) << _statistics->size() << " labels, the " << k << " largest are:" << std::endl;
+
+	for (uint64_t id : _statistics->getLargest(k)) {
+
+		const LabelStatistics::Label& label = (*_statistics)[id];
+
+		LOG_USER(segmentcontrollerlog)
+				<< "\t" << id
+				<< "\t" << label.size << " voxels"
+				<< "\tcentroid " << _statistics->getCentroid(id)
+				<< "\tbounding box " << _statistics->getBoundingBox(id)
+				<< std::endl;
+	}
+}
 
-	std::map<uint64_t, size_t> sizes;
-	for (uint64_t id : _labels->data())
-		sizes[id]++;
+std::vector<uint64_t>
+SegmentController::getNeighbors(uint64_t id, size_t k) {
 
-	auto sort = [](
-			const std::pair<uint64_t, size_t>& a,
-			const std::pair<uint64_t, size_t>& b) {
+	const std::vector<RegionAdjacencyGraph::Neighbor>& neighbors = _rag->getNeighbors(id);
 
-		return a.second < b.second;
-	};
+	k = std::min(k, neighbors.size());
 
-	std::priority_queue<std::pair<uint64_t, size_t>, std::vector<std::pair<uint64_t, size_t>>, decltype(sort)> queue(sort);
-	for (const auto& p : sizes)
-		queue.push(p);
+	LOG_USER(segmentcontrollerlog) << "showing " << k << " of " << neighbors.size() << " neighbors of " << id << std::endl;
 
-	LOG_USER(segmentcontrollerlog) << "showing " << k << " largest meshes..." << std::endl;
+	std::vector<uint64_t> ids(1, id);
 
 	for (size_t i = 0; i < k; i++) {
 
-		auto p = queue.top();
-		queue.pop();
+		uint64_t neighbor = neighbors[i].id;
 
-		uint64_t id = p.first;
-		send<sg_gui::ShowSegment>(id);
-		_visibleSegments.insert(id);
+		LOG_USER(segmentcontrollerlog)
+				<< "\t" << neighbor
+				<< "\tcontact area " << neighbors[i].contactArea
+				<< "\tsize " << (*_statistics)[neighbor].size << " voxels"
+				<< std::endl;
+
+		ids.push_back(neighbor);
+	}
+
+	return ids;
+}
+
+void
+SegmentController::exportVisibleSegments() {
+
+	if (!_meshExporter) {
+
+		LOG_USER(segmentcontrollerlog) << "mesh export is not configured" << std::endl;
+		return;
+	}
+
+	if (_visibleSegments.empty()) {
+
+		LOG_USER(segmentcontrollerlog) << "no segments visible" << std::endl;
+		return;
 	}
+
+	LOG_USER(segmentcontrollerlog)
+			<< "exporting meshes of " << _visibleSegments.size() << " segments to "
+			<< _meshExporter->getDirectory() << "..." << std::endl;
+
+	std::vector<uint64_t> ids(_visibleSegments.begin(), _visibleSegments.end());
+	std::shared_ptr<MeshExporter> exporter = _meshExporter;
+
+	runInBackground([exporter, ids]() -> std::function<void()> {
+
+		try {
+
+			exporter->exportMeshes(ids);
+
+		} catch (boost::exception& e) {
+
+			LOG_ERROR(segmentcontrollerlog) << "mesh export failed" << std::endl;
+			handleException(e, std::cerr);
+		}
+
+		return std::function<void()>();
+	});
 }
@@ -1,44 +1,113 @@
 #ifndef CANDIDATE_MC_GUI_SEGMENT_CONTROLLER_H__
 #define CANDIDATE_MC_GUI_SEGMENT_CONTROLLER_H__
 
+#include <deque>
+#include <functional>
+#include <mutex>
 #include <scopegraph/Agent.h>
+#include <sg_gui/GuiSignals.h>
 #include <sg_gui/KeySignals.h>
 #include <sg_gui/SegmentSignals.h>
 #include <sg_gui/VolumeView.h>
 #include <imageprocessing/ExplicitVolume.h>
+#include <analysis/LabelStatistics.h>
+#include <analysis/MeshExporter.h>
+#include <analysis/RegionAdjacencyGraph.h>
+#include <io/ThreadPool.h>
+#include "CommandChannel.h"
+#include "PollThrottle.h"
+#include "SegmentSignals.h"
 
 class SegmentController :
 		public sg::Agent<
 				SegmentController,
 				sg::Accepts<
 						sg_gui::VolumePointSelected,
-						sg_gui::KeyDown
+						sg_gui::KeyDown,
+						sg_gui::Draw
 				>,
 				sg::Provides<
+						sg_gui::ContentChanged,
 						sg_gui::ShowSegment,
-						sg_gui::HideSegment
+						sg_gui::HideSegment,
+						ShowSegments,
+						HideSegments
 				>
 		> {
 
 public:
 
-	SegmentController(std::shared_ptr<ExplicitVolume<uint64_t>> labels);
+	SegmentController(
+			std::shared_ptr<ExplicitVolume<uint64_t>> labels,
+			std::shared_ptr<LabelStatistics> statistics,
+			std::shared_ptr<RegionAdjacencyGraph> rag);
 
 	void onSignal(sg_gui::VolumePointSelected& signal);
 
 	void onSignal(sg_gui::KeyDown& signal);
 
+	/**
+	 * Executes the commands that were entered and delivers the results of
+	 * commands that finished in the background.
+	 */
+	void onSignal(sg_gui::Draw& signal);
+
+	/**
+	 * Read commands (as entered after pressing 'i') from the named pipe at
+	 * the given path, such that the viewer can be scripted.
+	 */
+	void listen(const std::string& path) { _commands.listen(path); }
+
+	/**
+	 * Set the exporter to write the meshes of the visible segments with, when
+	 * 'e' is pressed.
+	 */
+	void setMeshExporter(std::shared_ptr<MeshExporter> exporter) { _meshExporter = exporter; }
+
 private:
 
+	void executeCommand(const std::string& command);
+
+	// run a job on the worker thread, the function it returns (if any) is
+	// called on the GUI thread with the next draw
+	void runInBackground(std::function<std::function<void()>()> job);
+
 	void toggleSegment(uint64_t id);
 
-	void showAllSegments();
+	// show the given segments that are not visible already, with a single
+	// signal
+	void showSegments(const std::vector<uint64_t>& ids);
+
+	void listLargestSegments(size_t k);
 
-	void showLargestSegments(size_t k);
+	// get the segment and its k neighbors with the largest contact area
+	std::vector<uint64_t> getNeighbors(uint64_t id, size_t k);
+
+	void exportVisibleSegments();
 
 	std::shared_ptr<ExplicitVolume<uint64_t>> _labels;
+	std::shared_ptr<LabelStatistics>          _statistics;
+	std::shared_ptr<RegionAdjacencyGraph>     _rag;
+	std::shared_ptr<MeshExporter>             _meshExporter;
+
+	// the last segment selected with the mouse
+	uint64_t _selected;
 
 	std::set<uint64_t> _visibleSegments;
+
+	CommandChannel _commands;
+
+	// results of background jobs to be delivered on the GUI thread, and the
+	// number of jobs that did not deliver yet
+	std::deque<std::function<void()>> _results;
+	std::mutex                        _resultsMutex;
+	unsigned int                      _running;
+
+	PollThrottle _poll;
+
+	// last, such that pending jobs finish before the members they use are 
+	// destructed
+	ThreadPool _worker;
 };
 
 #endif // CANDIDATE_MC_GUI_SEGMENT_CONTROLLER_H__
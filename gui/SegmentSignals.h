@@ -0,0 +1,55 @@
+#ifndef TOOLS_GUI_SEGMENT_SIGNALS_H__
+#define TOOLS_GUI_SEGMENT_SIGNALS_H__
+
+#include <set>
+#include <sg_gui/GuiSignals.h>
+
+/**
+ * Base for signals that change the visibility of several segments at once.
+ */
+class SegmentsSignal : public sg_gui::GuiSignal {
+
+public:
+
+	typedef sg_gui::GuiSignal parent_type;
+
+	SegmentsSignal(const std::set<uint64_t>& ids) :
+		_ids(ids) {}
+
+	const std::set<uint64_t>& getIds() const { return _ids; }
+
+private:
+
+	std::set<uint64_t> _ids;
+};
+
+/**
+ * Show several segments, like sending sg_gui::ShowSegment for each of them,
+ * but handled at once.
+ */
+class ShowSegments : public SegmentsSignal {
+
+public:
+
+	typedef SegmentsSignal parent_type;
+
+	ShowSegments(const std::set<uint64_t>& ids) :
+		SegmentsSignal(ids) {}
+};
+
+/**
+ * Hide several segments, like sending sg_gui::HideSegment for each of them,
+ * but handled at once.
+ */
+class HideSegments : public SegmentsSignal {
+
+public:
+
+	typedef SegmentsSignal parent_type;
+
+	HideSegments(const std::set<uint64_t>& ids) :
+		SegmentsSignal(ids) {}
+};
+
+#endif // TOOLS_GUI_SEGMENT_SIGNALS_H__
+
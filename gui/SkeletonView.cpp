@@ -1,9 +1,9 @@
 #include "SkeletonView.h"
+#include <cmath>
 #include <sg_gui/OpenGl.h>
 #include <sg_gui/Colors.h>
 #include <util/ProgramOptions.h>
 #include <util/Logger.h>
-#include <util/geometry.hpp>
 
 logger::LogChannel skeletonviewlog("skeletonviewlog", "[SkeletonView] ");
 
@@ -13,42 +13,156 @@ util::ProgramOption optionSkeletonSphereScale(
 		util::_description_text = "The initial scale of the skeleton spheres to show. Default is 1.",
 		util::_default_value    = 1.0);
 
+util::ProgramOption optionSkeletonLodTolerance(
+		util::_module           = "gui",
+		util::_long_name        = "skeletonLodTolerance",
+		util::_description_text = "The error in screen pixels allowed when drawing simplified skeletons at low zoom. "
+		                          "Set to 0 to always draw all edges. Default is 1.",
+		util::_default_value    = 1.0);
+
+namespace {
+
+// test whether a bounding box intersects the region of interest of a draw
+// signal, considering only the dimensions in which the region is not empty
+bool
+intersects(const util::box<float,3>& box, const util::box<float,3>& roi) {
+
+	if (roi.max().x() > roi.min().x())
+		if (box.max().x() < roi.min().x() || box.min().x() > roi.max().x())
+			return false;
+
+	if (roi.max().y() > roi.min().y())
+		if (box.max().y() < roi.min().y() || box.min().y() > roi.max().y())
+			return false;
+
+	if (roi.max().z() > roi.min().z())
+		if (box.max().z() < roi.min().z() || box.min().z() > roi.max().z())
+			return false;
+
+	return true;
+}
+
+} // namespace
+
 SkeletonView::SkeletonView() :
 	_visibleSkeletons(std::make_shared<Skeletons>()),
 	_currentScoreIndex(0),
 	_invertScores(false),
 	_showFocus(false),
+	_focusEdge(-1),
 	_showNumbers(true),
 	_showZeroLines(true),
 	_sphere(10),
 	_showSpheres(false),
 	_sphereScale(optionSkeletonSphereScale),
-	_ftfont("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf") {
+	_lodTolerance(optionSkeletonLodTolerance),
+	_unitSphereList(0),
+	_scaledSphereList(0),
+	_recordedSphereScale(0),
+	_scoresList(0),
+	_labelsList(0),
+	_scoresChanged(true),
+	_labelsChanged(true),
+	_ftfont("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf"),
+	_haveSkeletonized(false),
+	_pool(1) {
 
 	_ftfont.FaceSize(100);
 	_ftfont.CharMap(ft_encoding_unicode);
 }
 
+SkeletonView::~SkeletonView() {
+
+	deleteLists(true);
+}
+
 void
 SkeletonView::setSkeletons(std::shared_ptr<Skeletons> skeletons) {
 
 	_skeletons = skeletons;
 	_visibleSkeletons->clear();
+	_flatSkeletons.clear();
+	_waiting.clear();
+
+	// the lists of the skeletons are recorded again when they get visible
+	deleteLists(false);
 
-	updateRecording();
 	send<sg_gui::ContentChanged>();
 }
 
 void
-SkeletonView::onSignal(sg_gui::Draw& /*draw*/) {
+SkeletonView::onSignal(sg_gui::Draw& signal) {
+
+	// checked before taking the skeletons, such that none that are done in
+	// between are missed
+	bool skeletonizing;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		skeletonizing = !_skeletonizing.empty();
+	}
+
+	bool added = addSkeletonized();
+
+	// signals are only sent on the GUI thread, ask for another frame to take
+	// the skeletons still being created, and for the size of the new ones
+	if (skeletonizing || added) {
+
+		_poll.wait(signal, added);
+		send<sg_gui::ContentChanged>();
+	}
+
+	if (_visibleSkeletons->size() == 0)
+		return;
+
+	// the resolution is in screen pixels per world unit
+	float tolerance = 0;
+	if (signal.resolution().x() > 0)
+		tolerance = _lodTolerance/signal.resolution().x();
+
+	updateSphereLists();
+
+	glLineWidth(2.0);
+	glEnable(GL_LINE_SMOOTH);
+
+	GLfloat specular[] = {0.2, 0.2, 0.2, 1.0};
+	glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, specular);
+	GLfloat shininess[] = {0.2, 0.2, 0.2, 1.0};
+	glMaterialfv(GL_FRONT_AND_BACK, GL_SHININESS, shininess);
+
+	for (uint64_t id : _visibleSkeletons->getSkeletonIds()) {
+
+		SkeletonLists& lists = getSkeletonLists(id);
+
+		if (!intersects(lists.simplified->getBoundingBox(), signal.roi()))
+			continue;
+
+		unsigned char r, g, b;
+		sg_gui::idToRgb(id+1, r, g, b);
+		glColor4f(
+				static_cast<float>(r)/200.0,
+				static_cast<float>(g)/200.0,
+				static_cast<float>(b)/200.0,
+				1.0);
 
-	draw();
+		glCallList(getEdgeList(lists, lists.simplified->getLevel(tolerance)));
+
+		if (_showSpheres)
+			glCallList(getSphereList(lists, id));
+	}
 }
 
 void
 SkeletonView::onSignal(sg_gui::DrawTranslucent& /*draw*/) {
 
-	drawTranslucent();
+	if (_edgeMatchScores.size() == 0)
+		return;
+
+	updateScoreLists();
+
+	glCallList(_scoresList);
+
+	if (_showNumbers)
+		glCallList(_labelsList);
 }
 
 void
@@ -62,6 +176,8 @@ SkeletonView::onSignal(sg_gui::MouseDown& signal) {
 
 	if (signal.modifiers & sg_gui::keys::ShiftDown) {
 
+		// the sphere scale is applied when drawing, no need to record the
+		// skeletons again
 		if (signal.button == sg_gui::buttons::WheelUp) {
 
 			_sphereScale *= 1.1;
@@ -74,7 +190,6 @@ SkeletonView::onSignal(sg_gui::MouseDown& signal) {
 			signal.processed = true;
 		}
 
-		updateRecording();
 		send<sg_gui::ContentChanged>();
 	}
 
@@ -82,7 +197,8 @@ SkeletonView::onSignal(sg_gui::MouseDown& signal) {
 
 		findClosestEdge(signal.ray);
 
-		updateRecording();
+		_scoresChanged = true;
+		_labelsChanged = true;
 		send<sg_gui::ContentChanged>();
 	}
 }
@@ -93,42 +209,42 @@ SkeletonView::onSignal(sg_gui::KeyDown& signal) {
 	if (signal.key == sg_gui::keys::S) {
 
 		_showSpheres = !_showSpheres;
-		updateRecording();
 		send<sg_gui::ContentChanged>();
 	}
 
 	if (signal.key == sg_gui::keys::A) {
 
 		_currentScoreIndex = std::max(0, _currentScoreIndex - 1);
-		updateRecording();
+		_scoresChanged = true;
+		_labelsChanged = true;
 		send<sg_gui::ContentChanged>();
 	}
 
 	if (signal.key == sg_gui::keys::D) {
 
 		_currentScoreIndex = std::min((int)_edgeMatchScores.size() - 1, _currentScoreIndex + 1);
-		updateRecording();
+		_scoresChanged = true;
+		_labelsChanged = true;
 		send<sg_gui::ContentChanged>();
 	}
 
 	if (signal.key == sg_gui::keys::I) {
 
 		_invertScores = !_invertScores;
-		updateRecording();
+		_scoresChanged = true;
 		send<sg_gui::ContentChanged>();
 	}
 
 	if (signal.key == sg_gui::keys::N) {
 
 		_showNumbers = !_showNumbers;
-		updateRecording();
 		send<sg_gui::ContentChanged>();
 	}
 
 	if (signal.key == sg_gui::keys::Z) {
 
 		_showZeroLines= !_showZeroLines;
-		updateRecording();
+		_scoresChanged = true;
 		send<sg_gui::ContentChanged>();
 	}
 }
@@ -144,144 +260,413 @@ SkeletonView::onSignal(sg_gui::ShowSegment& signal) {
 
 	LOG_DEBUG(skeletonviewlog) << "showing skeleton for " << signal.getId() << std::endl;
 
-	if (!_skeletons || !_skeletons->contains(signal.getId())) {
+	skeletonize(std::set<uint64_t>{signal.getId()});
 
-		LOG_DEBUG(skeletonviewlog) << "don't have a skeleton for this ID" << std::endl;
+	if (!showSkeleton(signal.getId()))
 		return;
-	}
-
-	_visibleSkeletons->add(signal.getId(), _skeletons->get(signal.getId()));
 
-	updateRecording();
 	send<sg_gui::ContentChanged>();
 }
 
 void
 SkeletonView::onSignal(sg_gui::HideSegment& signal) {
 
+	_waiting.erase(signal.getId());
+
+	if (!_visibleSkeletons->contains(signal.getId()))
+		return;
+
+	// the lists of hidden skeletons are kept, showing them again is cheap
 	_visibleSkeletons->remove(signal.getId());
 
-	updateRecording();
 	send<sg_gui::ContentChanged>();
 }
 
 void
-SkeletonView::updateRecording() {
+SkeletonView::onSignal(ShowSegments& signal) {
 
-	sg_gui::OpenGl::Guard guard;
+	LOG_DEBUG(skeletonviewlog) << "showing skeletons for " << signal.getIds().size() << " segments" << std::endl;
 
-	startRecording();
+	skeletonize(signal.getIds());
 
-	for (uint64_t id : _visibleSkeletons->getSkeletonIds()) {
+	bool changed = false;
+	for (uint64_t id : signal.getIds())
+		changed |= showSkeleton(id);
 
-		auto skeleton = _visibleSkeletons->get(id);
-		unsigned char r, g, b;
-		sg_gui::idToRgb(id+1, r, g, b);
-		glColor4f(
-				static_cast<float>(r)/200.0,
-				static_cast<float>(g)/200.0,
-				static_cast<float>(b)/200.0,
-				1.0);
+	if (!changed)
+		return;
+
+	send<sg_gui::ContentChanged>();
+}
+
+void
+SkeletonView::onSignal(HideSegments& signal) {
+
+	bool changed = false;
+	for (uint64_t id : signal.getIds()) {
+
+		_waiting.erase(id);
+
+		if (_visibleSkeletons->contains(id)) {
 
-		drawSkeleton(*skeleton);
+			_visibleSkeletons->remove(id);
+			changed = true;
+		}
 	}
 
-	stopRecording();
+	if (!changed)
+		return;
 
-	startRecordingTranslucent();
+	send<sg_gui::ContentChanged>();
+}
 
-	if (_edgeMatchScores.size() > 0)
-		drawEdgeMatchScores(*_edgeMatchScores[_currentScoreIndex]);
+bool
+SkeletonView::showSkeleton(uint64_t id) {
 
-	stopRecording();
+	if (!_skeletons || !_skeletons->contains(id)) {
+
+		LOG_DEBUG(skeletonviewlog) << "don't have a skeleton for ID " << id << std::endl;
+		return false;
+	}
+
+	_visibleSkeletons->add(id, _skeletons->get(id));
+
+	return true;
 }
 
 void
-SkeletonView::drawSkeleton(const Skeleton& skeleton) {
+SkeletonView::skeletonize(const std::set<uint64_t>& ids) {
 
-	glLineWidth(2.0);
-	glEnable(GL_LINE_SMOOTH);
+	if (!_skeletonizer)
+		return;
 
-	GLfloat specular[] = {0.2, 0.2, 0.2, 1.0};
-	glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, specular);
-	GLfloat shininess[] = {0.2, 0.2, 0.2, 1.0};
-	glMaterialfv(GL_FRONT_AND_BACK, GL_SHININESS, shininess);
+	if (!_skeletons)
+		_skeletons = std::make_shared<Skeletons>();
+
+	std::vector<uint64_t> missing;
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		for (uint64_t id : ids) {
+
+			if (_skeletons->contains(id) || _noSkeleton.count(id))
+				continue;
+
+			_waiting.insert(id);
+
+			if (_skeletonizing.count(id) || _skeletonized.count(id))
+				continue;
+
+			_skeletonizing.insert(id);
+			missing.push_back(id);
+		}
+	}
+
+	if (missing.empty())
+		return;
+
+	LOG_USER(skeletonviewlog) << "skeletonizing " << missing.size() << " segments..." << std::endl;
+
+	std::shared_ptr<Skeletonizer> skeletonizer = _skeletonizer;
+
+	_pool.schedule([this, skeletonizer, missing]() {
+
+		try {
+
+			skeletonizer->skeletonize(missing, [this](uint64_t id, std::shared_ptr<Skeleton> skeleton) {
+
+				std::lock_guard<std::mutex> lock(_mutex);
+
+				_skeletonizing.erase(id);
 
-	for (Skeleton::Graph::EdgeIt e(skeleton.graph()); e != lemon::INVALID; ++e) {
+				if (lemon::countNodes(skeleton->graph()) > 0) {
 
-		Skeleton::Node u = skeleton.graph().u(e);
-		Skeleton::Node v = skeleton.graph().v(e);
+					_skeletonized[id] = skeleton;
+					_haveSkeletonized = true;
 
-		Skeleton::Position pu = skeleton.positions()[u];
-		Skeleton::Position pv = skeleton.positions()[v];
+				} else {
 
-		util::point<float,3> ru;
-		util::point<float,3> rv;
-		skeleton.getRealLocation(pu, ru);
-		skeleton.getRealLocation(pv, rv);
+					_noSkeleton.insert(id);
+				}
+			});
 
-		if (_showSpheres) {
+		} catch (std::exception& e) {
 
-			float diameter = skeleton.diameters()[u];
-			drawSphere(ru, diameter*_sphereScale);
+			LOG_ERROR(skeletonviewlog) << "can not skeletonize segments: " << e.what() << std::endl;
 		}
 
-		glBegin(GL_LINES);
-		glVertex3d(ru.x(), ru.y(), ru.z());
-		glVertex3d(rv.x(), rv.y(), rv.z());
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		// segments that are not done failed
+		for (uint64_t id : missing)
+			if (_skeletonizing.erase(id))
+				_noSkeleton.insert(id);
+	});
+
+	// start polling for the skeletons
+	send<sg_gui::ContentChanged>();
+}
+
+bool
+SkeletonView::addSkeletonized() {
+
+	if (!_haveSkeletonized.exchange(false))
+		return false;
+
+	std::map<uint64_t, std::shared_ptr<Skeleton>> skeletonized;
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		std::swap(skeletonized, _skeletonized);
+	}
+
+	if (skeletonized.empty())
+		return false;
+
+	if (!_skeletons)
+		_skeletons = std::make_shared<Skeletons>();
+
+	for (auto& p : skeletonized) {
+
+		_skeletons->add(p.first, p.second);
+
+		if (_waiting.erase(p.first))
+			showSkeleton(p.first);
+	}
+
+	return true;
+}
+
+SkeletonView::SkeletonLists&
+SkeletonView::getSkeletonLists(uint64_t id) {
+
+	auto i = _skeletonLists.find(id);
+	if (i != _skeletonLists.end())
+		return i->second;
+
+	LOG_ALL(skeletonviewlog) << "simplifying skeleton " << id << std::endl;
+
+	SkeletonLists& lists = _skeletonLists[id];
+	lists.simplified = std::make_shared<SimplifiedSkeleton>(getFlatSkeleton(_visibleSkeletons->get(id)));
+	lists.edges.resize(lists.simplified->numLevels(), 0);
+	lists.spheres = 0;
+
+	return lists;
+}
+
+GLuint
+SkeletonView::getEdgeList(SkeletonLists& lists, unsigned int level) {
+
+	if (lists.edges[level] != 0)
+		return lists.edges[level];
+
+	lists.edges[level] = glGenLists(1);
+
+	glNewList(lists.edges[level], GL_COMPILE);
+	drawSegments(lists.simplified->getSegments(level));
+	glEndList();
+
+	return lists.edges[level];
+}
+
+GLuint
+SkeletonView::getSphereList(SkeletonLists& lists, uint64_t id) {
+
+	if (lists.spheres != 0)
+		return lists.spheres;
+
+	lists.spheres = glGenLists(1);
+
+	glNewList(lists.spheres, GL_COMPILE);
+	drawSkeletonSpheres(getFlatSkeleton(_visibleSkeletons->get(id)));
+	glEndList();
+
+	return lists.spheres;
+}
+
+void
+SkeletonView::updateSphereLists() {
+
+	if (_unitSphereList == 0) {
+
+		_unitSphereList   = glGenLists(2);
+		_scaledSphereList = _unitSphereList + 1;
+
+		const std::vector<sg_gui::Triangle>& triangles = _sphere.getTriangles();
+
+		glNewList(_unitSphereList, GL_COMPILE);
+		glBegin(GL_TRIANGLES);
+		for (const sg_gui::Triangle& triangle : triangles) {
+
+			const sg_gui::Point3d&  v0 = _sphere.getVertex(triangle.v0);
+			const sg_gui::Point3d&  v1 = _sphere.getVertex(triangle.v1);
+			const sg_gui::Point3d&  v2 = _sphere.getVertex(triangle.v2);
+			const sg_gui::Vector3d& n0 = _sphere.getNormal(triangle.v0);
+			const sg_gui::Vector3d& n1 = _sphere.getNormal(triangle.v1);
+			const sg_gui::Vector3d& n2 = _sphere.getNormal(triangle.v2);
+
+			glNormal3f(n0.x(), n0.y(), n0.z()); glVertex3f(v0.x(), v0.y(), v0.z());
+			glNormal3f(n1.x(), n1.y(), n1.z()); glVertex3f(v1.x(), v1.y(), v1.z());
+			glNormal3f(n2.x(), n2.y(), n2.z()); glVertex3f(v2.x(), v2.y(), v2.z());
+		}
 		glEnd();
+		glEndList();
+
+		_recordedSphereScale = 0;
+	}
+
+	// the sphere lists of the skeletons call the scaled sphere by name, such
+	// that changing the scale means recording only this list
+	if (_recordedSphereScale != _sphereScale) {
+
+		glNewList(_scaledSphereList, GL_COMPILE);
+		glScalef(_sphereScale, _sphereScale, _sphereScale);
+		glCallList(_unitSphereList);
+		glEndList();
+
+		_recordedSphereScale = _sphereScale;
 	}
 }
 
 void
-SkeletonView::drawEdgeMatchScores(const SkeletonEdgeMatchScores& scores) {
+SkeletonView::updateScoreLists() {
 
-	LOG_USER(logger::out) << "showing matching scores " << scores.getName() << std::endl;
+	const SkeletonEdgeMatchScores& scores = *_edgeMatchScores[_currentScoreIndex];
 
-	const Skeleton& a = *scores.getSource();
-	const Skeleton& b = *scores.getTarget();
+	if (_scoresList == 0) {
 
-	double maxScore = scores.getMaxScore();
+		_scoresList = glGenLists(2);
+		_labelsList = _scoresList + 1;
+	}
 
-	for (Skeleton::Graph::EdgeIt e(a.graph()); e != lemon::INVALID; ++e) {
+	if (_scoresChanged) {
 
-		if (_showFocus)
-			if (scores.getSource() == _focusSkeleton && e != _focusEdge)
-				continue;
+		LOG_USER(logger::out) << "showing matching scores " << scores.getName() << std::endl;
+
+		glNewList(_scoresList, GL_COMPILE);
+		drawEdgeMatchScores(scores, false);
+		glEndList();
+
+		_scoresChanged = false;
+	}
+
+	// the labels are recorded only when they are shown
+	if (_labelsChanged && _showNumbers) {
+
+		glNewList(_labelsList, GL_COMPILE);
+		drawEdgeMatchScores(scores, true);
+		glEndList();
+
+		_labelsChanged = false;
+	}
+}
+
+void
+SkeletonView::deleteLists(bool all) {
+
+	bool haveShared = (_unitSphereList != 0 || _scoresList != 0);
+
+	if (_skeletonLists.size() == 0 && !(all && haveShared))
+		return;
+
+	sg_gui::OpenGl::Guard guard;
+
+	if (all) {
+
+		// the sphere and score lists were generated in pairs
+		if (_unitSphereList != 0)
+			glDeleteLists(_unitSphereList, 2);
+		if (_scoresList != 0)
+			glDeleteLists(_scoresList, 2);
+
+		_unitSphereList   = 0;
+		_scaledSphereList = 0;
+		_scoresList       = 0;
+		_labelsList       = 0;
+	}
+
+	for (const auto& p : _skeletonLists) {
+
+		for (GLuint list : p.second.edges)
+			if (list != 0)
+				glDeleteLists(list, 1);
+
+		if (p.second.spheres != 0)
+			glDeleteLists(p.second.spheres, 1);
+	}
+
+	_skeletonLists.clear();
+}
+
+void
+SkeletonView::drawSegments(const std::vector<util::point<float,3>>& segments) {
+
+	glBegin(GL_LINES);
+	for (const util::point<float,3>& p : segments)
+		glVertex3f(p.x(), p.y(), p.z());
+	glEnd();
+}
+
+void
+SkeletonView::drawSkeletonSpheres(const FlatSkeleton& skeleton) {
 
-		Skeleton::Node au = a.graph().u(e);
-		Skeleton::Node av = a.graph().v(e);
+	for (size_t i = 0; i < skeleton.numNodes(); i++) {
 
-		Skeleton::Position apu = a.positions()[au];
-		Skeleton::Position apv = a.positions()[av];
+		float diameter = skeleton.diameters()[i];
 
-		util::point<float,3> aru;
-		util::point<float,3> arv;
-		a.getRealLocation(apu, aru);
-		a.getRealLocation(apv, arv);
+		glPushMatrix();
+		glTranslatef(skeleton.x()[i], skeleton.y()[i], skeleton.z()[i]);
+		glScalef(diameter, diameter, diameter);
+		glCallList(_scaledSphereList);
+		glPopMatrix();
+	}
+}
+
+void
+SkeletonView::drawEdgeMatchScores(const SkeletonEdgeMatchScores& scores, bool labels) {
 
-		util::point<float,3> acenter = (aru + arv)/2.0;
+	const FlatSkeleton& a = getFlatSkeleton(scores.getSource());
+	const FlatSkeleton& b = getFlatSkeleton(scores.getTarget());
 
-		for (Skeleton::Graph::EdgeIt f(b.graph()); f != lemon::INVALID; ++f) {
+	std::vector<float> ax, ay, az;
+	std::vector<float> bx, by, bz;
+	a.getMidpoints(ax, ay, az);
+	b.getMidpoints(bx, by, bz);
+
+	double maxScore = scores.getMaxScore();
+
+	for (size_t e = 0; e < a.numEdges(); e++) {
+
+		if (_showFocus)
+			if (scores.getSource() == _focusSkeleton && a.edgeIds()[e] != _focusEdge)
+				continue;
+
+		util::point<float,3> acenter(ax[e], ay[e], az[e]);
+
+		for (size_t f = 0; f < b.numEdges(); f++) {
 
 			if (_showFocus)
-				if (scores.getTarget() == _focusSkeleton && f != _focusEdge)
+				if (scores.getTarget() == _focusSkeleton && b.edgeIds()[f] != _focusEdge)
 					continue;
 
-			Skeleton::Node bu = b.graph().u(f);
-			Skeleton::Node bv = b.graph().v(f);
+			util::point<float,3> bcenter(bx[f], by[f], bz[f]);
 
-			Skeleton::Position bpu = b.positions()[bu];
-			Skeleton::Position bpv = b.positions()[bv];
+			double score = scores.getScore(a.edgeIds()[e], b.edgeIds()[f]);
 
-			util::point<float,3> bru;
-			util::point<float,3> brv;
-			b.getRealLocation(bpu, bru);
-			b.getRealLocation(bpv, brv);
+			if (labels) {
 
-			util::point<float,3> bcenter = (bru + brv)/2.0;
+				glColor4f(0.5, 0.5, 1, 1);
+				util::point<float,3> middle = (acenter + bcenter)/2.0;
+				glPushMatrix();
+				glTranslatef(middle.x(), middle.y(), middle.z());
+				glScalef(0.01, -0.01, 0.01);
+				_ftfont.Render(boost::lexical_cast<std::string>(score).c_str());
+				glPopMatrix();
+
+				continue;
+			}
 
-			double score = scores.getScore(a.graph().id(e), b.graph().id(f));
 			double s = score;
 			if (_invertScores)
 				s = maxScore - score;
@@ -293,87 +678,37 @@ SkeletonView::drawEdgeMatchScores(const SkeletonEdgeMatchScores& scores) {
 			glVertex3d(acenter.x(), acenter.y(), acenter.z());
 			glVertex3d(bcenter.x(), bcenter.y(), bcenter.z());
 			glEnd();
-
-			if (_showNumbers) {
-
-				glColor4f(0.5, 0.5, 1, 1);
-				util::point<float,3> middle = (acenter + bcenter)/2.0;
-				glPushMatrix();
-				glTranslatef(middle.x(), middle.y(), middle.z());
-				glScalef(0.01, -0.01, 0.01);
-				_ftfont.Render(boost::lexical_cast<std::string>(score).c_str());
-				glPopMatrix();
-			}
 		}
 	}
 }
 
-void
-SkeletonView::drawSphere(const util::point<float,3>& center, float diameter) {
-
-	glPushMatrix();
-	glTranslatef(center.x(), center.y(), center.z());
-	glScalef(diameter, diameter, diameter);
-
-	const std::vector<sg_gui::Triangle>& triangles = _sphere.getTriangles();
-
-	glBegin(GL_TRIANGLES);
-	for (const sg_gui::Triangle& triangle : triangles) {
-
-		const sg_gui::Point3d&  v0 = _sphere.getVertex(triangle.v0);
-		const sg_gui::Point3d&  v1 = _sphere.getVertex(triangle.v1);
-		const sg_gui::Point3d&  v2 = _sphere.getVertex(triangle.v2);
-		const sg_gui::Vector3d& n0 = _sphere.getNormal(triangle.v0);
-		const sg_gui::Vector3d& n1 = _sphere.getNormal(triangle.v1);
-		const sg_gui::Vector3d& n2 = _sphere.getNormal(triangle.v2);
-
-		glNormal3f(n0.x(), n0.y(), n0.z()); glVertex3f(v0.x(), v0.y(), v0.z());
-		glNormal3f(n1.x(), n1.y(), n1.z()); glVertex3f(v1.x(), v1.y(), v1.z());
-		glNormal3f(n2.x(), n2.y(), n2.z()); glVertex3f(v2.x(), v2.y(), v2.z());
-	}
-	glEnd();
-
-	glPopMatrix();
-}
-
 void
 SkeletonView::findClosestEdge(const util::ray<float,3>& ray) {
 
 	std::shared_ptr<Skeleton> closestSkeleton;
 	uint64_t closestSkeletonId;
-	Skeleton::Graph::Edge closestEdge;
+	int closestEdge = -1;
 
 	float minSkeletonDistance = std::numeric_limits<float>::max();
 
-	for (uint64_t id : _visibleSkeletons->getSkeletonIds()) {
-
-		const Skeleton& skeleton = *_visibleSkeletons->get(id);
-
-		float minDistance = std::numeric_limits<float>::max();
-		Skeleton::Graph::Edge bestEdge;
+	std::vector<float> distances;
+	std::vector<float> ts;
 
-		for (Skeleton::Graph::EdgeIt e(skeleton.graph()); e != lemon::INVALID; ++e) {
+	for (uint64_t id : _visibleSkeletons->getSkeletonIds()) {
 
-			Skeleton::Node su = skeleton.graph().u(e);
-			Skeleton::Node sv = skeleton.graph().v(e);
+		const FlatSkeleton& skeleton = getFlatSkeleton(_visibleSkeletons->get(id));
 
-			Skeleton::Position spu = skeleton.positions()[su];
-			Skeleton::Position spv = skeleton.positions()[sv];
+		skeleton.getSquaredRayDistances(ray, distances, ts);
 
-			util::point<float,3> sru;
-			util::point<float,3> srv;
-			skeleton.getRealLocation(spu, sru);
-			skeleton.getRealLocation(spv, srv);
+		float minDistance = std::numeric_limits<float>::max();
+		int bestEdge = -1;
 
-			util::ray<float,3> edgeRay(sru, srv - sru);
+		for (size_t e = 0; e < skeleton.numEdges(); e++) {
 
-			float s, t;
-			float dist = distance(ray, edgeRay, s, t);
-			std::cout << t << std::endl;
-			if (t >= 0 && t <= 1 && dist < minDistance) {
+			if (ts[e] >= 0 && ts[e] <= 1 && distances[e] < minDistance) {
 
-				minDistance = dist;
-				bestEdge = e;
+				minDistance = distances[e];
+				bestEdge = skeleton.edgeIds()[e];
 			}
 		}
 
@@ -391,5 +726,20 @@ SkeletonView::findClosestEdge(const util::ray<float,3>& ray) {
 	_showFocus = (minSkeletonDistance < std::numeric_limits<float>::max());
 
 	if (_showFocus)
-		LOG_USER(logger::out) << "[SkeletonView] showing edge " << closestSkeleton->graph().id(_focusEdge) << " of skeleton " << closestSkeletonId << std::endl;
+		LOG_USER(logger::out)
+				<< "[SkeletonView] showing edge " << _focusEdge << " of skeleton " << closestSkeletonId
+				<< " at distance " << std::sqrt(minSkeletonDistance) << std::endl;
+}
+
+const FlatSkeleton&
+SkeletonView::getFlatSkeleton(std::shared_ptr<Skeleton> skeleton) {
+
+	auto i = _flatSkeletons.find(skeleton);
+	if (i != _flatSkeletons.end())
+		return *i->second;
+
+	auto flat = std::make_shared<FlatSkeleton>(*skeleton);
+	_flatSkeletons[skeleton] = flat;
+
+	return *flat;
 }
@@ -1,16 +1,26 @@
 #ifndef HOST_TUBES_GUI_SKELETON_VIEW_H__
 #define HOST_TUBES_GUI_SKELETON_VIEW_H__
 
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
 #include <FTGL/ftgl.h>
 #include <scopegraph/Agent.h>
 #include <imageprocessing/Skeletons.h>
 #include <imageprocessing/SkeletonEdgeMatchScores.h>
+#include <analysis/FlatSkeleton.h>
+#include <analysis/SimplifiedSkeleton.h>
+#include <analysis/Skeletonizer.h>
+#include <io/ThreadPool.h>
 #include <sg_gui/GuiSignals.h>
 #include <sg_gui/MouseSignals.h>
 #include <sg_gui/KeySignals.h>
 #include <sg_gui/SegmentSignals.h>
-#include <sg_gui/RecordableView.h>
+#include <sg_gui/OpenGl.h>
 #include <sg_gui/Sphere.h>
+#include "PollThrottle.h"
+#include "SegmentSignals.h"
 
 class SetSkeletons : public sg_gui::SetContent {
 
@@ -39,25 +49,36 @@ class SkeletonView :
 						sg_gui::KeyDown,
 						SetSkeletons,
 						sg_gui::ShowSegment,
-						sg_gui::HideSegment
+						sg_gui::HideSegment,
+						ShowSegments,
+						HideSegments
 				>,
 				sg::Provides<
 						sg_gui::ContentChanged
 				>
-		>,
-		public sg_gui::RecordableView {
+		> {
 
 public:
 
 	SkeletonView();
 
+	~SkeletonView();
+
 	void setSkeletons(std::shared_ptr<Skeletons> skeletons);
 
+	/**
+	 * Set a skeletonizer to create the skeletons of segments that are shown
+	 * but do not have one yet. They are created in the background and shown
+	 * when done.
+	 */
+	void setSkeletonizer(std::shared_ptr<Skeletonizer> skeletonizer) { _skeletonizer = skeletonizer; }
+
 	void setEdgeMatchScores(std::vector<std::shared_ptr<SkeletonEdgeMatchScores>> scores) {
 
 		_edgeMatchScores = scores;
 		_currentScoreIndex = 0;
-		updateRecording();
+		_scoresChanged = true;
+		_labelsChanged = true;
 		send<sg_gui::ContentChanged>();
 	}
 
@@ -77,21 +98,75 @@ public:
 
 	void onSignal(sg_gui::HideSegment& signal);
 
+	void onSignal(ShowSegments& signal);
+
+	void onSignal(HideSegments& signal);
+
 private:
 
-	void updateRecording();
+	/**
+	 * Display lists of a single skeleton. They contain only geometry, such
+	 * that color, visibility, and sphere scale can be changed while drawing.
+	 * The edges are recorded for each level of detail that was drawn so far.
+	 */
+	struct SkeletonLists {
+
+		std::shared_ptr<SimplifiedSkeleton> simplified;
+		std::vector<GLuint>                 edges;
+		GLuint                              spheres;
+	};
+
+	// add the skeleton of a segment to the visible ones, returns false if
+	// there is none
+	bool showSkeleton(uint64_t id);
+
+	// create the skeletons of the given segments that don't have one in the
+	// background, if a skeletonizer is set
+	void skeletonize(const std::set<uint64_t>& ids);
+
+	// add the skeletons created in the background, and show the ones that
+	// were shown while being created, returns false if there were none
+	bool addSkeletonized();
+
+	// get the display lists of a skeleton, create its levels of detail if
+	// needed
+	SkeletonLists& getSkeletonLists(uint64_t id);
+
+	// get the edge list of a skeleton for the given level, record it if needed
+	GLuint getEdgeList(SkeletonLists& lists, unsigned int level);
+
+	// get the sphere list of a skeleton, record it if needed
+	GLuint getSphereList(SkeletonLists& lists, uint64_t id);
+
+	// record the sphere lists, if needed
+	void updateSphereLists();
+
+	// record the score and label lists, if needed
+	void updateScoreLists();
+
+	// delete the lists of the skeletons, and the sphere and score lists if
+	// all is set
+	void deleteLists(bool all);
 
-	void drawSkeleton(const Skeleton& skeleton);
+	void drawSegments(const std::vector<util::point<float,3>>& segments);
 
-	void drawEdgeMatchScores(const SkeletonEdgeMatchScores& scores);
+	void drawSkeletonSpheres(const FlatSkeleton& skeleton);
 
-	void drawSphere(const util::point<float,3>& center, float diameter);
+	void drawEdgeMatchScores(const SkeletonEdgeMatchScores& scores, bool labels);
 
 	void findClosestEdge(const util::ray<float,3>& ray);
 
+	// get the flat copy of a skeleton, create it if needed
+	const FlatSkeleton& getFlatSkeleton(std::shared_ptr<Skeleton> skeleton);
+
 	std::shared_ptr<Skeletons> _skeletons;
 	std::shared_ptr<Skeletons> _visibleSkeletons;
 
+	std::shared_ptr<Skeletonizer> _skeletonizer;
+
+	// flat copies of the skeletons shown or compared so far
+	std::map<std::shared_ptr<Skeleton>, std::shared_ptr<FlatSkeleton>> _flatSkeletons;
+
 	std::vector<std::shared_ptr<SkeletonEdgeMatchScores>> _edgeMatchScores;
 
 	int  _currentScoreIndex;
@@ -99,7 +174,7 @@ private:
 
 	bool                      _showFocus;
 	std::shared_ptr<Skeleton> _focusSkeleton;
-	Skeleton::Graph::Edge     _focusEdge;
+	int                       _focusEdge;
 
 	bool _showNumbers;
 	bool _showZeroLines;
@@ -108,7 +183,47 @@ private:
 	bool           _showSpheres;
 	float          _sphereScale;
 
+	// the allowed error of simplified skeletons in screen pixels
+	float _lodTolerance;
+
+	std::map<uint64_t, SkeletonLists> _skeletonLists;
+
+	// a sphere of diameter 1, and the same scaled by the current sphere scale,
+	// which is called by the sphere lists of the skeletons
+	GLuint _unitSphereList;
+	GLuint _scaledSphereList;
+	float  _recordedSphereScale;
+
+	// lines between matching edges and their scores, recorded separately
+	// since rendering the scores as text is expensive
+	GLuint _scoresList;
+	GLuint _labelsList;
+	bool   _scoresChanged;
+	bool   _labelsChanged;
+
 	FTTextureFont _ftfont;
+
+	// segments being skeletonized, skeletons created but not added yet, and
+	// segments without a skeleton (such that they are not skeletonized
+	// again)
+	std::set<uint64_t>                            _skeletonizing;
+	std::map<uint64_t, std::shared_ptr<Skeleton>> _skeletonized;
+	std::set<uint64_t>                            _noSkeleton;
+
+	// set when skeletons were created, such that drawing does not have to
+	// lock to find out
+	std::atomic<bool> _haveSkeletonized;
+
+	// segments to show as soon as their skeleton was created, only used on
+	// the GUI thread
+	std::set<uint64_t> _waiting;
+
+	PollThrottle _poll;
+
+	std::mutex _mutex;
+
+	// last member, such that pending tasks finish before the rest is destructed
+	ThreadPool _pool;
 };
 
 #endif // HOST_TUBES_GUI_SKELETON_VIEW_H__
@@ -0,0 +1,61 @@
+#include <util/Logger.h>
+#include "SlabScope.h"
+
+logger::LogChannel slabscopelog("slabscopelog", "[SlabScope] ");
+
+SlabScope::SlabScope(unsigned int numSections) :
+	_numSections(numSections),
+	_enabled(false),
+	_haveSection(false),
+	_begin(0),
+	_end(0) {}
+
+void
+SlabScope::onSignal(SectionChanged& signal) {
+
+	// the section spans [z, z + thickness)
+	_begin = signal.getZ() - _numSections*signal.getThickness();
+	_end   = signal.getZ() + (_numSections + 1)*signal.getThickness();
+
+	_haveSection = true;
+
+	// the redraw is requested by the sender of the signal
+}
+
+bool
+SlabScope::filterDown(sg_gui::KeyDown& signal) {
+
+	if (signal.key == sg_gui::keys::T) {
+
+		_enabled = !_enabled;
+
+		LOG_USER(slabscopelog)
+				<< (_enabled ? "showing only geometry near the current section" : "showing all geometry")
+				<< std::endl;
+
+		send<sg_gui::ContentChanged>();
+	}
+
+	return true;
+}
+
+void
+SlabScope::enableClipPlanes() {
+
+	// the planes are transformed by the current modelview matrix, i.e., they 
+	// are given in world units here
+	GLdouble below[] = {0, 0,  1, -_begin};
+	GLdouble above[] = {0, 0, -1,  _end};
+
+	glClipPlane(GL_CLIP_PLANE0, below);
+	glClipPlane(GL_CLIP_PLANE1, above);
+	glEnable(GL_CLIP_PLANE0);
+	glEnable(GL_CLIP_PLANE1);
+}
+
+void
+SlabScope::disableClipPlanes() {
+
+	glDisable(GL_CLIP_PLANE0);
+	glDisable(GL_CLIP_PLANE1);
+}
@@ -0,0 +1,109 @@
+#ifndef TOOLS_GUI_SLAB_SCOPE_H__
+#define TOOLS_GUI_SLAB_SCOPE_H__
+
+#include <scopegraph/Scope.h>
+#include <sg_gui/GuiSignals.h>
+#include <sg_gui/KeySignals.h>
+#include <sg_gui/OpenGl.h>
+#include "SectionSignals.h"
+
+/**
+ * Scope for geometry that can be restricted to a slab around the current 
+ * section. If enabled (toggled with 't'), the z range of the region of 
+ * interest of the draw signals is set to the slab, such that views inside can 
+ * skip everything outside, and the remaining geometry is clipped to the slab.
+ */
+class SlabScope :
+		public sg::Scope<
+				SlabScope,
+				sg::Accepts<
+						SectionChanged
+				>,
+				sg::FiltersDown<
+						sg_gui::DrawOpaque,
+						sg_gui::Draw,
+						sg_gui::DrawTranslucent,
+						sg_gui::KeyDown
+				>,
+				sg::Provides<
+						sg_gui::ContentChanged
+				>,
+				sg::PassesUp<
+						sg_gui::ContentChanged
+				>
+		> {
+
+public:
+
+	/**
+	 * @param numSections
+	 *              The number of sections to show on each side of the current 
+	 *              one.
+	 */
+	SlabScope(unsigned int numSections = 10);
+
+	void onSignal(SectionChanged& signal);
+
+	bool filterDown(sg_gui::DrawOpaque& signal) { return restrictToSlab(signal); }
+	void unfilterDown(sg_gui::DrawOpaque& signal) { unrestrictFromSlab(signal); }
+
+	bool filterDown(sg_gui::Draw& signal) { return restrictToSlab(signal); }
+	void unfilterDown(sg_gui::Draw& signal) { unrestrictFromSlab(signal); }
+
+	bool filterDown(sg_gui::DrawTranslucent& signal) { return restrictToSlab(signal); }
+	void unfilterDown(sg_gui::DrawTranslucent& signal) { unrestrictFromSlab(signal); }
+
+	bool filterDown(sg_gui::KeyDown& signal);
+	void unfilterDown(sg_gui::KeyDown&) {}
+
+private:
+
+	template <typename DrawSignal>
+	bool restrictToSlab(DrawSignal& signal) {
+
+		if (!active())
+			return true;
+
+		_roi = signal.roi();
+
+		signal.roi() = util::box<float,3>(
+				util::point<float,3>(_roi.min().x(), _roi.min().y(), _begin),
+				util::point<float,3>(_roi.max().x(), _roi.max().y(), _end));
+
+		enableClipPlanes();
+
+		return true;
+	}
+
+	template <typename DrawSignal>
+	void unrestrictFromSlab(DrawSignal& signal) {
+
+		if (!active())
+			return;
+
+		disableClipPlanes();
+
+		signal.roi() = _roi;
+	}
+
+	bool active() const { return _enabled && _haveSection; }
+
+	void enableClipPlanes();
+
+	void disableClipPlanes();
+
+	unsigned int _numSections;
+
+	bool _enabled;
+	bool _haveSection;
+
+	// the slab in world units
+	float _begin;
+	float _end;
+
+	// the region of interest of the draw signal passing through
+	util::box<float,3> _roi;
+};
+
+#endif // TOOLS_GUI_SLAB_SCOPE_H__
+
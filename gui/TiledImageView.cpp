@@ -0,0 +1,329 @@
+#include <algorithm>
+#include <cmath>
+#include <util/Logger.h>
+#include "TiledImageView.h"
+
+logger::LogChannel tiledimageviewlog("tiledimageviewlog", "[TiledImageView] ");
+
+TiledImageView::TiledImageView(unsigned int maxTextures, unsigned int numThreads) :
+	_maxTextures(maxTextures),
+	_frame(0),
+	_pool(numThreads) {}
+
+TiledImageView::~TiledImageView() {
+
+	deleteTextures(true);
+}
+
+void
+TiledImageView::setImage(std::shared_ptr<TiledImage> image) {
+
+	deleteTextures(true);
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		_image = image;
+		_pending.clear();
+		_loaded.clear();
+		_visible.clear();
+		_failed.clear();
+	}
+
+	if (_image)
+		LOG_DEBUG(tiledimageviewlog)
+				<< "showing " << _image->getIdentifier() << " of size "
+				<< _image->width() << "x" << _image->height() << " with "
+				<< _image->getNumLevels() << " levels" << std::endl;
+
+	send<sg_gui::ContentChanged>();
+}
+
+void
+TiledImageView::onSignal(sg_gui::DrawOpaque& signal) {
+
+	if (!_image)
+		return;
+
+	_frame++;
+
+	uploadLoaded();
+
+	unsigned int level    = getLevel(signal.resolution().x());
+	unsigned int tileSize = _image->getTileSize();
+	float        scale    = tileSize*std::pow(2.0f, (float)level);
+
+	// the visible tiles at the current level
+	int beginX = std::max(0, (int)std::floor(signal.roi().min().x()/scale));
+	int beginY = std::max(0, (int)std::floor(signal.roi().min().y()/scale));
+	int endX   = std::min((int)_image->numTilesX(level), (int)std::ceil(signal.roi().max().x()/scale));
+	int endY   = std::min((int)_image->numTilesY(level), (int)std::ceil(signal.roi().max().y()/scale));
+
+	std::set<TileId> visible;
+
+	// the coarsest level is always needed as a fallback
+	unsigned int top = _image->getNumLevels() - 1;
+	visible.insert(TileId(top, 0, 0));
+
+	for (int y = beginY; y < endY; y++)
+		for (int x = beginX; x < endX; x++)
+			visible.insert(TileId(level, x, y));
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_visible = visible;
+	}
+
+	glEnable(GL_TEXTURE_2D);
+	glColor4f(1.0, 1.0, 1.0, 1.0);
+
+	for (int y = beginY; y < endY; y++)
+		for (int x = beginX; x < endX; x++) {
+
+			TileId id(level, x, y);
+
+			if (!_textures.count(id))
+				request(id);
+
+			// find the finest available tile covering this one
+			for (unsigned int l = level; l <= top; l++) {
+
+				TileId source(l, x >> (l - level), y >> (l - level));
+
+				if (_textures.count(source)) {
+
+					drawTile(id, source);
+					break;
+				}
+			}
+		}
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glDisable(GL_TEXTURE_2D);
+
+	if (!_textures.count(TileId(top, 0, 0)))
+		request(TileId(top, 0, 0));
+
+	deleteTextures(false);
+
+	bool waiting;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		waiting = !_pending.empty() || !_loaded.empty();
+	}
+
+	// ask for another frame to show the tiles still being decoded
+	if (waiting)
+		send<sg_gui::ContentChanged>();
+}
+
+void
+TiledImageView::onSignal(sg_gui::QuerySize& signal) {
+
+	if (!_image)
+		return;
+
+	signal.setSize(
+			util::box<float,3>(
+					util::point<float,3>(0, 0, 0),
+					util::point<float,3>(_image->width(), _image->height(), 0)));
+}
+
+unsigned int
+TiledImageView::getLevel(float resolution) {
+
+	if (resolution <= 0)
+		return 0;
+
+	// the resolution is in screen pixels per image pixel, use the finest level
+	// that has at least one image pixel per screen pixel
+	int level = std::floor(std::log2(1.0/resolution));
+
+	return std::max(0, std::min((int)_image->getNumLevels() - 1, level));
+}
+
+void
+TiledImageView::request(const TileId& id) {
+
+	std::shared_ptr<TiledImage> image;
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		if (_pending.count(id) || _loaded.count(id) || _failed.count(id))
+			return;
+
+		_pending.insert(id);
+		image = _image;
+	}
+
+	_pool.schedule([this, id, image]() {
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+
+			// the view moved on or the image changed since the request
+			if (image != _image || !_visible.count(id)) {
+
+				_pending.erase(id);
+				return;
+			}
+		}
+
+		std::shared_ptr<TiledImage::Tile> tile;
+
+		try {
+
+			tile = image->getTile(std::get<0>(id), std::get<1>(id), std::get<2>(id));
+
+		} catch (std::exception& e) {
+
+			LOG_ERROR(tiledimageviewlog) << "can not read tile: " << e.what() << std::endl;
+		}
+
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		if (image != _image)
+			return;
+
+		_pending.erase(id);
+
+		if (tile)
+			_loaded[id] = tile;
+		else
+			_failed.insert(id);
+	});
+}
+
+void
+TiledImageView::uploadLoaded() {
+
+	// limit the number of uploads per frame to keep drawing responsive
+	const unsigned int maxUploads = 16;
+
+	std::map<TileId, std::shared_ptr<TiledImage::Tile>> loaded;
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		while (!_loaded.empty() && loaded.size() < maxUploads) {
+
+			loaded.insert(*_loaded.begin());
+			_loaded.erase(_loaded.begin());
+		}
+	}
+
+	for (auto& i : loaded) {
+
+		const TiledImage::Tile& tile = *i.second;
+
+		Texture texture;
+		texture.lastUsed = _frame;
+
+		glGenTextures(1, &texture.texture);
+		glBindTexture(GL_TEXTURE_2D, texture.texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexImage2D(
+				GL_TEXTURE_2D,
+				0,
+				GL_LUMINANCE32F_ARB,
+				tile.width(),
+				tile.height(),
+				0,
+				GL_LUMINANCE,
+				GL_FLOAT,
+				tile.data());
+
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		_textures[i.first] = texture;
+	}
+}
+
+void
+TiledImageView::drawTile(const TileId& target, const TileId& source) {
+
+	Texture& texture = _textures[source];
+	texture.lastUsed = _frame;
+
+	unsigned int tileSize = _image->getTileSize();
+
+	// extents of the tiles in pixels of their level
+	unsigned int targetLevel = std::get<0>(target);
+	unsigned int sourceLevel = std::get<0>(source);
+
+	float targetMinX = std::get<1>(target)*tileSize;
+	float targetMinY = std::get<2>(target)*tileSize;
+	float targetMaxX = std::min(targetMinX + tileSize, (float)_image->width(targetLevel));
+	float targetMaxY = std::min(targetMinY + tileSize, (float)_image->height(targetLevel));
+
+	float sourceMinX  = std::get<1>(source)*tileSize;
+	float sourceMinY  = std::get<2>(source)*tileSize;
+	float sourceWidth  = std::min(sourceMinX + tileSize, (float)_image->width(sourceLevel))  - sourceMinX;
+	float sourceHeight = std::min(sourceMinY + tileSize, (float)_image->height(sourceLevel)) - sourceMinY;
+
+	// the target tile in texture coordinates of the source
+	float levelScale = 1.0/(1 << (sourceLevel - targetLevel));
+	float minS = (targetMinX*levelScale - sourceMinX)/sourceWidth;
+	float minT = (targetMinY*levelScale - sourceMinY)/sourceHeight;
+	float maxS = (targetMaxX*levelScale - sourceMinX)/sourceWidth;
+	float maxT = (targetMaxY*levelScale - sourceMinY)/sourceHeight;
+
+	// the target tile in world units, i.e., pixels of the full resolution
+	float worldScale = (1 << targetLevel);
+	float minX = std::min(targetMinX*worldScale, (float)_image->width());
+	float minY = std::min(targetMinY*worldScale, (float)_image->height());
+	float maxX = std::min(targetMaxX*worldScale, (float)_image->width());
+	float maxY = std::min(targetMaxY*worldScale, (float)_image->height());
+
+	glBindTexture(GL_TEXTURE_2D, texture.texture);
+
+	glBegin(GL_QUADS);
+	glTexCoord2f(minS, minT); glVertex2f(minX, minY);
+	glTexCoord2f(maxS, minT); glVertex2f(maxX, minY);
+	glTexCoord2f(maxS, maxT); glVertex2f(maxX, maxY);
+	glTexCoord2f(minS, maxT); glVertex2f(minX, maxY);
+	glEnd();
+}
+
+void
+TiledImageView::deleteTextures(bool all) {
+
+	if (_textures.empty())
+		return;
+
+	if (!all && _textures.size() <= _maxTextures)
+		return;
+
+	sg_gui::OpenGl::Guard guard;
+
+	if (all) {
+
+		for (auto& i : _textures)
+			glDeleteTextures(1, &i.second.texture);
+		_textures.clear();
+
+		return;
+	}
+
+	// delete the least recently used textures, but none used in this frame
+	std::vector<std::pair<unsigned int, TileId>> byAge;
+	for (auto& i : _textures)
+		if (i.second.lastUsed != _frame)
+			byAge.push_back(std::make_pair(i.second.lastUsed, i.first));
+
+	std::sort(byAge.begin(), byAge.end());
+
+	size_t numDelete = std::min(byAge.size(), _textures.size() - _maxTextures);
+
+	for (size_t i = 0; i < numDelete; i++) {
+
+		glDeleteTextures(1, &_textures[byAge[i].second].texture);
+		_textures.erase(byAge[i].second);
+	}
+}
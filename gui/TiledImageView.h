@@ -0,0 +1,104 @@
+#ifndef TOOLS_GUI_TILED_IMAGE_VIEW_H__
+#define TOOLS_GUI_TILED_IMAGE_VIEW_H__
+
+#include <map>
+#include <mutex>
+#include <set>
+#include <tuple>
+#include <scopegraph/Agent.h>
+#include <sg_gui/GuiSignals.h>
+#include <sg_gui/OpenGl.h>
+#include <io/TiledImage.h>
+#include <io/ThreadPool.h>
+
+/**
+ * Shows a large 2D image by drawing only the tiles that intersect the visible
+ * region, at the pyramid level matching the current zoom. Missing tiles are
+ * decoded in the background and replaced by the best coarser tile available
+ * until then.
+ */
+class TiledImageView :
+		public sg::Agent<
+				TiledImageView,
+				sg::Accepts<
+						sg_gui::DrawOpaque,
+						sg_gui::QuerySize
+				>,
+				sg::Provides<
+						sg_gui::ContentChanged
+				>
+		> {
+
+public:
+
+	/**
+	 * @param maxTextures
+	 *              The number of tiles to keep on the GPU.
+	 * @param numThreads
+	 *              The number of threads to decode tiles with, 0 for one per
+	 *              core.
+	 */
+	TiledImageView(unsigned int maxTextures = 512, unsigned int numThreads = 0);
+
+	~TiledImageView();
+
+	/**
+	 * Set the image to show. Pass an empty pointer to show nothing.
+	 */
+	void setImage(std::shared_ptr<TiledImage> image);
+
+	void onSignal(sg_gui::DrawOpaque& signal);
+
+	void onSignal(sg_gui::QuerySize& signal);
+
+private:
+
+	// level, x, and y of a tile
+	typedef std::tuple<unsigned int, unsigned int, unsigned int> TileId;
+
+	struct Texture {
+
+		GLuint       texture;
+		unsigned int lastUsed;
+	};
+
+	// the pyramid level to draw at the given resolution
+	unsigned int getLevel(float resolution);
+
+	// schedule loading of a tile, if not done already
+	void request(const TileId& id);
+
+	void uploadLoaded();
+
+	// draw the area of tile target with the texture of tile source, which is
+	// either the same or a coarser tile covering target
+	void drawTile(const TileId& target, const TileId& source);
+
+	void deleteTextures(bool all);
+
+	std::shared_ptr<TiledImage> _image;
+
+	unsigned int _maxTextures;
+
+	// the number of the current frame, to find least recently used textures
+	unsigned int _frame;
+
+	std::map<TileId, Texture> _textures;
+
+	// tiles waiting to be decoded, decoded ones waiting to be uploaded,
+	// tiles needed for the last frame (such that outdated requests are
+	// skipped), and tiles that could not be read (such that they are not
+	// requested again)
+	std::set<TileId> _pending;
+	std::set<TileId> _visible;
+	std::set<TileId> _failed;
+	std::map<TileId, std::shared_ptr<TiledImage::Tile>> _loaded;
+
+	std::mutex _mutex;
+
+	// last member, such that pending tasks finish before the rest is destructed
+	ThreadPool _pool;
+};
+
+#endif // TOOLS_GUI_TILED_IMAGE_VIEW_H__
+
@@ -0,0 +1,78 @@
+#ifndef TOOLS_GUI_VIEW_SIGNALS_H__
+#define TOOLS_GUI_VIEW_SIGNALS_H__
+
+#include <sg_gui/GuiSignals.h>
+#include <util/point.hpp>
+
+/**
+ * Set the magnification of the view, relative to the content fitting the
+ * window.
+ */
+class SetZoom : public sg_gui::GuiSignal {
+
+public:
+
+	typedef sg_gui::GuiSignal parent_type;
+
+	SetZoom(float zoom) :
+		_zoom(zoom) {}
+
+	float getZoom() const { return _zoom; }
+
+private:
+
+	float _zoom;
+};
+
+/**
+ * Set the rotation of the view around the x, y, and z axis (applied in this
+ * order), in degrees.
+ */
+class SetRotation : public sg_gui::GuiSignal {
+
+public:
+
+	typedef sg_gui::GuiSignal parent_type;
+
+	SetRotation(const util::point<float,3>& angles) :
+		_angles(angles) {}
+
+	const util::point<float,3>& getAngles() const { return _angles; }
+
+private:
+
+	util::point<float,3> _angles;
+};
+
+/**
+ * Move the view such that the given location (in world units) is in the
+ * center.
+ */
+class SetCenter : public sg_gui::GuiSignal {
+
+public:
+
+	typedef sg_gui::GuiSignal parent_type;
+
+	SetCenter(const util::point<float,3>& center) :
+		_center(center) {}
+
+	const util::point<float,3>& getCenter() const { return _center; }
+
+private:
+
+	util::point<float,3> _center;
+};
+
+/**
+ * Undo all changes of zoom, rotation, and center.
+ */
+class ResetView : public sg_gui::GuiSignal {
+
+public:
+
+	typedef sg_gui::GuiSignal parent_type;
+};
+
+#endif // TOOLS_GUI_VIEW_SIGNALS_H__
+
@@ -0,0 +1,154 @@
+#include <zlib.h>
+#include <util/Logger.h>
+#include "Hdf5ChunkReader.h"
+
+logger::LogChannel hdf5chunkreaderlog("hdf5chunkreaderlog", "[Hdf5ChunkReader] ");
+
+Hdf5ChunkReader::Hdf5ChunkReader(hid_t dataset) :
+	_dataset(dataset),
+	_supported(false) {
+
+	hid_t space = H5Dget_space(_dataset);
+	int   rank  = H5Sget_simple_extent_ndims(space);
+
+	if (rank == 3)
+		H5Sget_simple_extent_dims(space, _shape, 0);
+
+	H5Sclose(space);
+
+	if (rank != 3)
+		return;
+
+	hid_t plist = H5Dget_create_plist(_dataset);
+
+	if (H5Pget_layout(plist) != H5D_CHUNKED) {
+
+		H5Pclose(plist);
+		return;
+	}
+
+	H5Pget_chunk(plist, 3, _chunkShape);
+
+	_supported = true;
+
+	int numFilters = H5Pget_nfilters(plist);
+	for (int i = 0; i < numFilters; i++) {
+
+		unsigned int flags;
+		size_t       numValues = 0;
+		unsigned int filterConfig;
+
+		H5Z_filter_t filter = H5Pget_filter2(plist, i, &flags, &numValues, 0, 0, 0, &filterConfig);
+
+		if (filter != H5Z_FILTER_DEFLATE &&
+		    filter != H5Z_FILTER_SHUFFLE &&
+		    filter != H5Z_FILTER_FLETCHER32) {
+
+			LOG_DEBUG(hdf5chunkreaderlog) << "filter " << filter << " not supported" << std::endl;
+			_supported = false;
+		}
+
+		_filters.push_back(filter);
+	}
+
+	H5Pclose(plist);
+}
+
+void
+Hdf5ChunkReader::decompress(std::vector<char>& chunk, unsigned int filterMask, size_t chunkBytes, size_t typeSize) const {
+
+	for (int i = _filters.size() - 1; i >= 0; i--) {
+
+		// filter was skipped for this chunk
+		if (filterMask & (1u << i))
+			continue;
+
+		switch (_filters[i]) {
+
+			case H5Z_FILTER_FLETCHER32:
+
+				// strip the checksum
+				chunk.resize(chunk.size() - 4);
+				break;
+
+			case H5Z_FILTER_DEFLATE: {
+
+				std::vector<char> inflated(chunkBytes);
+				uLongf size = chunkBytes;
+
+				int result = uncompress(
+						reinterpret_cast<Bytef*>(inflated.data()),
+						&size,
+						reinterpret_cast<const Bytef*>(chunk.data()),
+						chunk.size());
+
+				if (result != Z_OK)
+					UTIL_THROW_EXCEPTION(
+							IOError,
+							"failed to inflate chunk, zlib error " << result);
+
+				inflated.resize(size);
+				chunk.swap(inflated);
+				break;
+			}
+
+			case H5Z_FILTER_SHUFFLE: {
+
+				// shuffled chunks store the first bytes of all elements, then
+				// the second bytes, and so on
+				size_t numElements = chunk.size()/typeSize;
+				std::vector<char> unshuffled(chunk.size());
+
+				for (size_t b = 0; b < typeSize; b++)
+					for (size_t e = 0; e < numElements; e++)
+						unshuffled[e*typeSize + b] = chunk[b*numElements + e];
+
+				// trailing bytes are not shuffled
+				for (size_t j = numElements*typeSize; j < chunk.size(); j++)
+					unshuffled[j] = chunk[j];
+
+				chunk.swap(unshuffled);
+				break;
+			}
+		}
+	}
+
+	if (chunk.size() < chunkBytes)
+		UTIL_THROW_EXCEPTION(
+				IOError,
+				"decompressed chunk has " << chunk.size() << " bytes, expected " << chunkBytes);
+}
+
+void
+Hdf5ChunkReader::readHyperslab(
+		void* target,
+		hid_t memType,
+		const hsize_t* targetShape,
+		const hsize_t* begin,
+		const hsize_t* end) const {
+
+	hsize_t count[3];
+	for (int d = 0; d < 3; d++)
+		count[d] = (end[d] > begin[d] ? end[d] - begin[d] : 0);
+
+	if (count[0] == 0 || count[1] == 0 || count[2] == 0)
+		return;
+
+	hsize_t zero[3] = { 0, 0, 0 };
+
+	hid_t fileSpace = H5Dget_space(_dataset);
+	hid_t memSpace  = H5Screate_simple(3, targetShape, 0);
+
+	H5Sselect_hyperslab(fileSpace, H5S_SELECT_SET, begin, 0, count, 0);
+	H5Sselect_hyperslab(memSpace, H5S_SELECT_SET, zero, 0, count, 0);
+
+	herr_t result = H5Dread(_dataset, memType, memSpace, fileSpace, H5P_DEFAULT, target);
+
+	H5Sclose(memSpace);
+	H5Sclose(fileSpace);
+
+	if (result < 0)
+		UTIL_THROW_EXCEPTION(
+				IOError,
+				"failed to read block at " << begin[2] << ", " << begin[1] << ", " << begin[0]);
+}
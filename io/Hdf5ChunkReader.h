@@ -0,0 +1,231 @@
+#ifndef TOOLS_IO_HDF5_CHUNK_READER_H__
+#define TOOLS_IO_HDF5_CHUNK_READER_H__
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <hdf5.h>
+#include <vigra/multi_array.hxx>
+#include <util/exceptions.h>
+#include "ThreadPool.h"
+
+/**
+ * The HDF5 memory types matching the value types of volumes.
+ */
+template <typename T> hid_t hdf5NativeType();
+template <> inline hid_t hdf5NativeType<uint8_t>()  { return H5T_NATIVE_UINT8; }
+template <> inline hid_t hdf5NativeType<uint16_t>() { return H5T_NATIVE_UINT16; }
+template <> inline hid_t hdf5NativeType<uint32_t>() { return H5T_NATIVE_UINT32; }
+template <> inline hid_t hdf5NativeType<uint64_t>() { return H5T_NATIVE_UINT64; }
+template <> inline hid_t hdf5NativeType<int8_t>()   { return H5T_NATIVE_INT8; }
+template <> inline hid_t hdf5NativeType<int16_t>()  { return H5T_NATIVE_INT16; }
+template <> inline hid_t hdf5NativeType<int32_t>()  { return H5T_NATIVE_INT32; }
+template <> inline hid_t hdf5NativeType<int64_t>()  { return H5T_NATIVE_INT64; }
+template <> inline hid_t hdf5NativeType<float>()    { return H5T_NATIVE_FLOAT; }
+template <> inline hid_t hdf5NativeType<double>()   { return H5T_NATIVE_DOUBLE; }
+
+/**
+ * Reads chunked 3D datasets by reading the compressed chunks directly from
+ * the file and decompressing them in parallel on a thread pool. Only the
+ * reading of the compressed chunks goes through the HDF5 library, such that
+ * it does not need to be thread safe.
+ *
+ * Supports the deflate (gzip), shuffle, and fletcher32 filters. Datasets with
+ * other filters (like LZF or blosc) are reported as not supported.
+ *
+ * Reading chunks directly needs HDF5 1.10.2 or later. With older versions,
+ * blocks are read with a single hyperslab H5Dread instead.
+ */
+class Hdf5ChunkReader {
+
+public:
+
+	/**
+	 * Create a reader for the given dataset. The handle has to stay valid for
+	 * the lifetime of the reader.
+	 */
+	Hdf5ChunkReader(hid_t dataset);
+
+	/**
+	 * True, if the dataset is chunked, three-dimensional, and all of its
+	 * filters can be undone by this reader.
+	 */
+	bool isSupported() const { return _supported; }
+
+	/**
+	 * Read the whole dataset into the given array, which will be resized.
+	 * Returns false if the type of the dataset is not T, in which case
+	 * nothing is read.
+	 */
+	template <typename T>
+	bool read(vigra::MultiArray<3, T>& data, ThreadPool& pool) {
+
+		return readBlock(
+				data,
+				pool,
+				vigra::Shape3(0, 0, 0),
+				vigra::Shape3(_shape[2], _shape[1], _shape[0]));
+	}
+
+	/**
+	 * Read a block of the dataset into the given array, which will be resized
+	 * to the shape of the block. Offset and shape are given in vigra order
+	 * (x,y,z), like for vigra::HDF5File::readBlock(). Only the chunks
+	 * intersecting the block are read.
+	 */
+	template <typename T>
+	bool readBlock(
+			vigra::MultiArray<3, T>& data,
+			ThreadPool& pool,
+			const vigra::Shape3& blockOffset,
+			const vigra::Shape3& blockShape);
+
+private:
+
+	/**
+	 * Undo the filters of the dataset on a raw chunk, in reverse order.
+	 * Filters whose bit is set in filterMask were not applied to this chunk.
+	 */
+	void decompress(std::vector<char>& chunk, unsigned int filterMask, size_t chunkBytes, size_t typeSize) const;
+
+	/**
+	 * Read the part [begin,end) of the dataset with H5Dread into an array of
+	 * the given shape. Everything in file order (z,y,x).
+	 */
+	void readHyperslab(
+			void* target,
+			hid_t memType,
+			const hsize_t* targetShape,
+			const hsize_t* begin,
+			const hsize_t* end) const;
+
+	hid_t _dataset;
+	bool  _supported;
+
+	// shape of the dataset and the chunks, in file order (z,y,x)
+	hsize_t _shape[3];
+	hsize_t _chunkShape[3];
+
+	std::vector<H5Z_filter_t> _filters;
+};
+
+template <typename T>
+bool
+Hdf5ChunkReader::readBlock(
+		vigra::MultiArray<3, T>& data,
+		ThreadPool& pool,
+		const vigra::Shape3& blockOffset,
+		const vigra::Shape3& blockShape) {
+
+	if (!_supported)
+		return false;
+
+	hid_t fileType = H5Dget_type(_dataset);
+	bool sameType = (H5Tequal(fileType, hdf5NativeType<T>()) > 0);
+	H5Tclose(fileType);
+
+	if (!sameType)
+		return false;
+
+	// parts of the block without allocated chunks get the fill value of the
+	// dataset
+	T fill = T();
+	hid_t plist = H5Dget_create_plist(_dataset);
+	H5D_fill_value_t fillDefined;
+	if (H5Pfill_value_defined(plist, &fillDefined) >= 0 && fillDefined != H5D_FILL_VALUE_UNDEFINED)
+		H5Pget_fill_value(plist, hdf5NativeType<T>(), &fill);
+	H5Pclose(plist);
+
+	data.reshape(blockShape, fill);
+
+	// from here on, everything is in file order (z,y,x)
+	hsize_t begin[3] = { (hsize_t)blockOffset[2], (hsize_t)blockOffset[1], (hsize_t)blockOffset[0] };
+	hsize_t end[3]   = {
+			std::min(_shape[0], begin[0] + blockShape[2]),
+			std::min(_shape[1], begin[1] + blockShape[1]),
+			std::min(_shape[2], begin[2] + blockShape[0]) };
+
+	T*     target     = data.data();
+
+#if !H5_VERSION_GE(1,10,2)
+
+	hsize_t targetShape[3] = { (hsize_t)blockShape[2], (hsize_t)blockShape[1], (hsize_t)blockShape[0] };
+	readHyperslab(target, hdf5NativeType<T>(), targetShape, begin, end);
+
+	return true;
+
+#else
+
+	size_t width      = blockShape[0];
+	size_t height     = blockShape[1];
+	size_t chunkBytes = _chunkShape[0]*_chunkShape[1]*_chunkShape[2]*sizeof(T);
+
+	// unallocated chunks are reported as errors, they keep the fill value
+	H5E_auto2_t errorHandler;
+	void*       errorData;
+	H5Eget_auto2(H5E_DEFAULT, &errorHandler, &errorData);
+	H5Eset_auto2(H5E_DEFAULT, 0, 0);
+
+	// the first chunk intersecting the block
+	hsize_t first[3];
+	for (int d = 0; d < 3; d++)
+		first[d] = (begin[d]/_chunkShape[d])*_chunkShape[d];
+
+	hsize_t offset[3];
+	for (offset[0] = first[0]; offset[0] < end[0]; offset[0] += _chunkShape[0])
+	for (offset[1] = first[1]; offset[1] < end[1]; offset[1] += _chunkShape[1])
+	for (offset[2] = first[2]; offset[2] < end[2]; offset[2] += _chunkShape[2]) {
+
+		hsize_t storageSize = 0;
+		if (H5Dget_chunk_storage_size(_dataset, offset, &storageSize) < 0 || storageSize == 0)
+			continue;
+
+		auto chunk = std::make_shared<std::vector<char>>(storageSize);
+		uint32_t filterMask = 0;
+
+		if (H5Dread_chunk(_dataset, H5P_DEFAULT, offset, &filterMask, chunk->data()) < 0) {
+
+			H5Eset_auto2(H5E_DEFAULT, errorHandler, errorData);
+			UTIL_THROW_EXCEPTION(
+					IOError,
+					"failed to read chunk at " << offset[2] << ", " << offset[1] << ", " << offset[0]);
+		}
+
+		// the intersection of chunk and block, in dataset coordinates
+		hsize_t from[3], to[3];
+		for (int d = 0; d < 3; d++) {
+
+			from[d] = std::max(offset[d], begin[d]);
+			to[d]   = std::min(offset[d] + _chunkShape[d], end[d]);
+		}
+
+		hsize_t c0[3] = { offset[0], offset[1], offset[2] };
+
+		pool.schedule([=]() {
+
+			decompress(*chunk, filterMask, chunkBytes, sizeof(T));
+
+			const T* source = reinterpret_cast<const T*>(chunk->data());
+			size_t   cols   = to[2] - from[2];
+
+			for (hsize_t z = from[0]; z < to[0]; z++)
+				for (hsize_t y = from[1]; y < to[1]; y++)
+					std::memcpy(
+							target + ((z - begin[0])*height + y - begin[1])*width + from[2] - begin[2],
+							source + ((z - c0[0])*_chunkShape[1] + y - c0[1])*_chunkShape[2] + from[2] - c0[2],
+							cols*sizeof(T));
+		});
+	}
+
+	H5Eset_auto2(H5E_DEFAULT, errorHandler, errorData);
+
+	pool.wait();
+
+	return true;
+
+#endif
+}
+
+#endif // TOOLS_IO_HDF5_CHUNK_READER_H__
+
@@ -0,0 +1,82 @@
+#include <zlib.h>
+#include <util/Logger.h>
+#include "Hdf5ChunkWriter.h"
+
+logger::LogChannel hdf5chunkwriterlog("hdf5chunkwriterlog", "[Hdf5ChunkWriter] ");
+
+Hdf5ChunkWriter::Hdf5ChunkWriter(hid_t dataset) :
+	_dataset(dataset),
+	_supported(false),
+	_deflateLevel(-1) {
+
+	hid_t space = H5Dget_space(_dataset);
+	int   rank  = H5Sget_simple_extent_ndims(space);
+
+	if (rank == 3)
+		H5Sget_simple_extent_dims(space, _shape, 0);
+
+	H5Sclose(space);
+
+	if (rank != 3)
+		return;
+
+	hid_t plist = H5Dget_create_plist(_dataset);
+
+	if (H5Pget_layout(plist) != H5D_CHUNKED) {
+
+		H5Pclose(plist);
+		return;
+	}
+
+	H5Pget_chunk(plist, 3, _chunkShape);
+
+	_supported = true;
+
+	int numFilters = H5Pget_nfilters(plist);
+	for (int i = 0; i < numFilters; i++) {
+
+		unsigned int flags;
+		size_t       numValues = 1;
+		unsigned int values[1] = { 6 };
+		unsigned int filterConfig;
+
+		H5Z_filter_t filter = H5Pget_filter2(plist, i, &flags, &numValues, values, 0, 0, &filterConfig);
+
+		if (filter == H5Z_FILTER_DEFLATE && _deflateLevel < 0) {
+
+			_deflateLevel = values[0];
+
+		} else {
+
+			LOG_DEBUG(hdf5chunkwriterlog) << "filter " << filter << " not supported" << std::endl;
+			_supported = false;
+		}
+	}
+
+	H5Pclose(plist);
+}
+
+void
+Hdf5ChunkWriter::compress(std::vector<char>& chunk) const {
+
+	if (_deflateLevel < 0)
+		return;
+
+	uLongf size = compressBound(chunk.size());
+	std::vector<char> deflated(size);
+
+	int result = compress2(
+			reinterpret_cast<Bytef*>(deflated.data()),
+			&size,
+			reinterpret_cast<const Bytef*>(chunk.data()),
+			chunk.size(),
+			_deflateLevel);
+
+	if (result != Z_OK)
+		UTIL_THROW_EXCEPTION(
+				IOError,
+				"failed to deflate chunk, zlib error " << result);
+
+	deflated.resize(size);
+	chunk.swap(deflated);
+}
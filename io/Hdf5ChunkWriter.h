@@ -0,0 +1,150 @@
+#ifndef TOOLS_IO_HDF5_CHUNK_WRITER_H__
+#define TOOLS_IO_HDF5_CHUNK_WRITER_H__
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include <hdf5.h>
+#include <vigra/multi_array.hxx>
+#include <util/exceptions.h>
+#include "Hdf5ChunkReader.h"
+#include "ThreadPool.h"
+
+/**
+ * Writes chunked 3D datasets by compressing the chunks in parallel on a
+ * thread pool and writing them directly to the file. Only the writing of the
+ * compressed chunks goes through the HDF5 library, such that it does not need
+ * to be thread safe.
+ *
+ * Supports datasets without filters or with the deflate (gzip) filter only,
+ * which is what Hdf5VolumeWriter creates.
+ *
+ * Writing chunks directly needs HDF5 1.10.3 or later. With older versions,
+ * the dataset is written with a single H5Dwrite, and HDF5 compresses the
+ * chunks itself.
+ */
+class Hdf5ChunkWriter {
+
+public:
+
+	/**
+	 * Create a writer for the given dataset. The handle has to stay valid for
+	 * the lifetime of the writer.
+	 */
+	Hdf5ChunkWriter(hid_t dataset);
+
+	/**
+	 * True, if the dataset is chunked, three-dimensional, and all of its
+	 * filters can be applied by this writer.
+	 */
+	bool isSupported() const { return _supported; }
+
+	/**
+	 * Write the whole dataset. The shape of data has to match the shape of
+	 * the dataset, in vigra order (x,y,z).
+	 */
+	template <typename T>
+	void write(const vigra::MultiArray<3, T>& data, ThreadPool& pool);
+
+private:
+
+	/**
+	 * Apply the filters of the dataset to a chunk.
+	 */
+	void compress(std::vector<char>& chunk) const;
+
+	hid_t _dataset;
+	bool  _supported;
+
+	// shape of the dataset and the chunks, in file order (z,y,x)
+	hsize_t _shape[3];
+	hsize_t _chunkShape[3];
+
+	// deflate level, negative if not compressed
+	int _deflateLevel;
+};
+
+template <typename T>
+void
+Hdf5ChunkWriter::write(const vigra::MultiArray<3, T>& data, ThreadPool& pool) {
+
+	if (!_supported)
+		UTIL_THROW_EXCEPTION(
+				IOError,
+				"dataset can not be written chunk by chunk");
+
+	const T* source = data.data();
+
+#if !H5_VERSION_GE(1,10,3)
+
+	// the memory layout of vigra (x fastest) is the file layout (z,y,x)
+	if (H5Dwrite(_dataset, hdf5NativeType<T>(), H5S_ALL, H5S_ALL, H5P_DEFAULT, source) < 0)
+		UTIL_THROW_EXCEPTION(
+				IOError,
+				"failed to write dataset");
+
+#else
+
+	size_t   width  = data.shape(0);
+	size_t   height = data.shape(1);
+
+	// everything in file order (z,y,x) from here on
+	std::vector<std::vector<hsize_t>> offsets;
+
+	hsize_t offset[3];
+	for (offset[0] = 0; offset[0] < _shape[0]; offset[0] += _chunkShape[0])
+	for (offset[1] = 0; offset[1] < _shape[1]; offset[1] += _chunkShape[1])
+	for (offset[2] = 0; offset[2] < _shape[2]; offset[2] += _chunkShape[2])
+		offsets.push_back(std::vector<hsize_t>(offset, offset + 3));
+
+	// compress a batch of chunks in parallel, then write them in order, such
+	// that only a few compressed chunks are in memory at the same time
+	size_t batchSize = 4*pool.size();
+
+	for (size_t begin = 0; begin < offsets.size(); begin += batchSize) {
+
+		size_t end = std::min(offsets.size(), begin + batchSize);
+
+		std::vector<std::vector<char>> chunks(end - begin);
+
+		for (size_t i = begin; i < end; i++)
+			pool.schedule([this, &chunks, &offsets, source, width, height, begin, i]() {
+
+				const hsize_t* c0 = offsets[i].data();
+
+				// chunks at the border are written in full size, padded with zeros
+				std::vector<char>& chunk = chunks[i - begin];
+				chunk.resize(_chunkShape[0]*_chunkShape[1]*_chunkShape[2]*sizeof(T), 0);
+
+				T*     target = reinterpret_cast<T*>(chunk.data());
+				size_t cols   = std::min(_chunkShape[2], _shape[2] - c0[2]);
+
+				for (hsize_t z = c0[0]; z < std::min(c0[0] + _chunkShape[0], _shape[0]); z++)
+					for (hsize_t y = c0[1]; y < std::min(c0[1] + _chunkShape[1], _shape[1]); y++)
+						std::memcpy(
+								target + ((z - c0[0])*_chunkShape[1] + y - c0[1])*_chunkShape[2],
+								source + (z*height + y)*width + c0[2],
+								cols*sizeof(T));
+
+				compress(chunk);
+			});
+
+		// rethrows compression failures
+		pool.wait();
+
+		for (size_t i = begin; i < end; i++) {
+
+			const std::vector<char>& chunk = chunks[i - begin];
+
+			if (H5Dwrite_chunk(_dataset, H5P_DEFAULT, 0, offsets[i].data(), chunk.size(), chunk.data()) < 0)
+				UTIL_THROW_EXCEPTION(
+						IOError,
+						"failed to write chunk at " << offsets[i][2] << ", " << offsets[i][1] << ", " << offsets[i][0]);
+		}
+	}
+
+#endif
+}
+
+#endif // TOOLS_IO_HDF5_CHUNK_WRITER_H__
+
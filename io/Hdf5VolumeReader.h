@@ -4,6 +4,9 @@
 #include <string>
 #include <vigra/hdf5impex.hxx>
 #include <imageprocessing/ExplicitVolume.h>
+#include "volumes.h"
+#include "Hdf5ChunkReader.h"
+#include "ThreadPool.h"
 
 class Hdf5VolumeReader {
 
@@ -12,12 +15,66 @@ public:
 	Hdf5VolumeReader(vigra::HDF5File& hdfFile) :
 		_hdfFile(hdfFile) {}
 
+	/**
+	 * Get the voxel type to read the given dataset as without conversion.
+	 */
+	VoxelType getVoxelType(std::string dataset) {
+
+		return ::getVoxelType(_hdfFile.getDatasetType(dataset));
+	}
+
 	template <typename ValueType>
 	void readVolume(ExplicitVolume<ValueType>& volume, std::string dataset, bool onlyGeometry = false) {
 
 		// the volume
 		if (!onlyGeometry)
-			_hdfFile.readAndResize(dataset, volume.data());
+			readData(dataset, volume.data());
+
+		util::point<float,3> resolution;
+		util::point<float,3> offset;
+		readGeometry(dataset, resolution, offset);
+
+		volume.setResolution(resolution.x(), resolution.y(), resolution.z());
+		volume.setOffset(offset.x(), offset.y(), offset.z());
+	}
+
+	/**
+	 * Read only the part of a dataset that intersects the given region of 
+	 * interest. The region is given in world units, i.e., with respect to the 
+	 * resolution and offset attributes of the dataset.
+	 */
+	template <typename ValueType>
+	void readVolume(ExplicitVolume<ValueType>& volume, std::string dataset, const util::box<float,3>& roi) {
+
+		util::point<float,3> resolution;
+		util::point<float,3> offset;
+		readGeometry(dataset, resolution, offset);
+
+		vigra::ArrayVector<hsize_t> datasetShape = _hdfFile.getDatasetShape(dataset);
+
+		vigra::Shape3 begin, shape;
+		getDiscreteRoi(
+				roi,
+				vigra::Shape3(datasetShape[0], datasetShape[1], datasetShape[2]),
+				resolution,
+				offset,
+				begin,
+				shape);
+
+		LOG_DEBUG(logger::out) << "reading block " << begin << " of size " << shape << " from " << dataset << std::endl;
+
+		readData(dataset, volume.data(), begin, shape);
+
+		volume.setResolution(resolution.x(), resolution.y(), resolution.z());
+		volume.setOffset(
+				offset.x() + begin[0]*resolution.x(),
+				offset.y() + begin[1]*resolution.y(),
+				offset.z() + begin[2]*resolution.z());
+	}
+
+private:
+
+	void readGeometry(std::string dataset, util::point<float,3>& resolution, util::point<float,3>& offset) {
 
 		vigra::MultiArray<1, float> p(3);
 
@@ -31,14 +88,15 @@ public:
 						dataset,
 						"resolution",
 						p);
-			// resolution is stored as (z,y,x) to conform to how dataset is stored
-			volume.setResolution(p[2], p[1], p[0]);
 
 		} catch (std::exception& e) {
 
 			LOG_ERROR(logger::out) << "failed to read resolution attribute" << std::endl;
 		}
 
+		// resolution is stored as (z,y,x) to conform to how dataset is stored
+		resolution = util::point<float,3>(p[2], p[1], p[0]);
+
 		// offset
 		p[0] = p[1] = p[2] = 0.0;
 
@@ -49,16 +107,54 @@ public:
 						dataset,
 						"offset",
 						p);
-			// offset is stored as (z,y,x) to conform to how dataset is stored
-			volume.setOffset(p[2], p[1], p[0]);
 
 		} catch (std::exception& e) {
 
 			LOG_ERROR(logger::out) << "failed to read offset attribute" << std::endl;
 		}
+
+		// offset is stored as (z,y,x) to conform to how dataset is stored
+		offset = util::point<float,3>(p[2], p[1], p[0]);
 	}
 
-private:
+	template <typename ValueType>
+	void readData(std::string dataset, vigra::MultiArray<3, ValueType>& data) {
+
+		vigra::ArrayVector<hsize_t> shape = _hdfFile.getDatasetShape(dataset);
+
+		if (shape.size() != 3) {
+
+			_hdfFile.readAndResize(dataset, data);
+			return;
+		}
+
+		readData(dataset, data, vigra::Shape3(0, 0, 0), vigra::Shape3(shape[0], shape[1], shape[2]));
+	}
+
+	template <typename ValueType>
+	void readData(
+			std::string dataset,
+			vigra::MultiArray<3, ValueType>& data,
+			const vigra::Shape3& begin,
+			const vigra::Shape3& shape) {
+
+		// decompress chunked datasets in parallel, if we can
+		auto handle = _hdfFile.getDatasetHandle(dataset);
+		Hdf5ChunkReader chunkReader(handle.get());
+
+		if (chunkReader.isSupported()) {
+
+			// limit the number of compressed chunks waiting in memory
+			unsigned int numThreads = std::max(1u, std::thread::hardware_concurrency());
+			ThreadPool pool(numThreads, 4*numThreads);
+
+			if (chunkReader.readBlock(data, pool, begin, shape))
+				return;
+		}
+
+		data.reshape(shape);
+		_hdfFile.readBlock(dataset, begin, shape, data);
+	}
 
 	vigra::HDF5File& _hdfFile;
 };
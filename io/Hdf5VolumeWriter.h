@@ -0,0 +1,99 @@
+#ifndef TOOLS_IO_HDF5_VOLUME_WRITER_H__
+#define TOOLS_IO_HDF5_VOLUME_WRITER_H__
+
+#include <algorithm>
+#include <string>
+#include <vigra/hdf5impex.hxx>
+#include <imageprocessing/ExplicitVolume.h>
+#include "Hdf5ChunkWriter.h"
+#include "ThreadPool.h"
+
+/**
+ * Writes volumes as chunked and compressed HDF5 datasets, with resolution and
+ * offset attributes as Hdf5VolumeReader expects them.
+ */
+class Hdf5VolumeWriter {
+
+public:
+
+	Hdf5VolumeWriter(vigra::HDF5File& hdfFile) :
+		_hdfFile(hdfFile) {}
+
+	/**
+	 * Write a volume to a dataset. An existing dataset of the same name will
+	 * be replaced. Chunks are compressed in parallel.
+	 *
+	 * @param compression
+	 *              The deflate level (1 to 9), 0 to write uncompressed.
+	 * @param chunkShape
+	 *              The shape of the chunks in voxels (x,y,z). If not given,
+	 *              getDefaultChunkShape() is used.
+	 * @param numThreads
+	 *              The number of threads to compress with, 0 for one per core.
+	 */
+	template <typename ValueType>
+	void writeVolume(
+			const ExplicitVolume<ValueType>& volume,
+			std::string dataset,
+			int compression = 6,
+			vigra::Shape3 chunkShape = vigra::Shape3(0, 0, 0),
+			unsigned int numThreads = 0) {
+
+		const vigra::MultiArray<3, ValueType>& data = volume.data();
+
+		if (chunkShape[0] == 0)
+			chunkShape = getDefaultChunkShape(data.shape());
+
+		_hdfFile.createDataset<3, ValueType>(dataset, data.shape(), 0, chunkShape, compression);
+
+		{
+			auto handle = _hdfFile.getDatasetHandle(dataset);
+			Hdf5ChunkWriter chunkWriter(handle.get());
+
+			if (chunkWriter.isSupported()) {
+
+				ThreadPool pool(numThreads);
+				chunkWriter.write(data, pool);
+
+			} else {
+
+				_hdfFile.write(dataset, data, chunkShape, compression);
+			}
+		}
+
+		vigra::MultiArray<1, float> p(3);
+
+		// resolution and offset are stored as (z,y,x) to conform to how the
+		// dataset is stored
+		p[0] = volume.getResolution().z();
+		p[1] = volume.getResolution().y();
+		p[2] = volume.getResolution().x();
+		_hdfFile.writeAttribute(dataset, "resolution", p);
+
+		p[0] = volume.getOffset().z();
+		p[1] = volume.getOffset().y();
+		p[2] = volume.getOffset().x();
+		_hdfFile.writeAttribute(dataset, "offset", p);
+	}
+
+	/**
+	 * The default chunk shape: 128x128 in a section, such that blocks can be
+	 * read without touching much outside of them, but only 8 sections deep,
+	 * such that reading a single section does not decompress too many
+	 * others.
+	 */
+	static vigra::Shape3 getDefaultChunkShape(const vigra::Shape3& shape) {
+
+		return vigra::Shape3(
+				std::min<vigra::MultiArrayIndex>(shape[0], 128),
+				std::min<vigra::MultiArrayIndex>(shape[1], 128),
+				std::min<vigra::MultiArrayIndex>(shape[2], 8));
+	}
+
+private:
+
+	vigra::HDF5File& _hdfFile;
+};
+
+#endif // TOOLS_IO_HDF5_VOLUME_WRITER_H__
+
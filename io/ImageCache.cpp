@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <util/Logger.h>
+#include "ImageCache.h"
+#include "volumes.h"
+
+logger::LogChannel imagecachelog("imagecachelog", "[ImageCache] ");
+
+ImageCache::ImageCache(
+		const std::vector<std::string>& filenames,
+		size_t maxBytes,
+		unsigned int numThreads,
+		size_t maxQueued) :
+	_filenames(filenames),
+	_maxBytes(maxBytes),
+	_bytes(0),
+	_maxQueued(std::max(maxQueued, (size_t)1)),
+	_numThreads(std::max(numThreads, 1u)),
+	_numWorking(0),
+	_pool(_numThreads) {}
+
+std::shared_ptr<Image>
+ImageCache::get(size_t i) {
+
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	// wait for prefetching of this image to finish
+	while (_pending.count(i))
+		_decoded.wait(lock);
+
+	if (_images.count(i)) {
+
+		touch(i);
+		return _images[i].first;
+	}
+
+	lock.unlock();
+
+	std::shared_ptr<Image> image;
+
+	try {
+
+		image = decode(i);
+
+	} catch (std::exception& e) {
+
+		LOG_ERROR(imagecachelog) << "can not read " << _filenames[i] << ": " << e.what() << std::endl;
+
+		// show something instead of giving up on all images
+		image = std::make_shared<Image>();
+		image->reshape(vigra::Shape2(1, 1));
+		image->setIdentifiyer(_filenames[i] + " (unreadable)");
+	}
+
+	lock.lock();
+
+	insert(i, image);
+
+	return image;
+}
+
+void
+ImageCache::prefetch(size_t i) {
+
+	if (i >= _filenames.size())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		if (_images.count(i) || _pending.count(i) || std::find(_queue.begin(), _queue.end(), i) != _queue.end())
+			return;
+
+		_queue.push_back(i);
+
+		// the oldest requests are outdated, the user moved on since
+		if (_queue.size() > _maxQueued)
+			_queue.pop_front();
+
+		// the threads working on the queue will get to this image
+		if (_numWorking == _numThreads)
+			return;
+
+		_numWorking++;
+	}
+
+	_pool.schedule([this]() { prefetchQueued(); });
+}
+
+void
+ImageCache::prefetchQueued() {
+
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	while (!_queue.empty()) {
+
+		size_t i = _queue.front();
+		_queue.pop_front();
+
+		// decoded by get() in the meantime
+		if (_images.count(i))
+			continue;
+
+		_pending.insert(i);
+
+		lock.unlock();
+
+		std::shared_ptr<Image> image;
+
+		try {
+
+			image = decode(i);
+
+		} catch (std::exception& e) {
+
+			LOG_ERROR(imagecachelog) << "failed to prefetch " << _filenames[i] << ": " << e.what() << std::endl;
+		}
+
+		lock.lock();
+
+		if (image)
+			insert(i, image);
+
+		_pending.erase(i);
+		_decoded.notify_all();
+	}
+
+	_numWorking--;
+}
+
+std::shared_ptr<Image>
+ImageCache::decode(size_t i) {
+
+	const std::string& filename = _filenames[i];
+
+	auto image = std::make_shared<Image>();
+	readImage(filename, *image);
+
+	LOG_DEBUG(imagecachelog) << "decoded " << filename << std::endl;
+
+	return image;
+}
+
+void
+ImageCache::insert(size_t i, std::shared_ptr<Image> image) {
+
+	if (_images.count(i)) {
+
+		touch(i);
+		return;
+	}
+
+	_lru.push_front(i);
+	_images[i] = std::make_pair(image, _lru.begin());
+	_bytes += image->width()*image->height()*sizeof(float);
+
+	// evict, but keep at least the image we just added
+	while (_bytes > _maxBytes && _lru.size() > 1) {
+
+		size_t last = _lru.back();
+		std::shared_ptr<Image> evicted = _images[last].first;
+
+		_bytes -= evicted->width()*evicted->height()*sizeof(float);
+		_images.erase(last);
+		_lru.pop_back();
+
+		LOG_ALL(imagecachelog) << "evicted " << _filenames[last] << std::endl;
+	}
+}
+
+void
+ImageCache::touch(size_t i) {
+
+	_lru.splice(_lru.begin(), _lru, _images[i].second);
+}
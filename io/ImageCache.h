@@ -0,0 +1,106 @@
+#ifndef TOOLS_IO_IMAGE_CACHE_H__
+#define TOOLS_IO_IMAGE_CACHE_H__
+
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+#include <imageprocessing/Image.h>
+#include "ThreadPool.h"
+
+/**
+ * Decodes the images of a list of files on demand and keeps the most recently
+ * used ones, up to a memory limit. Images can be prefetched on background
+ * threads.
+ */
+class ImageCache {
+
+public:
+
+	/**
+	 * Create a cache for the given files.
+	 *
+	 * @param filenames
+	 *              The image files, nothing is read until requested.
+	 * @param maxBytes
+	 *              The maximal memory to use for decoded images. The most
+	 *              recently used image is always kept.
+	 * @param numThreads
+	 *              The number of threads to prefetch images with.
+	 * @param maxQueued
+	 *              The maximal number of images waiting to be prefetched. If
+	 *              more are requested, the oldest requests are dropped.
+	 */
+	ImageCache(
+			const std::vector<std::string>& filenames,
+			size_t maxBytes,
+			unsigned int numThreads = 2,
+			size_t maxQueued = 8);
+
+	/**
+	 * The number of images.
+	 */
+	size_t size() const { return _filenames.size(); }
+
+	/**
+	 * Get an image, decode it if it is not in the cache. Blocks until the
+	 * image is available. Images that can not be read are replaced by a
+	 * black single pixel image.
+	 */
+	std::shared_ptr<Image> get(size_t i);
+
+	/**
+	 * Decode an image in the background, if it is not in the cache already.
+	 */
+	void prefetch(size_t i);
+
+private:
+
+	// decode queued images until there are no more, called on the prefetch
+	// threads
+	void prefetchQueued();
+
+	std::shared_ptr<Image> decode(size_t i);
+
+	// add an image as the most recently used one and evict the least recently
+	// used ones that exceed the memory limit
+	void insert(size_t i, std::shared_ptr<Image> image);
+
+	// mark an image as the most recently used one
+	void touch(size_t i);
+
+	std::vector<std::string> _filenames;
+
+	size_t _maxBytes;
+	size_t _bytes;
+
+	// image indices, most recently used first
+	std::list<size_t> _lru;
+
+	std::map<size_t, std::pair<std::shared_ptr<Image>, std::list<size_t>::iterator>> _images;
+
+	// images waiting to be prefetched, oldest request first
+	std::deque<size_t> _queue;
+	size_t             _maxQueued;
+
+	// images currently decoded by the prefetch threads
+	std::set<size_t> _pending;
+
+	// the number of prefetch tasks working on the queue
+	unsigned int _numThreads;
+	unsigned int _numWorking;
+
+	std::mutex              _mutex;
+	std::condition_variable _decoded;
+
+	// last member, such that pending tasks finish before the rest is destructed
+	ThreadPool _pool;
+};
+
+#endif // TOOLS_IO_IMAGE_CACHE_H__
+
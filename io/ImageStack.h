@@ -0,0 +1,128 @@
+#ifndef TOOLS_IO_IMAGE_STACK_H__
+#define TOOLS_IO_IMAGE_STACK_H__
+
+#include <memory>
+#include <type_traits>
+#include <vigra/impex.hxx>
+#include <vigra/multi_array.hxx>
+#include <util/point.hpp>
+#include <util/box.hpp>
+#include <util/exceptions.h>
+
+/**
+ * A volume stored as a sequence of images, which is read on demand one section
+ * at a time. Sections are converted the same way readVolume() does.
+ */
+template <typename T>
+class ImageStack {
+
+public:
+
+	typedef vigra::MultiArray<2, T> Section;
+
+	ImageStack(const std::vector<std::string>& filenames) :
+		_filenames(filenames),
+		_width(0),
+		_height(0),
+		_cropBegin(0, 0),
+		_cropped(false),
+		_resolution(1.0, 1.0, 1.0),
+		_offset(0.0, 0.0, 0.0) {
+
+		if (_filenames.size() == 0)
+			return;
+
+		vigra::ImageImportInfo info(_filenames[0].c_str());
+		_width  = info.width();
+		_height = info.height();
+	}
+
+	/**
+	 * Restrict the stack to a block, given by its offset and shape in voxels.
+	 * Sections outside the block will not be read.
+	 */
+	void crop(const vigra::Shape3& begin, const vigra::Shape3& shape) {
+
+		_filenames = std::vector<std::string>(
+				_filenames.begin() + begin[2],
+				_filenames.begin() + begin[2] + shape[2]);
+
+		_cropBegin = vigra::Shape2(_cropBegin[0] + begin[0], _cropBegin[1] + begin[1]);
+		_width     = shape[0];
+		_height    = shape[1];
+		_cropped   = true;
+	}
+
+	unsigned int width()  const { return _width; }
+	unsigned int height() const { return _height; }
+	unsigned int depth()  const { return _filenames.size(); }
+
+	void setResolution(const util::point<float,3>& resolution) { _resolution = resolution; }
+	void setOffset(const util::point<float,3>& offset) { _offset = offset; }
+
+	const util::point<float,3>& getResolution() const { return _resolution; }
+	const util::point<float,3>& getOffset() const { return _offset; }
+
+	util::box<float,3> getBoundingBox() const {
+
+		return util::box<float,3>(
+				_offset,
+				_offset + util::point<float,3>(
+						_width*_resolution.x(),
+						_height*_resolution.y(),
+						depth()*_resolution.z()));
+	}
+
+	/**
+	 * Read a single section. Can be called concurrently from several threads.
+	 */
+	std::shared_ptr<Section> readSection(unsigned int z) const {
+
+		auto section = std::make_shared<Section>(vigra::Shape2(_width, _height));
+
+		try {
+
+			vigra::ImageImportInfo info(_filenames[z].c_str());
+
+			if (_cropped) {
+
+				Section image(vigra::Shape2(info.width(), info.height()));
+				importImage(info, image);
+
+				*section = image.subarray(_cropBegin, _cropBegin + vigra::Shape2(_width, _height));
+
+			} else {
+
+				importImage(info, *section);
+			}
+
+			if (std::is_floating_point<T>::value && std::string(info.getPixelType()) == "UINT8")
+				*section *= 1.0/255.0;
+
+		} catch (std::exception& e) {
+
+			UTIL_THROW_EXCEPTION(
+					IOError,
+					"error reading " << _filenames[z] << ": " << e.what());
+		}
+
+		return section;
+	}
+
+private:
+
+	std::vector<std::string> _filenames;
+
+	unsigned int _width;
+	unsigned int _height;
+
+	// the begin of the block in x and y, if cropped
+	vigra::Shape2 _cropBegin;
+	bool          _cropped;
+
+	util::point<float,3> _resolution;
+	util::point<float,3> _offset;
+};
+
+#endif // TOOLS_IO_IMAGE_STACK_H__
+
@@ -0,0 +1,20 @@
+#include "InMemoryTiledImage.h"
+#include "volumes.h"
+
+InMemoryTiledImage::InMemoryTiledImage(const std::string& filename, unsigned int tileSize) {
+
+	readImage(filename, _image);
+
+	setGeometry(_image.width(), _image.height(), tileSize);
+}
+
+std::shared_ptr<TiledImage::Tile>
+InMemoryTiledImage::readTile(unsigned int level, unsigned int x, unsigned int y) {
+
+	if (level > 0)
+		return std::shared_ptr<Tile>();
+
+	vigra::Shape2 begin(x*getTileSize(), y*getTileSize());
+
+	return std::make_shared<Tile>(_image.subarray(begin, begin + getTileShape(level, x, y)));
+}
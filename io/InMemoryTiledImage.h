@@ -0,0 +1,27 @@
+#ifndef TOOLS_IO_IN_MEMORY_TILED_IMAGE_H__
+#define TOOLS_IO_IN_MEMORY_TILED_IMAGE_H__
+
+#include <imageprocessing/Image.h>
+#include "TiledImage.h"
+
+/**
+ * A tiled image for formats that can only be read completely. The full
+ * resolution is kept in memory, the pyramid levels are created on demand.
+ */
+class InMemoryTiledImage : public TiledImage {
+
+public:
+
+	InMemoryTiledImage(const std::string& filename, unsigned int tileSize);
+
+protected:
+
+	std::shared_ptr<Tile> readTile(unsigned int level, unsigned int x, unsigned int y) override;
+
+private:
+
+	Image _image;
+};
+
+#endif // TOOLS_IO_IN_MEMORY_TILED_IMAGE_H__
+
@@ -0,0 +1,100 @@
+#include <algorithm>
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned int numThreads, size_t maxQueued) :
+	_maxQueued(maxQueued),
+	_busy(0),
+	_stop(false) {
+
+	if (numThreads == 0)
+		numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+	for (unsigned int i = 0; i < numThreads; i++)
+		_threads.push_back(std::thread(&ThreadPool::run, this));
+}
+
+ThreadPool::~ThreadPool() {
+
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+
+		while (!_tasks.empty() || _busy > 0)
+			_tasksDone.wait(lock);
+
+		_stop = true;
+	}
+
+	_taskAvailable.notify_all();
+
+	for (std::thread& thread : _threads)
+		thread.join();
+}
+
+void
+ThreadPool::schedule(std::function<void()> task) {
+
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	while (_maxQueued > 0 && _tasks.size() >= _maxQueued)
+		_taskTaken.wait(lock);
+
+	_tasks.push_back(task);
+	_taskAvailable.notify_one();
+}
+
+void
+ThreadPool::wait() {
+
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	while (!_tasks.empty() || _busy > 0)
+		_tasksDone.wait(lock);
+
+	if (_exception) {
+
+		std::exception_ptr exception = _exception;
+		_exception = std::exception_ptr();
+		std::rethrow_exception(exception);
+	}
+}
+
+void
+ThreadPool::run() {
+
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	while (true) {
+
+		while (!_stop && _tasks.empty())
+			_taskAvailable.wait(lock);
+
+		if (_stop)
+			return;
+
+		std::function<void()> task = _tasks.front();
+		_tasks.pop_front();
+		_busy++;
+
+		_taskTaken.notify_one();
+
+		lock.unlock();
+
+		try {
+
+			task();
+
+		} catch (...) {
+
+			std::lock_guard<std::mutex> exceptionLock(_mutex);
+			if (!_exception)
+				_exception = std::current_exception();
+		}
+
+		lock.lock();
+
+		_busy--;
+
+		if (_tasks.empty() && _busy == 0)
+			_tasksDone.notify_all();
+	}
+}
@@ -0,0 +1,73 @@
+#ifndef TOOLS_IO_THREAD_POOL_H__
+#define TOOLS_IO_THREAD_POOL_H__
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A fixed number of worker threads processing scheduled tasks in order.
+ */
+class ThreadPool {
+
+public:
+
+	/**
+	 * Create a thread pool.
+	 *
+	 * @param numThreads
+	 *              The number of worker threads. If 0, one thread per core is
+	 *              used.
+	 * @param maxQueued
+	 *              The maximal number of tasks waiting to be processed. If
+	 *              reached, schedule() blocks until a worker is available. If
+	 *              0, the queue is unbounded.
+	 */
+	ThreadPool(unsigned int numThreads = 0, size_t maxQueued = 0);
+
+	/**
+	 * Finishes all scheduled tasks before returning.
+	 */
+	~ThreadPool();
+
+	/**
+	 * Add a task to the queue.
+	 */
+	void schedule(std::function<void()> task);
+
+	/**
+	 * Wait until all scheduled tasks are done. If one of the tasks threw an
+	 * exception, the first one is rethrown here.
+	 */
+	void wait();
+
+	/**
+	 * The number of worker threads.
+	 */
+	unsigned int size() const { return _threads.size(); }
+
+private:
+
+	void run();
+
+	std::vector<std::thread>          _threads;
+	std::deque<std::function<void()>> _tasks;
+
+	size_t       _maxQueued;
+	unsigned int _busy;
+	bool         _stop;
+
+	std::exception_ptr _exception;
+
+	std::mutex              _mutex;
+	std::condition_variable _taskAvailable;
+	std::condition_variable _taskTaken;
+	std::condition_variable _tasksDone;
+};
+
+#endif // TOOLS_IO_THREAD_POOL_H__
+
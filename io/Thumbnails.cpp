@@ -0,0 +1,250 @@
+#include <algorithm>
+#include <functional>
+#include <sstream>
+#include <boost/filesystem.hpp>
+#include <vigra/impex.hxx>
+#include <util/Logger.h>
+#include "Thumbnails.h"
+#include "volumes.h"
+
+logger::LogChannel thumbnailslog("thumbnailslog", "[Thumbnails] ");
+
+Thumbnails::Thumbnails(
+		const std::vector<std::string>& filenames,
+		unsigned int size,
+		const std::string& cacheDirectory,
+		unsigned int numThreads) :
+	_filenames(filenames),
+	_size(size),
+	_cacheDirectory(cacheDirectory),
+	_gridBegin(0),
+	_gridEnd(0),
+	_pool(numThreads) {
+
+	if (_cacheDirectory.empty())
+		return;
+
+	try {
+
+		boost::filesystem::create_directories(_cacheDirectory);
+
+	} catch (std::exception& e) {
+
+		LOG_ERROR(thumbnailslog)
+				<< "can not create thumbnail cache " << _cacheDirectory
+				<< ", thumbnails will not be stored: " << e.what() << std::endl;
+
+		_cacheDirectory = "";
+	}
+}
+
+std::shared_ptr<Image>
+Thumbnails::getGrid(size_t begin, size_t end, unsigned int columns) {
+
+	end = std::min(end, _filenames.size());
+
+	std::vector<std::shared_ptr<Image>> thumbnails;
+	std::vector<size_t>                 missing;
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		_gridBegin = begin;
+		_gridEnd   = end;
+
+		// forget the thumbnails of other grids
+		for (auto i = _ready.begin(); i != _ready.end();)
+			if (i->first < begin || i->first >= end)
+				i = _ready.erase(i);
+			else
+				++i;
+
+		for (size_t i = begin; i < end; i++) {
+
+			auto ready = _ready.find(i);
+
+			if (ready != _ready.end()) {
+
+				thumbnails.push_back(ready->second);
+
+			} else {
+
+				thumbnails.push_back(std::shared_ptr<Image>());
+
+				if (!_pending.count(i)) {
+
+					_pending.insert(i);
+					missing.push_back(i);
+				}
+			}
+		}
+	}
+
+	for (size_t i : missing)
+		_pool.schedule([this, i]() {
+
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+
+				// a different grid was requested since
+				if (i < _gridBegin || i >= _gridEnd) {
+
+					_pending.erase(i);
+					return;
+				}
+			}
+
+			std::shared_ptr<Image> thumbnail = create(i);
+			std::function<void()>  callback;
+
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+
+				_pending.erase(i);
+
+				if (i >= _gridBegin && i < _gridEnd) {
+
+					_ready[i] = thumbnail;
+					callback  = _readyCallback;
+				}
+			}
+
+			if (callback)
+				callback();
+		});
+
+	unsigned int rows = (thumbnails.size() + columns - 1)/columns;
+
+	auto grid = std::make_shared<Image>();
+	grid->reshape(vigra::Shape2(columns*_size, std::max(1u, rows)*_size));
+
+	for (unsigned int i = 0; i < thumbnails.size(); i++) {
+
+		if (!thumbnails[i])
+			continue;
+
+		const Image& thumbnail = *thumbnails[i];
+
+		if (thumbnail.width() == 0 || thumbnail.height() == 0)
+			continue;
+
+		vigra::Shape2 corner((i%columns)*_size, (i/columns)*_size);
+
+		grid->subarray(corner, corner + thumbnail.shape()) = thumbnail;
+	}
+
+	std::stringstream identifier;
+	identifier << "images " << begin << " to " << begin + thumbnails.size() - 1;
+	grid->setIdentifiyer(identifier.str());
+
+	return grid;
+}
+
+void
+Thumbnails::setReadyCallback(std::function<void()> callback) {
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	_readyCallback = callback;
+}
+
+bool
+Thumbnails::isCreating() {
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	return !_pending.empty();
+}
+
+std::shared_ptr<Image>
+Thumbnails::create(size_t i) {
+
+	auto thumbnail = std::make_shared<Image>();
+
+	try {
+
+		std::string cacheFilename = getCacheFilename(i);
+
+		if (!cacheFilename.empty() && boost::filesystem::exists(cacheFilename)) {
+
+			readImage(cacheFilename, *thumbnail);
+			thumbnail->setIdentifiyer(_filenames[i]);
+
+			return thumbnail;
+		}
+
+		// vigra can not decode at a reduced resolution, so we read the whole
+		// image and average blocks of pixels
+		Image image;
+		readImage(_filenames[i], image);
+
+		unsigned int factor = std::max(
+				1u,
+				(unsigned int)(std::max(image.width(), image.height()) + _size - 1)/_size);
+
+		downscale(image, *thumbnail, factor);
+		thumbnail->setIdentifiyer(_filenames[i]);
+
+		if (!cacheFilename.empty()) {
+
+			// write to a temporary file first, such that an interrupted run
+			// does not leave a truncated thumbnail behind
+			boost::filesystem::path temporary =
+					boost::filesystem::path(_cacheDirectory)/
+					boost::filesystem::unique_path("%%%%-%%%%-%%%%-%%%%.tmp.tif");
+
+			vigra::exportImage(*thumbnail, vigra::ImageExportInfo(temporary.native().c_str()));
+			boost::filesystem::rename(temporary, cacheFilename);
+		}
+
+		LOG_DEBUG(thumbnailslog) << "created thumbnail for " << _filenames[i] << std::endl;
+
+	} catch (std::exception& e) {
+
+		LOG_ERROR(thumbnailslog) << "can not create thumbnail for " << _filenames[i] << ": " << e.what() << std::endl;
+
+		thumbnail = std::make_shared<Image>();
+	}
+
+	return thumbnail;
+}
+
+std::string
+Thumbnails::getCacheFilename(size_t i) const {
+
+	if (_cacheDirectory.empty())
+		return "";
+
+	boost::filesystem::path path = boost::filesystem::absolute(_filenames[i]);
+
+	std::stringstream key;
+	key << path.native() << ":" << boost::filesystem::last_write_time(path) << ":" << _size;
+
+	std::stringstream filename;
+	filename << std::hex << std::hash<std::string>()(key.str()) << ".tif";
+
+	return (boost::filesystem::path(_cacheDirectory)/filename.str()).native();
+}
+
+void
+Thumbnails::downscale(const Image& image, Image& thumbnail, unsigned int factor) {
+
+	unsigned int width  = (image.width()  + factor - 1)/factor;
+	unsigned int height = (image.height() + factor - 1)/factor;
+
+	thumbnail.reshape(vigra::Shape2(width, height));
+
+	for (unsigned int y = 0; y < height; y++)
+		for (unsigned int x = 0; x < width; x++) {
+
+			unsigned int endX = std::min((unsigned int)image.width(),  (x + 1)*factor);
+			unsigned int endY = std::min((unsigned int)image.height(), (y + 1)*factor);
+
+			float sum = 0;
+			for (unsigned int v = y*factor; v < endY; v++)
+				for (unsigned int u = x*factor; u < endX; u++)
+					sum += image(u, v);
+
+			thumbnail(x, y) = sum/((endX - x*factor)*(endY - y*factor));
+		}
+}
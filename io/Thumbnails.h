@@ -0,0 +1,103 @@
+#ifndef TOOLS_IO_THUMBNAILS_H__
+#define TOOLS_IO_THUMBNAILS_H__
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+#include <imageprocessing/Image.h>
+#include "ThreadPool.h"
+
+/**
+ * Creates downscaled versions of images in parallel and stores them in a
+ * cache directory, keyed by the path and modification time of the original
+ * image.
+ */
+class Thumbnails {
+
+public:
+
+	/**
+	 * Create a thumbnail provider for the given files.
+	 *
+	 * @param filenames
+	 *              The image files.
+	 * @param size
+	 *              The maximal width and height of the thumbnails.
+	 * @param cacheDirectory
+	 *              Where to store the thumbnails. Will be created if it does
+	 *              not exist. If empty, thumbnails are not stored.
+	 * @param numThreads
+	 *              The number of threads to create thumbnails with, 0 for one
+	 *              per core.
+	 */
+	Thumbnails(
+			const std::vector<std::string>& filenames,
+			unsigned int size,
+			const std::string& cacheDirectory,
+			unsigned int numThreads = 0);
+
+	/**
+	 * The number of images.
+	 */
+	size_t size() const { return _filenames.size(); }
+
+	/**
+	 * The maximal width and height of the thumbnails.
+	 */
+	unsigned int getThumbnailSize() const { return _size; }
+
+	/**
+	 * Create a single image showing the thumbnails of the images in [begin,
+	 * end) in a grid with the given number of columns. Does not block:
+	 * thumbnails that are not available yet are left blank and created in
+	 * the background. Call again after the ready callback was invoked to get
+	 * a more complete grid.
+	 */
+	std::shared_ptr<Image> getGrid(size_t begin, size_t end, unsigned int columns);
+
+	/**
+	 * Set a function to call whenever a thumbnail of the last requested grid
+	 * became available. Called from the worker threads.
+	 */
+	void setReadyCallback(std::function<void()> callback);
+
+	/**
+	 * True while thumbnails of the last requested grid are being created.
+	 */
+	bool isCreating();
+
+private:
+
+	std::shared_ptr<Image> create(size_t i);
+
+	// the name of the cache file for image i, empty if there is no cache
+	std::string getCacheFilename(size_t i) const;
+
+	// average non-overlapping blocks of factor x factor pixels
+	static void downscale(const Image& image, Image& thumbnail, unsigned int factor);
+
+	std::vector<std::string> _filenames;
+
+	unsigned int _size;
+
+	std::string _cacheDirectory;
+
+	// the images of the last requested grid, their available thumbnails, and
+	// the ones being created
+	size_t                                   _gridBegin;
+	size_t                                   _gridEnd;
+	std::map<size_t, std::shared_ptr<Image>> _ready;
+	std::set<size_t>                         _pending;
+	std::function<void()>                    _readyCallback;
+	std::mutex                               _mutex;
+
+	// last member, such that pending tasks finish before the rest is destructed
+	ThreadPool _pool;
+};
+
+#endif // TOOLS_IO_THUMBNAILS_H__
+
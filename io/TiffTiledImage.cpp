@@ -0,0 +1,225 @@
+#include <cstdarg>
+#include <cstring>
+#include <fstream>
+#include <tiffvers.h>
+#include <util/Logger.h>
+#include <util/exceptions.h>
+#include "TiffTiledImage.h"
+
+logger::LogChannel tifftiledimagelog("tifftiledimagelog", "[TiffTiledImage] ");
+
+// TIFFOpenExt with per-handle error handlers is available since libtiff 4.5
+#define TIFF_HAVE_OPEN_OPTIONS (TIFFLIB_VERSION >= 20221213)
+
+namespace {
+
+// true if the file starts with the byte order and magic number of a TIFF or
+// BigTIFF
+bool
+hasTiffHeader(const std::string& filename) {
+
+	std::ifstream file(filename.c_str(), std::ios::binary);
+
+	char header[4];
+	if (!file.read(header, 4))
+		return false;
+
+	return
+			std::memcmp(header, "II*\0", 4) == 0 || std::memcmp(header, "MM\0*", 4) == 0 ||
+			std::memcmp(header, "II+\0", 4) == 0 || std::memcmp(header, "MM\0+", 4) == 0;
+}
+
+#if TIFF_HAVE_OPEN_OPTIONS
+int
+ignoreTiffMessage(TIFF*, void*, const char*, const char*, va_list) {
+
+	// handled, don't pass on to the global handlers
+	return 1;
+}
+#endif
+
+} // namespace
+
+bool
+isTiledTiff(const std::string& filename) {
+
+	// don't let libtiff complain about files that are not TIFFs, without
+	// touching its global handlers, which other threads might be using
+	if (!hasTiffHeader(filename))
+		return false;
+
+#if TIFF_HAVE_OPEN_OPTIONS
+	TIFFOpenOptions* options = TIFFOpenOptionsAlloc();
+	TIFFOpenOptionsSetErrorHandlerExtR(options, ignoreTiffMessage, 0);
+	TIFFOpenOptionsSetWarningHandlerExtR(options, ignoreTiffMessage, 0);
+
+	TIFF* tiff = TIFFOpenExt(filename.c_str(), "r", options);
+
+	TIFFOpenOptionsFree(options);
+#else
+	TIFF* tiff = TIFFOpen(filename.c_str(), "r");
+#endif
+
+	if (!tiff)
+		return false;
+
+	bool tiled = TIFFIsTiled(tiff);
+
+	TIFFClose(tiff);
+
+	return tiled;
+}
+
+TiffTiledImage::TiffTiledImage(const std::string& filename) :
+	_filename(filename) {
+
+	TIFF* tiff = TIFFOpen(filename.c_str(), "r");
+
+	if (!tiff)
+		UTIL_THROW_EXCEPTION(
+				IOError,
+				"can not open " << filename);
+
+	uint32_t width, height, tileWidth, tileHeight;
+	uint16_t samplesPerPixel = 1;
+
+	_sampleFormat = SAMPLEFORMAT_UINT;
+
+	TIFFGetField(tiff, TIFFTAG_IMAGEWIDTH, &width);
+	TIFFGetField(tiff, TIFFTAG_IMAGELENGTH, &height);
+	TIFFGetFieldDefaulted(tiff, TIFFTAG_BITSPERSAMPLE, &_bitsPerSample);
+	TIFFGetFieldDefaulted(tiff, TIFFTAG_SAMPLESPERPIXEL, &samplesPerPixel);
+	TIFFGetFieldDefaulted(tiff, TIFFTAG_SAMPLEFORMAT, &_sampleFormat);
+
+	bool supported =
+			TIFFIsTiled(tiff) &&
+			TIFFGetField(tiff, TIFFTAG_TILEWIDTH, &tileWidth) &&
+			TIFFGetField(tiff, TIFFTAG_TILELENGTH, &tileHeight) &&
+			tileWidth == tileHeight &&
+			tileWidth%2 == 0 &&
+			samplesPerPixel == 1 &&
+			((_sampleFormat == SAMPLEFORMAT_UINT && (_bitsPerSample == 8 || _bitsPerSample == 16)) ||
+			 (_sampleFormat == SAMPLEFORMAT_IEEEFP && _bitsPerSample == 32));
+
+	if (!supported) {
+
+		TIFFClose(tiff);
+		UTIL_THROW_EXCEPTION(
+				IOError,
+				filename << " is not a single channel tiled TIFF with square tiles");
+	}
+
+	setGeometry(width, height, tileWidth);
+
+	_directories[0] = 0;
+
+	// find pyramid levels in the following directories, they have to have the
+	// same tiling and pixel format as the full resolution image
+	for (tdir_t directory = 1; TIFFSetDirectory(tiff, directory); directory++) {
+
+		uint32_t levelWidth, levelHeight, levelTileWidth = 0;
+		uint16_t bitsPerSample;
+
+		TIFFGetField(tiff, TIFFTAG_IMAGEWIDTH, &levelWidth);
+		TIFFGetField(tiff, TIFFTAG_IMAGELENGTH, &levelHeight);
+		TIFFGetField(tiff, TIFFTAG_TILEWIDTH, &levelTileWidth);
+		TIFFGetFieldDefaulted(tiff, TIFFTAG_BITSPERSAMPLE, &bitsPerSample);
+
+		if (!TIFFIsTiled(tiff) || levelTileWidth != tileWidth || bitsPerSample != _bitsPerSample)
+			continue;
+
+		for (unsigned int level = 1; level < getNumLevels(); level++)
+			if (levelWidth == this->width(level) && levelHeight == this->height(level))
+				_directories[level] = directory;
+	}
+
+	TIFFSetDirectory(tiff, 0);
+
+	LOG_DEBUG(tifftiledimagelog)
+			<< filename << " has " << _directories.size() << " of "
+			<< getNumLevels() << " pyramid levels stored" << std::endl;
+
+	_handles.push_back(tiff);
+}
+
+TiffTiledImage::~TiffTiledImage() {
+
+	for (TIFF* handle : _handles)
+		TIFFClose(handle);
+}
+
+std::shared_ptr<TiledImage::Tile>
+TiffTiledImage::readTile(unsigned int level, unsigned int x, unsigned int y) {
+
+	if (!_directories.count(level))
+		return std::shared_ptr<Tile>();
+
+	TIFF* tiff = acquireHandle();
+
+	tsize_t tileBytes = TIFFTileSize(tiff);
+	std::vector<char> buffer(tileBytes);
+
+	bool success =
+			TIFFSetDirectory(tiff, _directories[level]) &&
+			TIFFReadTile(tiff, buffer.data(), x*getTileSize(), y*getTileSize(), 0, 0) >= 0;
+
+	releaseHandle(tiff);
+
+	if (!success)
+		UTIL_THROW_EXCEPTION(
+				IOError,
+				"can not read tile " << x << ", " << y << " of level " << level << " of " << _filename);
+
+	// TIFF tiles always have the full size, crop them at the image border
+	auto tile = std::make_shared<Tile>(getTileShape(level, x, y));
+
+	unsigned int tileSize = getTileSize();
+
+	for (unsigned int v = 0; v < tile->height(); v++)
+		for (unsigned int u = 0; u < tile->width(); u++) {
+
+			size_t i = v*tileSize + u;
+
+			if (_bitsPerSample == 8)
+				(*tile)(u, v) = reinterpret_cast<const uint8_t*>(buffer.data())[i]/255.0;
+			else if (_bitsPerSample == 16)
+				(*tile)(u, v) = reinterpret_cast<const uint16_t*>(buffer.data())[i];
+			else
+				(*tile)(u, v) = reinterpret_cast<const float*>(buffer.data())[i];
+		}
+
+	return tile;
+}
+
+TIFF*
+TiffTiledImage::acquireHandle() {
+
+	{
+		std::lock_guard<std::mutex> lock(_handlesMutex);
+
+		if (!_handles.empty()) {
+
+			TIFF* handle = _handles.back();
+			_handles.pop_back();
+
+			return handle;
+		}
+	}
+
+	TIFF* handle = TIFFOpen(_filename.c_str(), "r");
+
+	if (!handle)
+		UTIL_THROW_EXCEPTION(
+				IOError,
+				"can not open " << _filename);
+
+	return handle;
+}
+
+void
+TiffTiledImage::releaseHandle(TIFF* handle) {
+
+	std::lock_guard<std::mutex> lock(_handlesMutex);
+
+	_handles.push_back(handle);
+}
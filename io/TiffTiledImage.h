@@ -0,0 +1,54 @@
+#ifndef TOOLS_IO_TIFF_TILED_IMAGE_H__
+#define TOOLS_IO_TIFF_TILED_IMAGE_H__
+
+#include <map>
+#include <mutex>
+#include <vector>
+#include <tiffio.h>
+#include "TiledImage.h"
+
+/**
+ * A tiled TIFF image, read one tile at a time. Pyramid levels stored as
+ * additional directories of the file are used for the matching levels.
+ *
+ * Every reading thread gets its own handle to the file, such that tiles can
+ * be decoded in parallel.
+ */
+class TiffTiledImage : public TiledImage {
+
+public:
+
+	/**
+	 * Open a tiled TIFF image. Throws an IOError if the image is not tiled,
+	 * its tiles are not square, or it does not have a single 8, 16, or 32 bit
+	 * channel.
+	 */
+	TiffTiledImage(const std::string& filename);
+
+	~TiffTiledImage();
+
+protected:
+
+	std::shared_ptr<Tile> readTile(unsigned int level, unsigned int x, unsigned int y) override;
+
+private:
+
+	TIFF* acquireHandle();
+
+	void releaseHandle(TIFF* handle);
+
+	std::string _filename;
+
+	uint16_t _bitsPerSample;
+	uint16_t _sampleFormat;
+
+	// the TIFF directory holding each stored level
+	std::map<unsigned int, tdir_t> _directories;
+
+	// handles not in use by any thread
+	std::vector<TIFF*> _handles;
+	std::mutex         _handlesMutex;
+};
+
+#endif // TOOLS_IO_TIFF_TILED_IMAGE_H__
+
@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <util/Logger.h>
+#include <util/exceptions.h>
+#include "TiledImage.h"
+#include "TiffTiledImage.h"
+#include "InMemoryTiledImage.h"
+
+logger::LogChannel tiledimagelog("tiledimagelog", "[TiledImage] ");
+
+TiledImage::TiledImage(size_t maxCachedTiles) :
+	_tileSize(0),
+	_maxCachedTiles(maxCachedTiles) {}
+
+void
+TiledImage::setGeometry(unsigned int width, unsigned int height, unsigned int tileSize) {
+
+	_tileSize = tileSize;
+
+	_widths.clear();
+	_heights.clear();
+	_widths.push_back(width);
+	_heights.push_back(height);
+
+	while (_widths.back() > _tileSize || _heights.back() > _tileSize) {
+
+		_widths.push_back((_widths.back() + 1)/2);
+		_heights.push_back((_heights.back() + 1)/2);
+	}
+}
+
+std::shared_ptr<TiledImage::Tile>
+TiledImage::getTile(unsigned int level, unsigned int x, unsigned int y) {
+
+	TileId id(level, x, y);
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		auto i = _tiles.find(id);
+		if (i != _tiles.end()) {
+
+			_lru.splice(_lru.begin(), _lru, i->second.second);
+			return i->second.first;
+		}
+	}
+
+	std::shared_ptr<Tile> tile = readTile(level, x, y);
+
+	if (!tile)
+		tile = downsampleTile(level, x, y);
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	// another thread might have been faster
+	if (_tiles.count(id))
+		return _tiles[id].first;
+
+	_lru.push_front(id);
+	_tiles[id] = std::make_pair(tile, _lru.begin());
+
+	while (_lru.size() > _maxCachedTiles) {
+
+		_tiles.erase(_lru.back());
+		_lru.pop_back();
+	}
+
+	return tile;
+}
+
+vigra::Shape2
+TiledImage::getTileShape(unsigned int level, unsigned int x, unsigned int y) const {
+
+	return vigra::Shape2(
+			std::min(_tileSize, _widths[level]  - x*_tileSize),
+			std::min(_tileSize, _heights[level] - y*_tileSize));
+}
+
+std::shared_ptr<TiledImage::Tile>
+TiledImage::downsampleTile(unsigned int level, unsigned int x, unsigned int y) {
+
+	if (level == 0)
+		UTIL_THROW_EXCEPTION(
+				IOError,
+				"tile " << x << ", " << y << " of " << _identifier << " is not available");
+
+	auto tile = std::make_shared<Tile>(getTileShape(level, x, y));
+
+	unsigned int width  = _widths[level - 1];
+	unsigned int height = _heights[level - 1];
+
+	// each of the four tiles of the level below covers a quarter of this tile
+	for (unsigned int j = 0; j < 2; j++)
+		for (unsigned int i = 0; i < 2; i++) {
+
+			unsigned int sx = 2*x + i;
+			unsigned int sy = 2*y + j;
+
+			if (sx*_tileSize >= width || sy*_tileSize >= height)
+				continue;
+
+			std::shared_ptr<Tile> source = getTile(level - 1, sx, sy);
+
+			unsigned int offsetX = i*_tileSize/2;
+			unsigned int offsetY = j*_tileSize/2;
+
+			for (unsigned int v = 0; v < (source->height() + 1)/2; v++)
+				for (unsigned int u = 0; u < (source->width() + 1)/2; u++) {
+
+					unsigned int u1 = std::min(2*u + 1, (unsigned int)source->width()  - 1);
+					unsigned int v1 = std::min(2*v + 1, (unsigned int)source->height() - 1);
+
+					(*tile)(offsetX + u, offsetY + v) = 0.25*(
+							(*source)(2*u, 2*v) +
+							(*source)(u1,  2*v) +
+							(*source)(2*u, v1) +
+							(*source)(u1,  v1));
+				}
+		}
+
+	return tile;
+}
+
+std::shared_ptr<TiledImage>
+openTiledImage(const std::string& filename, unsigned int tileSize) {
+
+	std::shared_ptr<TiledImage> image;
+
+	if (isTiledTiff(filename)) {
+
+		try {
+
+			image = std::make_shared<TiffTiledImage>(filename);
+
+		} catch (std::exception& e) {
+
+			LOG_DEBUG(tiledimagelog) << "can not read " << filename << " tile by tile: " << e.what() << std::endl;
+		}
+	}
+
+	if (!image)
+		image = std::make_shared<InMemoryTiledImage>(filename, tileSize);
+
+	image->setIdentifier(filename);
+
+	return image;
+}
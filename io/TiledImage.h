@@ -0,0 +1,115 @@
+#ifndef TOOLS_IO_TILED_IMAGE_H__
+#define TOOLS_IO_TILED_IMAGE_H__
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <vigra/multi_array.hxx>
+
+/**
+ * A 2D image that is accessed in square tiles at several levels of a
+ * resolution pyramid. Level 0 is the full resolution, every following level
+ * halves the width and height, until the image fits into a single tile.
+ *
+ * Subclasses provide the tiles of the levels they store. All other tiles are
+ * created on the fly by averaging the four tiles of the level below. Tiles are
+ * kept in a cache of bounded size.
+ */
+class TiledImage {
+
+public:
+
+	typedef vigra::MultiArray<2, float> Tile;
+
+	/**
+	 * @param maxCachedTiles
+	 *              The number of tiles to keep in memory.
+	 */
+	TiledImage(size_t maxCachedTiles = 1024);
+
+	virtual ~TiledImage() {}
+
+	unsigned int getTileSize() const { return _tileSize; }
+
+	unsigned int getNumLevels() const { return _widths.size(); }
+
+	unsigned int width(unsigned int level = 0) const { return _widths[level]; }
+	unsigned int height(unsigned int level = 0) const { return _heights[level]; }
+
+	unsigned int numTilesX(unsigned int level) const { return (_widths[level] + _tileSize - 1)/_tileSize; }
+	unsigned int numTilesY(unsigned int level) const { return (_heights[level] + _tileSize - 1)/_tileSize; }
+
+	/**
+	 * Get a tile. Tiles at the right and bottom border of the image can be
+	 * smaller than the tile size. Can be called concurrently from several
+	 * threads.
+	 */
+	std::shared_ptr<Tile> getTile(unsigned int level, unsigned int x, unsigned int y);
+
+	/**
+	 * Set the identifier of the image, usually the filename.
+	 */
+	void setIdentifier(const std::string& identifier) { _identifier = identifier; }
+
+	const std::string& getIdentifier() const { return _identifier; }
+
+protected:
+
+	/**
+	 * Set the size of the image at full resolution and the width and height
+	 * of the tiles. Has to be called by subclasses before tiles are accessed.
+	 */
+	void setGeometry(unsigned int width, unsigned int height, unsigned int tileSize);
+
+	/**
+	 * Read a tile of the given level. Return an empty pointer for levels that
+	 * are not stored, those will be created from the level below.
+	 */
+	virtual std::shared_ptr<Tile> readTile(unsigned int level, unsigned int x, unsigned int y) = 0;
+
+	/**
+	 * The shape of a tile, considering the image border.
+	 */
+	vigra::Shape2 getTileShape(unsigned int level, unsigned int x, unsigned int y) const;
+
+private:
+
+	typedef std::tuple<unsigned int, unsigned int, unsigned int> TileId;
+
+	std::shared_ptr<Tile> downsampleTile(unsigned int level, unsigned int x, unsigned int y);
+
+	unsigned int _tileSize;
+
+	std::vector<unsigned int> _widths;
+	std::vector<unsigned int> _heights;
+
+	std::string _identifier;
+
+	size_t _maxCachedTiles;
+
+	// cached tiles, most recently used first
+	std::list<TileId> _lru;
+
+	std::map<TileId, std::pair<std::shared_ptr<Tile>, std::list<TileId>::iterator>> _tiles;
+
+	std::mutex _mutex;
+};
+
+/**
+ * Open an image for tiled access. Tiled TIFF images are read one tile at a
+ * time, using the pyramid levels stored in the file if there are any. All
+ * other images are read completely into memory.
+ */
+std::shared_ptr<TiledImage> openTiledImage(const std::string& filename, unsigned int tileSize = 256);
+
+/**
+ * True, if the file is a TIFF image that stores its data in tiles.
+ */
+bool isTiledTiff(const std::string& filename);
+
+#endif // TOOLS_IO_TILED_IMAGE_H__
+
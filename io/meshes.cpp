@@ -0,0 +1,279 @@
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <util/exceptions.h>
+#include "meshes.h"
+
+MeshFormat
+getMeshFormat(const std::string& name) {
+
+	if (name == "ply")
+		return MeshPly;
+	if (name == "obj")
+		return MeshObj;
+	if (name == "glb")
+		return MeshGlb;
+
+	UTIL_THROW_EXCEPTION(
+			UsageError,
+			"unknown mesh format " << name << ", expected ply, obj, or glb");
+}
+
+std::string
+getMeshExtension(MeshFormat format) {
+
+	switch (format) {
+
+		case MeshPly:
+			return ".ply";
+
+		case MeshObj:
+			return ".obj";
+
+		default:
+			return ".glb";
+	}
+}
+
+void
+writeMesh(const TriangleMesh& mesh, const std::string& filename, MeshFormat format) {
+
+	switch (format) {
+
+		case MeshPly:
+			writePly(mesh, filename);
+			break;
+
+		case MeshObj:
+			writeObj(mesh, filename);
+			break;
+
+		default:
+			writeGlb(mesh, filename);
+	}
+}
+
+static void
+openForWriting(std::ofstream& file, const std::string& filename) {
+
+	file.open(filename.c_str(), std::ios::binary);
+
+	if (!file.good())
+		UTIL_THROW_EXCEPTION(
+				IOError,
+				"can not write " << filename);
+}
+
+// PLY and glTF are little endian, as are the architectures this runs on, such
+// that the arrays can be written as they are in memory
+template <typename T>
+static void
+writeArray(std::ofstream& file, const std::vector<T>& values) {
+
+	file.write(reinterpret_cast<const char*>(values.data()), values.size()*sizeof(T));
+}
+
+void
+writePly(const TriangleMesh& mesh, const std::string& filename) {
+
+	std::ofstream file;
+	openForWriting(file, filename);
+
+	size_t numVertices = mesh.numVertices();
+	bool   withNormals = (mesh.normals.size() == mesh.vertices.size());
+
+	file
+			<< "ply\n"
+			<< "format binary_little_endian 1.0\n"
+			<< "element vertex " << numVertices << "\n"
+			<< "property float x\n"
+			<< "property float y\n"
+			<< "property float z\n";
+
+	if (withNormals)
+		file
+				<< "property float nx\n"
+				<< "property float ny\n"
+				<< "property float nz\n";
+
+	file
+			<< "element face " << mesh.numTriangles() << "\n"
+			<< "property list uchar uint vertex_indices\n"
+			<< "end_header\n";
+
+	// interleave vertices and normals
+	std::vector<float> vertices;
+	vertices.reserve(numVertices*(withNormals ? 6 : 3));
+
+	for (size_t i = 0; i < numVertices; i++) {
+
+		vertices.insert(vertices.end(), &mesh.vertices[3*i], &mesh.vertices[3*i] + 3);
+		if (withNormals)
+			vertices.insert(vertices.end(), &mesh.normals[3*i], &mesh.normals[3*i] + 3);
+	}
+
+	writeArray(file, vertices);
+
+	// each face is a count byte followed by three indices
+	std::vector<char> faces(mesh.numTriangles()*(1 + 3*sizeof(uint32_t)));
+
+	for (size_t i = 0; i < mesh.numTriangles(); i++) {
+
+		char* face = &faces[i*(1 + 3*sizeof(uint32_t))];
+		face[0] = 3;
+		std::copy(
+				reinterpret_cast<const char*>(&mesh.triangles[3*i]),
+				reinterpret_cast<const char*>(&mesh.triangles[3*i] + 3),
+				face + 1);
+	}
+
+	writeArray(file, faces);
+
+	if (!file.good())
+		UTIL_THROW_EXCEPTION(
+				IOError,
+				"error while writing " << filename);
+}
+
+void
+writeObj(const TriangleMesh& mesh, const std::string& filename) {
+
+	std::ofstream file;
+	openForWriting(file, filename);
+
+	bool withNormals = (mesh.normals.size() == mesh.vertices.size());
+
+	// format into a buffer, streaming single values is slow
+	std::stringstream out;
+	out.precision(std::numeric_limits<float>::digits10 + 2);
+
+	for (size_t i = 0; i < mesh.numVertices(); i++)
+		out << "v " << mesh.vertices[3*i] << " " << mesh.vertices[3*i + 1] << " " << mesh.vertices[3*i + 2] << "\n";
+
+	if (withNormals)
+		for (size_t i = 0; i < mesh.numVertices(); i++)
+			out << "vn " << mesh.normals[3*i] << " " << mesh.normals[3*i + 1] << " " << mesh.normals[3*i + 2] << "\n";
+
+	// OBJ indices start at 1
+	for (size_t i = 0; i < mesh.numTriangles(); i++) {
+
+		out << "f";
+		for (int j = 0; j < 3; j++) {
+
+			uint32_t v = mesh.triangles[3*i + j] + 1;
+
+			if (withNormals)
+				out << " " << v << "//" << v;
+			else
+				out << " " << v;
+		}
+		out << "\n";
+	}
+
+	file << out.rdbuf();
+
+	if (!file.good())
+		UTIL_THROW_EXCEPTION(
+				IOError,
+				"error while writing " << filename);
+}
+
+static std::string
+quoteJson(const std::string& s) {
+
+	std::string quoted = "\"";
+	for (char c : s) {
+
+		if (c == '"' || c == '\\')
+			quoted += '\\';
+		quoted += c;
+	}
+
+	return quoted + "\"";
+}
+
+void
+writeGlb(const TriangleMesh& mesh, const std::string& filename, const std::string& name) {
+
+	std::ofstream file;
+	openForWriting(file, filename);
+
+	size_t numVertices  = mesh.numVertices();
+	bool   withNormals  = (mesh.normals.size() == mesh.vertices.size());
+	size_t vertexBytes  = mesh.vertices.size()*sizeof(float);
+	size_t normalBytes  = (withNormals ? vertexBytes : 0);
+	size_t indexBytes   = mesh.triangles.size()*sizeof(uint32_t);
+	size_t binaryLength = vertexBytes + normalBytes + indexBytes;
+
+	// glTF requires bounds for the positions
+	float min[3] = {0, 0, 0};
+	float max[3] = {0, 0, 0};
+
+	for (int d = 0; d < 3; d++)
+		for (size_t i = 0; i < numVertices; i++) {
+
+			float x = mesh.vertices[3*i + d];
+			min[d] = (i == 0 ? x : std::min(min[d], x));
+			max[d] = (i == 0 ? x : std::max(max[d], x));
+		}
+
+	std::stringstream json;
+	json.precision(std::numeric_limits<float>::digits10 + 2);
+
+	json
+			<< "{\"asset\":{\"version\":\"2.0\",\"generator\":\"tools\"},"
+			<< "\"scene\":0,\"scenes\":[{\"nodes\":[0]}],"
+			<< "\"nodes\":[{\"mesh\":0,\"name\":" << quoteJson(name) << "}],"
+			<< "\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0"
+			<< (withNormals ? ",\"NORMAL\":2" : "") << "},\"indices\":1}]}],"
+			<< "\"buffers\":[{\"byteLength\":" << binaryLength << "}],"
+			<< "\"bufferViews\":["
+			<< "{\"buffer\":0,\"byteOffset\":0,\"byteLength\":" << vertexBytes << ",\"target\":34962},"
+			<< "{\"buffer\":0,\"byteOffset\":" << vertexBytes + normalBytes << ",\"byteLength\":" << indexBytes << ",\"target\":34963}"
+			<< (withNormals ? "," : "");
+
+	if (withNormals)
+		json << "{\"buffer\":0,\"byteOffset\":" << vertexBytes << ",\"byteLength\":" << normalBytes << ",\"target\":34962}";
+
+	json
+			<< "],"
+			<< "\"accessors\":["
+			<< "{\"bufferView\":0,\"componentType\":5126,\"count\":" << numVertices << ",\"type\":\"VEC3\","
+			<< "\"min\":[" << min[0] << "," << min[1] << "," << min[2] << "],"
+			<< "\"max\":[" << max[0] << "," << max[1] << "," << max[2] << "]},"
+			<< "{\"bufferView\":1,\"componentType\":5125,\"count\":" << mesh.triangles.size() << ",\"type\":\"SCALAR\"}"
+			<< (withNormals ? "," : "");
+
+	if (withNormals)
+		json << "{\"bufferView\":2,\"componentType\":5126,\"count\":" << numVertices << ",\"type\":\"VEC3\"}";
+
+	json << "]}";
+
+	// chunks have to be aligned to four bytes, JSON is padded with spaces
+	std::string header = json.str();
+	while (header.size() % 4 != 0)
+		header += ' ';
+
+	// the binary data consists of floats and ints, already aligned
+	uint32_t jsonLength  = header.size();
+	uint32_t totalLength = 12 + 8 + jsonLength + 8 + binaryLength;
+
+	uint32_t glbHeader[3] = { 0x46546C67 /* glTF */, 2, totalLength };
+	uint32_t jsonChunk[2] = { jsonLength, 0x4E4F534A /* JSON */ };
+	uint32_t binChunk[2]  = { (uint32_t)binaryLength, 0x004E4942 /* BIN */ };
+
+	file.write(reinterpret_cast<const char*>(glbHeader), sizeof(glbHeader));
+	file.write(reinterpret_cast<const char*>(jsonChunk), sizeof(jsonChunk));
+	file.write(header.data(), header.size());
+	file.write(reinterpret_cast<const char*>(binChunk), sizeof(binChunk));
+	writeArray(file, mesh.vertices);
+	if (withNormals)
+		writeArray(file, mesh.normals);
+	writeArray(file, mesh.triangles);
+
+	if (!file.good())
+		UTIL_THROW_EXCEPTION(
+				IOError,
+				"error while writing " << filename);
+}
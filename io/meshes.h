@@ -0,0 +1,62 @@
+#ifndef TOOLS_IO_MESHES_H__
+#define TOOLS_IO_MESHES_H__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * A triangle mesh as plain arrays, ready to be written to disk.
+ */
+struct TriangleMesh {
+
+	// x, y, z of each vertex
+	std::vector<float> vertices;
+
+	// x, y, z of the normal of each vertex
+	std::vector<float> normals;
+
+	// three vertex indices per triangle, counter-clockwise seen from the
+	// outside
+	std::vector<uint32_t> triangles;
+
+	size_t numVertices() const { return vertices.size()/3; }
+
+	size_t numTriangles() const { return triangles.size()/3; }
+};
+
+enum MeshFormat {
+
+	MeshPly,
+	MeshObj,
+	MeshGlb
+};
+
+/**
+ * Get the mesh format from its name ('ply', 'obj', or 'glb'). Throws a
+ * UsageError for unknown names.
+ */
+MeshFormat getMeshFormat(const std::string& name);
+
+/**
+ * The file extension for a mesh format, including the dot.
+ */
+std::string getMeshExtension(MeshFormat format);
+
+/**
+ * Write a mesh as binary PLY, Wavefront OBJ, or binary glTF.
+ */
+void writeMesh(const TriangleMesh& mesh, const std::string& filename, MeshFormat format);
+
+void writePly(const TriangleMesh& mesh, const std::string& filename);
+
+void writeObj(const TriangleMesh& mesh, const std::string& filename);
+
+/**
+ * Write a binary glTF file with a single mesh. The node of the mesh gets the
+ * given name.
+ */
+void writeGlb(const TriangleMesh& mesh, const std::string& filename, const std::string& name = "mesh");
+
+#endif // TOOLS_IO_MESHES_H__
+
@@ -2,38 +2,47 @@
 #define TOOLS_IO_SKELETONS_H__
 
 #include <fstream>
+#include <limits>
 #include <boost/filesystem.hpp>
 #include <imageprocessing/Skeleton.h>
+#include <util/box.hpp>
 #include <util/Logger.h>
+#include <util/exceptions.h>
 
-// returns the minumal number of times to multiply the given values by 10 such that all of them are integer
-int getMaxPrecision(const std::vector<float>& values) {
+// returns the factor to map values in [min, max] to unsigned integers, such
+// that the whole range of unsigned int is used
+double getQuantizationFactor(float min, float max) {
 
-	int maxPrecision = 0;
+	double range = (double)max - min;
 
-	for (float v : values) {
+	if (range <= 0)
+		return 1.0;
 
-		int precision = 0;
-		double _;
-		while (modf(v, &_) > 0.0001) {
-
-			precision++;
-			v *= 10;
-		}
-
-		maxPrecision = std::max(precision, maxPrecision);
-	}
-
-	return maxPrecision;
+	// a bit less than the maximal unsigned int, to stay in range after rounding
+	return 4294967040.0/range;
 }
 
-uint64_t readSkeleton(const std::string& filename, Skeleton& skeleton) {
+/**
+ * Read a skeleton in the ITK graph format. If a region of interest is given, 
+ * only nodes inside of it and edges between them are kept. Throws an IOError 
+ * if the file can not be opened or has no POINTS section.
+ */
+uint64_t readSkeleton(const std::string& filename, Skeleton& skeleton, const util::box<float,3>* roi = 0) {
 
 	std::ifstream file(filename);
 
+	if (!file.is_open())
+		UTIL_THROW_EXCEPTION(
+				IOError,
+				"can not open " << filename);
+
 	std::string token;
 	int numNodes = 0;
 	uint64_t id = 1;
+	bool havePoints = false;
+
+	// the skeleton nodes by their index in the file, invalid if clipped
+	std::vector<Skeleton::Node> nodes;
 
 	while (file.good()) {
 
@@ -50,13 +59,21 @@ uint64_t readSkeleton(const std::string& filename, Skeleton& skeleton) {
 
 		if (token == "POINTS") {
 
+			havePoints = true;
+
 			file >> numNodes;
 
 			std::string type;
 			file >> type;
 
+			if (!file.good() || numNodes < 0)
+				UTIL_THROW_EXCEPTION(
+						IOError,
+						"invalid POINTS section in " << filename);
+
 			// read the real-valued coordinates
 			std::vector<float> xs, ys, zs;
+			std::vector<bool>  clipped;
 			for (int i = 0; i < numNodes; i++) {
 
 				float x, y, z;
@@ -64,35 +81,59 @@ uint64_t readSkeleton(const std::string& filename, Skeleton& skeleton) {
 				file >> y;
 				file >> z;
 
+				bool inside = (!roi || roi->contains(util::point<float,3>(x, y, z)));
+				clipped.push_back(!inside);
+
+				if (!inside)
+					continue;
+
 				xs.push_back(x);
 				ys.push_back(y);
 				zs.push_back(z);
 			}
 
-			// get the maximal precision of each axis
-			int precisionX = getMaxPrecision(xs);
-			int precisionY = getMaxPrecision(ys);
-			int precisionZ = getMaxPrecision(zs);
-
-			int fx = pow(10, precisionX);
-			int fy = pow(10, precisionY);
-			int fz = pow(10, precisionZ);
+			if (xs.size() == 0) {
 
-			skeleton.setResolution(1.0/fx, 1.0/fy, 1.0/fz);
+				LOG_USER(logger::out) << "no nodes of " << filename << " in region of interest" << std::endl;
+				continue;
+			}
 
-			// get minimal point
+			// get minimal and maximal point
 			float minX = *std::min_element(xs.begin(), xs.end());
 			float minY = *std::min_element(ys.begin(), ys.end());
 			float minZ = *std::min_element(zs.begin(), zs.end());
+			float maxX = *std::max_element(xs.begin(), xs.end());
+			float maxY = *std::max_element(ys.begin(), ys.end());
+			float maxZ = *std::max_element(zs.begin(), zs.end());
+
+			// the skeleton stores integer positions, use the full range of
+			// them for the extent of the nodes on each axis, such that the
+			// quantization error stays below the precision of the float
+			// coordinates
+			double fx = getQuantizationFactor(minX, maxX);
+			double fy = getQuantizationFactor(minY, maxY);
+			double fz = getQuantizationFactor(minZ, maxZ);
 
+			skeleton.setResolution(1.0/fx, 1.0/fy, 1.0/fz);
 			skeleton.setOffset(minX, minY, minZ);
 
-			for (int i = 0; i < numNodes; i++) {
+			nodes.resize(numNodes, lemon::INVALID);
+
+			for (int i = 0, j = 0; i < numNodes; i++) {
+
+				if (clipped[i])
+					continue;
 
 				auto n = skeleton.graph().addNode();
-				skeleton.positions()[n] = util::point<unsigned int,3>((xs[i] - minX)*fx, (ys[i] - minY)*fy, (zs[i] - minZ)*fz);
+				skeleton.positions()[n] = util::point<unsigned int,3>(
+						(xs[j] - minX)*fx + 0.5,
+						(ys[j] - minY)*fy + 0.5,
+						(zs[j] - minZ)*fz + 0.5);
+				nodes[i] = n;
 
-				LOG_ALL(logger::out) << "setting position of node " << i << " to " << util::point<unsigned int,3>(xs[i]*fx, ys[i]*fy, zs[i]*fz) << std::endl;
+				LOG_ALL(logger::out) << "setting position of node " << i << " to " << util::point<float,3>(xs[j], ys[j], zs[j]) << std::endl;
+
+				j++;
 			}
 		}
 
@@ -107,7 +148,11 @@ uint64_t readSkeleton(const std::string& filename, Skeleton& skeleton) {
 				file >> u;
 				file >> v;
 
-				skeleton.graph().addEdge(skeleton.graph().nodeFromId(u), skeleton.graph().nodeFromId(v));
+				if (u >= (int)nodes.size() || v >= (int)nodes.size() ||
+				    nodes[u] == lemon::INVALID || nodes[v] == lemon::INVALID)
+					continue;
+
+				skeleton.graph().addEdge(nodes[u], nodes[v]);
 
 				LOG_ALL(logger::out) << "adding edge between " << u << " and " << v << std::endl;
 			}
@@ -124,18 +169,75 @@ uint64_t readSkeleton(const std::string& filename, Skeleton& skeleton) {
 
 				double diameter;
 				file >> diameter;
-				skeleton.diameters()[skeleton.graph().nodeFromId(i)] = diameter;
+
+				if (i >= (int)nodes.size() || nodes[i] == lemon::INVALID)
+					continue;
+
+				skeleton.diameters()[nodes[i]] = diameter;
 
 				LOG_ALL(logger::out) << "setting diameter of node " << i << " to " << diameter << std::endl;
 			}
 		}
 	}
 
-	LOG_USER(logger::out) << "read skeleton with " << numNodes << " nodes" << std::endl;
+	if (!havePoints)
+		UTIL_THROW_EXCEPTION(
+				IOError,
+				filename << " is not a skeleton in the ITK graph format, it has no POINTS");
+
+	LOG_USER(logger::out) << "read skeleton with " << lemon::countNodes(skeleton.graph()) << " nodes" << std::endl;
 
 	return id;
 }
 
+/**
+ * Write a skeleton in the ITK graph format, as understood by readSkeleton().
+ */
+void writeSkeleton(const std::string& filename, const Skeleton& skeleton, uint64_t id) {
+
+	std::ofstream file(filename);
+
+	if (!file.good())
+		UTIL_THROW_EXCEPTION(
+				IOError,
+				"can not write " << filename);
+
+	file.precision(std::numeric_limits<float>::digits10 + 2);
+
+	int numNodes = lemon::countNodes(skeleton.graph());
+	int numEdges = lemon::countEdges(skeleton.graph());
+
+	Skeleton::Graph::NodeMap<int> indices(skeleton.graph());
+
+	file << "ID " << id << "\n";
+	file << "POINTS " << numNodes << " float\n";
+
+	int i = 0;
+	for (Skeleton::Graph::NodeIt n(skeleton.graph()); n != lemon::INVALID; ++n) {
+
+		util::point<float,3> p;
+		skeleton.getRealLocation(skeleton.positions()[n], p);
+
+		file << p.x() << " " << p.y() << " " << p.z() << "\n";
+		indices[n] = i++;
+	}
+
+	file << "EDGES " << numEdges << "\n";
+
+	for (Skeleton::Graph::EdgeIt e(skeleton.graph()); e != lemon::INVALID; ++e)
+		file << indices[skeleton.graph().u(e)] << " " << indices[skeleton.graph().v(e)] << "\n";
+
+	file << "diameters 1 " << numNodes << " float\n";
+
+	for (Skeleton::Graph::NodeIt n(skeleton.graph()); n != lemon::INVALID; ++n)
+		file << skeleton.diameters()[n] << "\n";
+
+	if (!file.good())
+		UTIL_THROW_EXCEPTION(
+				IOError,
+				"error while writing " << filename);
+}
+
 std::vector<std::shared_ptr<SkeletonEdgeMatchScores>>
 readEdgeMatchScores(const std::vector<std::string>& filenames) {
 
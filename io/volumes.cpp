@@ -1,3 +1,4 @@
+#include <cmath>
 #include <boost/filesystem.hpp>
 #include <util/Logger.h>
 #include "volumes.h"
@@ -36,3 +37,111 @@ getImageFiles(std::string path) {
 
 	return filenames;
 }
+
+void
+readImage(const std::string& filename, Image& image) {
+
+	try {
+
+		vigra::ImageImportInfo info(filename.c_str());
+		image.reshape(vigra::Shape2(info.width(), info.height()));
+		importImage(info, image);
+
+		if (std::string(info.getPixelType()) == "UINT8")
+			image *= 1.0/255.0;
+
+	} catch (std::exception& e) {
+
+		UTIL_THROW_EXCEPTION(
+				IOError,
+				"error reading " << filename << ": " << e.what());
+	}
+
+	image.setIdentifiyer(filename);
+}
+
+VoxelType
+getVoxelType(std::string pixelType) {
+
+	if (pixelType == "UINT8")
+		return VoxelUint8;
+	if (pixelType == "UINT16")
+		return VoxelUint16;
+
+	return VoxelFloat;
+}
+
+VoxelType
+getVoxelType(const std::vector<std::string>& filenames) {
+
+	if (filenames.size() == 0)
+		return VoxelFloat;
+
+	vigra::ImageImportInfo info(filenames[0].c_str());
+
+	return getVoxelType(info.getPixelType());
+}
+
+void
+getDiscreteRoi(
+		const util::box<float,3>&   roi,
+		const vigra::Shape3&        size,
+		const util::point<float,3>& resolution,
+		const util::point<float,3>& offset,
+		vigra::Shape3&              begin,
+		vigra::Shape3&              shape) {
+
+	float roiMin[3] = { roi.min().x(), roi.min().y(), roi.min().z() };
+	float roiMax[3] = { roi.max().x(), roi.max().y(), roi.max().z() };
+	float res[3]    = { resolution.x(), resolution.y(), resolution.z() };
+	float off[3]    = { offset.x(), offset.y(), offset.z() };
+
+	for (int d = 0; d < 3; d++) {
+
+		// in double, to survive unbounded regions
+		double b = std::floor((roiMin[d] - off[d])/res[d]);
+		double e = std::ceil((roiMax[d] - off[d])/res[d]);
+
+		b = std::min(std::max(b, 0.0), (double)size[d]);
+		e = std::min(std::max(e, b), (double)size[d]);
+
+		begin[d] = b;
+		shape[d] = e - b;
+	}
+
+	if (shape[0] == 0 || shape[1] == 0 || shape[2] == 0)
+		UTIL_THROW_EXCEPTION(
+				IOError,
+				"region of interest " << roi << " does not intersect with volume");
+}
+
+bool
+getHdf5Target(const std::string& target, std::string& file, std::string& dataset) {
+
+	auto isHdf5 = [](const boost::filesystem::path& path) {
+
+		return
+				path.extension() == ".h5" ||
+				path.extension() == ".hdf" ||
+				path.extension() == ".hdf5";
+	};
+
+	size_t sepPos = target.find_last_of(":");
+	if (sepPos != std::string::npos && isHdf5(target.substr(0, sepPos))) {
+
+		file    = target.substr(0, sepPos);
+		dataset = target.substr(sepPos + 1);
+
+		return true;
+	}
+
+	if (isHdf5(target)) {
+
+		file    = target;
+		dataset = "volume";
+
+		return true;
+	}
+
+	return false;
+}
@@ -1,26 +1,34 @@
 #ifndef CANDIDATE_MC_IO_VOLUMES_H__
 #define CANDIDATE_MC_IO_VOLUMES_H__
 
+#include <type_traits>
 #include <boost/filesystem.hpp>
 #include <vigra/impex.hxx>
 #include <imageprocessing/ExplicitVolume.h>
+#include <imageprocessing/Image.h>
 #include <util/Logger.h>
 #include <util/exceptions.h>
+#include "Hdf5VolumeWriter.h"
+#include "ThreadPool.h"
 
+/**
+ * Read a stack of images into the given volume. The images are decoded
+ * directly into the storage of the volume, without intermediate copies.
+ */
 template <typename T>
-ExplicitVolume<T> readVolume(std::vector<std::string> filenames) {
+void readVolume(ExplicitVolume<T>& volume, std::vector<std::string> filenames) {
 
 	if (filenames.size() == 0) {
 
 		LOG_ERROR(logger::out) << "no files" << std::endl;
-		return ExplicitVolume<T>();
+		return;
 	}
 
 	int depth = filenames.size();
 
 	std::string filename = filenames[0];
 	vigra::ImageImportInfo info = vigra::ImageImportInfo(filename.c_str());
-	ExplicitVolume<T> volume(info.width(), info.height(), depth);
+	volume.data().reshape(vigra::Shape3(info.width(), info.height(), depth));
 
 	for (int z = 0; z < depth; z++) {
 
@@ -29,15 +37,12 @@ ExplicitVolume<T> readVolume(std::vector<std::string> filenames) {
 			vigra::ImageImportInfo info = vigra::ImageImportInfo(filenames[z].c_str());
 			importImage(info, volume.data().template bind<2>(z));
 
-			std::cout << "pixel type of " << filenames[z] << " is " << info.getPixelType() << std::endl;
-			T min, max;
-			volume.data().template bind<2>(z).minmax(&min, &max);
-			std::cout << "min/max of " << filenames[z] << " is " << min << "/" << max << std::endl;
-			if (std::string(info.getPixelType()) == "UINT8")
-				volume.data().template bind<2>(z) *= 1.0/255.0;
+			LOG_DEBUG(logger::out) << "pixel type of " << filenames[z] << " is " << info.getPixelType() << std::endl;
 
-			volume.data().template bind<2>(z).minmax(&min, &max);
-			std::cout << "after normalizing, min/max of " << filenames[z] << " is " << min << "/" << max << std::endl;
+			// keep integer volumes in their native range, normalize 8 bit 
+			// images only if read into floating point volumes
+			if (std::is_floating_point<T>::value && std::string(info.getPixelType()) == "UINT8")
+				volume.data().template bind<2>(z) *= 1.0/255.0;
 
 		} catch (std::exception& e) {
 
@@ -46,15 +51,193 @@ ExplicitVolume<T> readVolume(std::vector<std::string> filenames) {
 					"error reading " << filenames[z] << ": " << e.what());
 		}
 	}
+}
+
+template <typename T>
+ExplicitVolume<T> readVolume(std::vector<std::string> filenames) {
+
+	ExplicitVolume<T> volume;
+	readVolume(volume, filenames);
+
+	return volume;
+}
+
+/**
+ * Convert a region of interest in world units into the offset and shape of a
+ * block of voxels, for a volume of the given size, resolution, and offset.
+ * The block is clipped to the volume.
+ */
+void
+getDiscreteRoi(
+		const util::box<float,3>&   roi,
+		const vigra::Shape3&        size,
+		const util::point<float,3>& resolution,
+		const util::point<float,3>& offset,
+		vigra::Shape3&              begin,
+		vigra::Shape3&              shape);
+
+/**
+ * Read a block of a stack of images into the given volume, given by the 
+ * offset and shape in voxels. Only the images of the sections inside the 
+ * block are read. If the block spans whole images, they are decoded directly 
+ * into the storage of the volume.
+ */
+template <typename T>
+void readVolume(
+		ExplicitVolume<T>& volume,
+		std::vector<std::string> filenames,
+		const vigra::Shape3& begin,
+		const vigra::Shape3& shape) {
+
+	volume.data().reshape(shape);
+	vigra::MultiArray<2, T> image;
+
+	for (int z = 0; z < shape[2]; z++) {
+
+		const std::string& filename = filenames[begin[2] + z];
+
+		try {
+
+			vigra::ImageImportInfo info = vigra::ImageImportInfo(filename.c_str());
+
+			bool whole =
+					begin[0] == 0 && shape[0] == info.width() &&
+					begin[1] == 0 && shape[1] == info.height();
+
+			if (whole) {
+
+				importImage(info, volume.data().template bind<2>(z));
+
+			} else {
+
+				image.reshape(vigra::Shape2(info.width(), info.height()));
+				importImage(info, image);
+
+				volume.data().template bind<2>(z) = image.subarray(
+						vigra::Shape2(begin[0], begin[1]),
+						vigra::Shape2(begin[0] + shape[0], begin[1] + shape[1]));
+			}
+
+			if (std::is_floating_point<T>::value && std::string(info.getPixelType()) == "UINT8")
+				volume.data().template bind<2>(z) *= 1.0/255.0;
+
+		} catch (std::exception& e) {
+
+			UTIL_THROW_EXCEPTION(
+					IOError,
+					"error reading " << filename << ": " << e.what());
+		}
+	}
+}
+
+template <typename T>
+ExplicitVolume<T> readVolume(
+		std::vector<std::string> filenames,
+		const vigra::Shape3& begin,
+		const vigra::Shape3& shape) {
+
+	ExplicitVolume<T> volume;
+	readVolume(volume, filenames, begin, shape);
+
+	return volume;
+}
+
+/**
+ * Read the part of a stack of images that intersects the given region of
+ * interest in world units into the given volume.
+ */
+template <typename T>
+void readVolume(
+		ExplicitVolume<T>& volume,
+		std::vector<std::string> filenames,
+		const util::box<float,3>& roi,
+		const util::point<float,3>& resolution) {
+
+	if (filenames.size() == 0) {
+
+		LOG_ERROR(logger::out) << "no files" << std::endl;
+		return;
+	}
+
+	vigra::ImageImportInfo info = vigra::ImageImportInfo(filenames[0].c_str());
+
+	vigra::Shape3 begin, shape;
+	getDiscreteRoi(
+			roi,
+			vigra::Shape3(info.width(), info.height(), filenames.size()),
+			resolution,
+			util::point<float,3>(0, 0, 0),
+			begin,
+			shape);
+
+	readVolume(volume, filenames, begin, shape);
+	volume.setResolution(resolution.x(), resolution.y(), resolution.z());
+	volume.setOffset(
+			begin[0]*resolution.x(),
+			begin[1]*resolution.y(),
+			begin[2]*resolution.z());
+}
+
+template <typename T>
+ExplicitVolume<T> readVolume(
+		std::vector<std::string> filenames,
+		const util::box<float,3>& roi,
+		const util::point<float,3>& resolution) {
+
+	ExplicitVolume<T> volume;
+	readVolume(volume, filenames, roi, resolution);
 
 	return volume;
 }
 
+/**
+ * Split a target of the form <hdf_file>:<dataset>, or an HDF5 file name (with
+ * extension .h5, .hdf, or .hdf5, for the dataset "volume"). Returns false if
+ * the target is not an HDF5 file.
+ */
+bool
+getHdf5Target(const std::string& target, std::string& file, std::string& dataset);
+
+/**
+ * Save a volume as a sequence of TIFF images in the given directory, or as a
+ * chunked HDF5 dataset if the target is of the form <hdf_file>:<dataset> or
+ * names an HDF5 file (see getHdf5Target()). Slices (or chunks) are written in
+ * parallel.
+ *
+ * @param compression
+ *              The TIFF compression to use, one of "LZW", "DEFLATE", or 
+ *              "PACKBITS". Empty for uncompressed images. HDF5 datasets are
+ *              deflated if any compression is given.
+ * @param numThreads
+ *              The number of threads to write with, 0 for one per core.
+ */
 template <typename T>
-void saveVolume(const ExplicitVolume<T>& volume, std::string directory) {
+void saveVolume(
+		const ExplicitVolume<T>& volume,
+		std::string directory,
+		std::string compression = "",
+		unsigned int numThreads = 0) {
+
+	std::string hdfFileName, dataset;
+	if (getHdf5Target(directory, hdfFileName, dataset)) {
+
+		vigra::HDF5File file(hdfFileName, vigra::HDF5File::OpenMode::Open);
+		Hdf5VolumeWriter hdfWriter(file);
+
+		hdfWriter.writeVolume(
+				volume,
+				dataset,
+				compression.empty() ? 0 : 6,
+				Hdf5VolumeWriter::getDefaultChunkShape(volume.data().shape()),
+				numThreads);
+
+		return;
+	}
 
 	boost::filesystem::create_directory(directory);
 
+	ThreadPool pool(numThreads);
+
 	for (int z = 0; z < volume.getDiscreteBoundingBox().depth(); z++) {
 
 		std::stringstream number;
@@ -63,14 +246,53 @@ void saveVolume(const ExplicitVolume<T>& volume, std::string directory) {
 
 		std::string filename = directory + "/slice_" + number.str() + ".tif";
 
-		vigra::exportImage(
-				volume.data().template bind<2>(z),
-				vigra::ImageExportInfo(filename.c_str()));
+		pool.schedule([&volume, filename, compression, z]() {
+
+			vigra::ImageExportInfo info(filename.c_str());
+
+			if (!compression.empty())
+				info.setCompression(compression.c_str());
+
+			vigra::exportImage(volume.data().template bind<2>(z), info);
+		});
 	}
+
+	// rethrows the first failure of a writer
+	pool.wait();
 }
 
 std::vector<std::string>
 getImageFiles(std::string path);
 
+/**
+ * Read a single image as float. 8 bit images are normalized to [0,1], like
+ * readVolume() does for float volumes.
+ */
+void
+readImage(const std::string& filename, Image& image);
+
+/**
+ * The voxel types raw volumes are kept in without conversion. All other pixel 
+ * types are read as float.
+ */
+enum VoxelType {
+
+	VoxelUint8,
+	VoxelUint16,
+	VoxelFloat
+};
+
+/**
+ * Get the voxel type for a vigra pixel type string (like "UINT8").
+ */
+VoxelType
+getVoxelType(std::string pixelType);
+
+/**
+ * Get the voxel type of a volume stored as a sequence of images.
+ */
+VoxelType
+getVoxelType(const std::vector<std::string>& filenames);
+
 #endif // CANDIDATE_MC_IO_VOLUMES_H__
 